@@ -756,11 +756,10 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
         if (packet.start_index == 0)
         {
             // New home at wp index 0. Ask for it
-            waypoint_receiving = true;
-            waypoint_request_i = 0;
-            waypoint_request_last = 0;
+            waypoint_dest_sysid = msg->sysid;
+            waypoint_dest_compid = msg->compid;
+            mission_upload_start(0, 1);
             send_message(MSG_NEXT_WAYPOINT);
-            waypoint_receiving = true;
         }
         break;
     }
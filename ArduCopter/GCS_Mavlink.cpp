@@ -1915,6 +1915,35 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
     }
 #endif // AC_RALLY == ENABLED
 
+#if AC_FENCE == ENABLED
+    // receive a polygon fence point from GCS. The stored fence is
+    // replaced once the last point of the upload arrives
+    case MAVLINK_MSG_ID_FENCE_POINT: {
+        mavlink_fence_point_t packet;
+        mavlink_msg_fence_point_decode(msg, &packet);
+        if (!copter.fence.polyfence().handle_point(packet.idx, packet.count, packet.lat, packet.lng)) {
+            send_text(MAV_SEVERITY_WARNING, "Bad fence point");
+        } else if (packet.idx+1 == packet.count) {
+            send_text(MAV_SEVERITY_INFO, "Fence stored");
+        }
+        break;
+    }
+
+    // send a polygon fence point to GCS
+    case MAVLINK_MSG_ID_FENCE_FETCH_POINT: {
+        mavlink_fence_fetch_point_t packet;
+        mavlink_msg_fence_fetch_point_decode(msg, &packet);
+        float lat, lng;
+        if (!copter.fence.polyfence().get_point(packet.idx, lat, lng)) {
+            send_text(MAV_SEVERITY_WARNING, "Bad fence point");
+            break;
+        }
+        mavlink_msg_fence_point_send_buf(msg, chan, msg->sysid, msg->compid, packet.idx,
+                                         copter.fence.polyfence().download_count(), lat, lng);
+        break;
+    }
+#endif // AC_FENCE == ENABLED
+
     case MAVLINK_MSG_ID_REMOTE_LOG_BLOCK_STATUS:
         copter.DataFlash.remote_log_block_status_msg(chan, msg);
         break;
@@ -410,8 +410,8 @@ bool Copter::pre_arm_gps_checks(bool display_failure)
     bool gps_required = mode_requires_GPS(control_mode);
 
     #if AC_FENCE == ENABLED
-    // if circular fence is enabled we need GPS
-    if ((fence.get_enabled_fences() & AC_FENCE_TYPE_CIRCLE) != 0) {
+    // if circular or polygon fence is enabled we need GPS
+    if ((fence.get_enabled_fences() & (AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON)) != 0) {
         gps_required = true;
     }
     #endif
@@ -98,6 +98,7 @@ void Copter::enable_motor_output()
 void Copter::read_radio()
 {
     static uint32_t last_update_ms = 0;
+    static uint64_t last_frame_us = 0;
     uint32_t tnow_ms = millis();
 
     if (hal.rcin->new_input()) {
@@ -115,9 +116,16 @@ void Copter::read_radio()
         // update output on any aux channels, for manual passthru
         RC_Channel_aux::output_ch_all();
 
+        // use the receiver's frame times where the HAL has them, so the
+        // filter sees the real frame spacing rather than when we polled
         float dt = (tnow_ms - last_update_ms)*1.0e-3f;
+        const uint64_t frame_us = hal.rcin->last_frame_us();
+        if (frame_us > last_frame_us && last_frame_us != 0) {
+            dt = (frame_us - last_frame_us)*1.0e-6f;
+        }
         rc_throttle_control_in_filter.apply(g.rc_3.control_in, dt);
         last_update_ms = tnow_ms;
+        last_frame_us = frame_us;
     }else{
         uint32_t elapsed = tnow_ms - last_update_ms;
         // turn on throttle failsafe if no update from the RC Radio for 500ms or 2000ms if we are using RC_OVERRIDE
@@ -0,0 +1,171 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+  compress and expand DataFlash .bin logs
+
+  LogCompress -c in.bin out.bin   compress a log
+  LogCompress -d in.bin out.bin   expand a compressed log
+  LogCompress -t in.bin           compress a log in memory and check it expands to the original
+ */
+
+#include <DataFlash/DFCompress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *read_file(const char *fname, long &len)
+{
+    FILE *f = fopen(fname, "rb");
+    if (f == NULL) {
+        perror(fname);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = (uint8_t *)malloc(len > 0 ? len : 1);
+    if (data == NULL || fread(data, 1, len, f) != (size_t)len) {
+        fprintf(stderr, "failed to read %s\n", fname);
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+/*
+  compress len bytes of raw log, appending to out
+ */
+static bool compress(const uint8_t *data, long len, FILE *out)
+{
+    DFCompress_Encoder encoder;
+    if (!encoder.init()) {
+        return false;
+    }
+    encoder.reset();
+    fwrite(DFCOMPRESS_FILE_MAGIC, 1, DFCOMPRESS_FILE_MAGIC_LEN, out);
+
+    long ofs = 0;
+    while (true) {
+        uint16_t n = (len - ofs) > 4096 ? 4096 : (uint16_t)(len - ofs);
+        ofs += encoder.encode(&data[ofs], n);
+        if (ofs == len) {
+            encoder.flush();
+        }
+        uint16_t plen;
+        const uint8_t *p = encoder.pending(plen);
+        if (p != NULL) {
+            fwrite(p, 1, plen, out);
+            encoder.consumed(plen);
+        } else if (ofs == len) {
+            break;
+        }
+    }
+    if (encoder.errors() != 0) {
+        fprintf(stderr, "skipped %u bytes not in a known message\n", (unsigned)encoder.errors());
+    }
+    return true;
+}
+
+/*
+  expand len bytes of compressed log, appending to out
+ */
+static bool expand(const uint8_t *data, long len, FILE *out)
+{
+    if (len < DFCOMPRESS_FILE_MAGIC_LEN ||
+        memcmp(data, DFCOMPRESS_FILE_MAGIC, DFCOMPRESS_FILE_MAGIC_LEN) != 0) {
+        fprintf(stderr, "not a compressed log\n");
+        return false;
+    }
+    DFCompress_Decoder *decoder = new DFCompress_Decoder();
+    if (!decoder->init()) {
+        delete decoder;
+        return false;
+    }
+    decoder->reset();
+
+    uint8_t decoded[DFCOMPRESS_BLOCK_MAX_DECODED];
+    long ofs = DFCOMPRESS_FILE_MAGIC_LEN;
+    unsigned damaged = 0;
+    long skipped = 0;
+    while (ofs + (long)sizeof(DFCompress_BlockHeader) <= len) {
+        DFCompress_BlockHeader hdr;
+        memcpy(&hdr, &data[ofs], sizeof(hdr));
+        if (!DFCompress_Model::header_ok(hdr) ||
+            ofs + (long)sizeof(hdr) + hdr.encoded_len > len) {
+            // scan for the next valid header
+            ofs++;
+            skipped++;
+            continue;
+        }
+        ofs += sizeof(hdr);
+        uint16_t decoded_len;
+        if (decoder->decode_block(hdr, &data[ofs], decoded, decoded_len)) {
+            fwrite(decoded, 1, decoded_len, out);
+        } else {
+            damaged++;
+        }
+        ofs += hdr.encoded_len;
+    }
+    delete decoder;
+    if (damaged != 0 || skipped != 0) {
+        fprintf(stderr, "skipped %u damaged blocks and %ld bytes between blocks\n", damaged, skipped);
+    }
+    return true;
+}
+
+static bool roundtrip(const uint8_t *data, long len)
+{
+    char *cbuf = NULL, *dbuf = NULL;
+    size_t clen = 0, dlen = 0;
+    FILE *cf = open_memstream(&cbuf, &clen);
+    bool ok = compress(data, len, cf);
+    fclose(cf);
+    if (ok) {
+        FILE *df = open_memstream(&dbuf, &dlen);
+        ok = expand((const uint8_t *)cbuf, clen, df);
+        fclose(df);
+    }
+    if (ok) {
+        ok = (dlen == (size_t)len && memcmp(dbuf, data, len) == 0);
+        printf("%ld bytes compressed to %u (%.2f:1), round trip %s\n",
+               len, (unsigned)clen, clen ? len / (double)clen : 0.0,
+               ok ? "OK" : "FAILED");
+    }
+    free(cbuf);
+    free(dbuf);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argv[1][0] != '-' ||
+        (argv[1][1] != 't' && argc < 4)) {
+        fprintf(stderr, "Usage: LogCompress -c|-d IN OUT\n"
+                        "       LogCompress -t IN\n");
+        return 1;
+    }
+
+    long len;
+    uint8_t *data = read_file(argv[2], len);
+    if (data == NULL) {
+        return 1;
+    }
+
+    bool ok;
+    if (argv[1][1] == 't') {
+        ok = roundtrip(data, len);
+    } else {
+        FILE *out = fopen(argv[3], "wb");
+        if (out == NULL) {
+            perror(argv[3]);
+            free(data);
+            return 1;
+        }
+        ok = (argv[1][1] == 'd') ? expand(data, len, out) : compress(data, len, out);
+        fclose(out);
+    }
+    free(data);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+  columnar layout of an exported DataFlash log
+
+  Each message type is a directory named after the message, holding:
+
+  - LOGCOLUMNS_INDEX: text file, first line "rows N", then one line per
+    field "LABEL TYPE SIZE" in log order, where TYPE is the log_Format
+    type character. Written last, so a directory without it is an
+    incomplete export
+  - one file per field, named after its label, holding N little-endian
+    values of SIZE bytes each, unscaled as they appear in the log
+  - LOGCOLUMNS_TIME: N uint64_t times in microseconds. Messages without
+    a TimeUS or TimeMS field take the time of the latest timestamped
+    message before them
+
+  The files are plain arrays, so analysis tools can map them directly,
+  e.g. numpy.fromfile("ATT/Roll", dtype="<i2")
+ */
+
+#ifndef LOGCOLUMNS_H
+#define LOGCOLUMNS_H
+
+#define LOGCOLUMNS_INDEX    "@columns"
+#define LOGCOLUMNS_TIME     "@time"
+
+#include <stdio.h>
+
+/*
+  join dir and name into path, returning false if it does not fit
+ */
+static inline bool logcolumns_path(char *path, size_t size, const char *dir, const char *name)
+{
+    const int n = snprintf(path, size, "%s/%s", dir, name);
+    if (n < 0 || (size_t)n >= size) {
+        fprintf(stderr, "Path too long: %s/%s\n", dir, name);
+        return false;
+    }
+    return true;
+}
+
+#endif // LOGCOLUMNS_H
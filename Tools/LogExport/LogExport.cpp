@@ -0,0 +1,355 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+  export a DataFlash .bin log (plain or compressed) to the columnar
+  layout described in LogColumns.h
+
+  LogExport [-j THREADS] LOG OUTDIR
+
+  The log is parsed once with the Replay log reader, keeping the
+  messages of each type together. The messages of each type are then
+  split into columns and written by a pool of threads, one message type
+  at a time
+ */
+
+#include "DataFlashFileReader.h"
+#include "MsgHandler.h"
+#include "LogColumns.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define LOGEXPORT_MAX_THREADS 64
+
+/*
+  the messages of one type, stored as they appear in the log
+ */
+class ColumnHandler : public MsgHandler {
+public:
+    ColumnHandler(const struct log_Format &_f);
+    ~ColumnHandler();
+
+    bool add(const uint8_t *msg, uint64_t &last_time_us);
+    bool write(const char *outdir) const;
+
+    const char *name() const { return _name; }
+    uint32_t count() const { return _count; }
+
+private:
+    char _name[5];
+    bool _valid;            // fields cover the message exactly
+    int8_t _time_field;     // index of TimeUS or TimeMS field, -1 if none
+    uint32_t _time_mul;     // multiplier from _time_field to microseconds
+
+    uint8_t *_rows;
+    uint64_t *_time_us;
+    uint32_t _count;
+    uint32_t _capacity;
+
+    bool write_file(const char *dir, const char *fname, const void *data, size_t len) const;
+};
+
+ColumnHandler::ColumnHandler(const struct log_Format &_f) :
+    MsgHandler(_f),
+    _valid(true),
+    _time_field(-1),
+    _time_mul(1),
+    _rows(NULL),
+    _time_us(NULL),
+    _count(0),
+    _capacity(0)
+{
+    strncpy(_name, f.name, 4);
+    _name[4] = 0;
+
+    uint16_t ofs = 3;
+    for (uint8_t i=0; i<num_fields(); i++) {
+        const struct format_field_info &fi = field(i);
+        if (fi.offset != ofs || fi.length == 0 || fi.length > 64) {
+            _valid = false;
+        }
+        ofs += fi.length;
+        if (streq(fi.label, "TimeUS") && (fi.type == 'Q' || fi.type == 'q')) {
+            _time_field = i;
+            _time_mul = 1;
+        } else if (streq(fi.label, "TimeMS") && _time_field == -1 &&
+                   (fi.type == 'I' || fi.type == 'i')) {
+            _time_field = i;
+            _time_mul = 1000;
+        }
+    }
+    if (ofs != f.length) {
+        _valid = false;
+    }
+    if (!_valid) {
+        ::printf("Not exporting %s: fields do not match message length %u\n",
+                 _name, (unsigned)f.length);
+    }
+}
+
+ColumnHandler::~ColumnHandler()
+{
+    free(_rows);
+    free(_time_us);
+}
+
+/*
+  store one message and its time. Messages without a timestamp get
+  the time of the last timestamped message
+ */
+bool ColumnHandler::add(const uint8_t *msg, uint64_t &last_time_us)
+{
+    if (_count == _capacity) {
+        const uint32_t new_capacity = _capacity ? _capacity * 2 : 256;
+        uint8_t *rows = (uint8_t *)realloc(_rows, (size_t)new_capacity * f.length);
+        if (rows == NULL) {
+            return false;
+        }
+        _rows = rows;
+        uint64_t *time_us = (uint64_t *)realloc(_time_us, (size_t)new_capacity * sizeof(uint64_t));
+        if (time_us == NULL) {
+            return false;
+        }
+        _time_us = time_us;
+        _capacity = new_capacity;
+    }
+
+    if (_valid && _time_field != -1) {
+        const struct format_field_info &fi = field(_time_field);
+        if (fi.length == sizeof(uint64_t)) {
+            uint64_t t;
+            memcpy(&t, &msg[fi.offset], sizeof(t));
+            last_time_us = t;
+        } else {
+            uint32_t t;
+            memcpy(&t, &msg[fi.offset], sizeof(t));
+            last_time_us = (uint64_t)t * _time_mul;
+        }
+    }
+    memcpy(&_rows[(size_t)_count * f.length], msg, f.length);
+    _time_us[_count] = last_time_us;
+    _count++;
+    return true;
+}
+
+bool ColumnHandler::write_file(const char *dir, const char *fname, const void *data, size_t len) const
+{
+    char path[PATH_MAX];
+    if (!logcolumns_path(path, sizeof(path), dir, fname)) {
+        return false;
+    }
+    FILE *out = fopen(path, "wb");
+    if (out == NULL) {
+        perror(path);
+        return false;
+    }
+    bool ok = (len == 0 || fwrite(data, len, 1, out) == 1);
+    if (fclose(out) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        ::printf("Failed to write %s\n", path);
+    }
+    return ok;
+}
+
+/*
+  split the stored messages into one file per field
+ */
+bool ColumnHandler::write(const char *outdir) const
+{
+    if (!_valid || _count == 0) {
+        return true;
+    }
+    char dir[PATH_MAX];
+    if (!logcolumns_path(dir, sizeof(dir), outdir, _name)) {
+        return false;
+    }
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        perror(dir);
+        return false;
+    }
+
+    uint8_t *column = (uint8_t *)malloc((size_t)_count * 64);
+    if (column == NULL) {
+        ::printf("Out of memory exporting %s\n", _name);
+        return false;
+    }
+    bool ok = true;
+    for (uint8_t i=0; i<num_fields() && ok; i++) {
+        const struct format_field_info &fi = field(i);
+        const uint8_t *src = &_rows[fi.offset];
+        uint8_t *dst = column;
+        for (uint32_t r=0; r<_count; r++) {
+            memcpy(dst, src, fi.length);
+            src += f.length;
+            dst += fi.length;
+        }
+        ok = write_file(dir, fi.label, column, (size_t)_count * fi.length);
+    }
+    free(column);
+    if (!ok || !write_file(dir, LOGCOLUMNS_TIME, _time_us, (size_t)_count * sizeof(uint64_t))) {
+        return false;
+    }
+
+    // the index goes last, marking the directory complete
+    char path[PATH_MAX];
+    if (!logcolumns_path(path, sizeof(path), dir, LOGCOLUMNS_INDEX)) {
+        return false;
+    }
+    FILE *index = fopen(path, "w");
+    if (index == NULL) {
+        perror(path);
+        return false;
+    }
+    fprintf(index, "rows %u\n", (unsigned)_count);
+    for (uint8_t i=0; i<num_fields(); i++) {
+        const struct format_field_info &fi = field(i);
+        fprintf(index, "%s %c %u\n", fi.label, fi.type, (unsigned)fi.length);
+    }
+    return fclose(index) == 0;
+}
+
+
+class LogExporter : public DataFlashFileReader
+{
+public:
+    LogExporter() : out_of_memory(false), last_time_us(0) {
+        memset(handlers, 0, sizeof(handlers));
+    }
+    ~LogExporter() {
+        for (uint16_t i=0; i<ARRAY_SIZE(handlers); i++) {
+            delete handlers[i];
+        }
+    }
+
+    bool handle_log_format_msg(const struct log_Format &f) override;
+    bool handle_msg(const struct log_Format &f, uint8_t *msg) override;
+
+    bool write(const char *outdir, uint8_t num_threads);
+
+    bool out_of_memory;
+
+private:
+    ColumnHandler *handlers[LOGREADER_MAX_FORMATS];
+    uint64_t last_time_us;
+
+    // work shared by the writer threads
+    const char *_outdir;
+    volatile uint32_t _next_type;
+    volatile bool _failed;
+    static void *writer_thread(void *arg);
+};
+
+bool LogExporter::handle_log_format_msg(const struct log_Format &f)
+{
+    if (f.type >= LOGREADER_MAX_FORMATS || f.type == LOG_FORMAT_MSG) {
+        return true;
+    }
+    if (handlers[f.type] != NULL) {
+        // a format may only be redefined before any messages of its type
+        if (handlers[f.type]->count() != 0) {
+            ::printf("Ignoring redefinition of message type %u\n", (unsigned)f.type);
+            return true;
+        }
+        delete handlers[f.type];
+    }
+    handlers[f.type] = new ColumnHandler(f);
+    return true;
+}
+
+bool LogExporter::handle_msg(const struct log_Format &f, uint8_t *msg)
+{
+    ColumnHandler *h = handlers[f.type];
+    if (h != NULL && !h->add(msg, last_time_us)) {
+        out_of_memory = true;
+        return false;
+    }
+    return true;
+}
+
+void *LogExporter::writer_thread(void *arg)
+{
+    LogExporter *exporter = (LogExporter *)arg;
+    uint32_t i;
+    while ((i = __sync_fetch_and_add(&exporter->_next_type, 1)) < ARRAY_SIZE(exporter->handlers)) {
+        const ColumnHandler *h = exporter->handlers[i];
+        if (h != NULL && !h->write(exporter->_outdir)) {
+            exporter->_failed = true;
+        }
+    }
+    return NULL;
+}
+
+bool LogExporter::write(const char *outdir, uint8_t num_threads)
+{
+    if (mkdir(outdir, 0755) != 0 && errno != EEXIST) {
+        perror(outdir);
+        return false;
+    }
+    _outdir = outdir;
+    _next_type = 0;
+    _failed = false;
+
+    pthread_t threads[LOGEXPORT_MAX_THREADS];
+    uint8_t started = 0;
+    while (started < num_threads) {
+        if (pthread_create(&threads[started], NULL, writer_thread, this) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        // no threads available, write from this one
+        writer_thread(this);
+    }
+    for (uint8_t i=0; i<started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return !_failed;
+}
+
+
+int main(int argc, char *argv[])
+{
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while ((opt = getopt(argc, argv, "j:")) != -1) {
+        switch (opt) {
+        case 'j':
+            num_threads = atol(optarg);
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (argc - optind != 2) {
+        fprintf(stderr, "Usage: LogExport [-j THREADS] LOG OUTDIR\n");
+        return 1;
+    }
+    num_threads = constrain_int32(num_threads, 1, LOGEXPORT_MAX_THREADS);
+
+    LogExporter exporter;
+    if (!exporter.open_log(argv[optind])) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    char type[5];
+    while (exporter.update(type)) {
+    }
+    if (exporter.out_of_memory) {
+        ::printf("Out of memory reading %s\n", argv[optind]);
+        return 1;
+    }
+
+    return exporter.write(argv[optind+1], num_threads) ? 0 : 1;
+}
@@ -0,0 +1,294 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+  query a log exported by LogExport
+
+  LogQuery DIR                  list message types, row counts and fields
+  LogQuery [-f FIELDS] [-s START] [-e END] [-d N] DIR TYPE
+                                print messages of TYPE as CSV
+
+  -f  comma separated fields to print, default all
+  -s  first time to print, seconds
+  -e  last time to print, seconds
+  -d  print every Nth message
+
+  Only the requested columns are read, and the time range is found by
+  binary search on the time index
+ */
+
+#include "LogColumns.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOGQUERY_MAX_FIELDS 64
+
+struct column {
+    char label[65];
+    char type;
+    unsigned size;
+    const uint8_t *data;    // mapped column, NULL if not selected
+    size_t map_len;
+};
+
+struct message_columns {
+    unsigned rows;
+    unsigned num_columns;
+    struct column columns[LOGQUERY_MAX_FIELDS];
+};
+
+/*
+  read the index of one message type
+ */
+static bool read_index(const char *dir, struct message_columns &m)
+{
+    char path[PATH_MAX];
+    if (!logcolumns_path(path, sizeof(path), dir, LOGCOLUMNS_INDEX)) {
+        return false;
+    }
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    memset(&m, 0, sizeof(m));
+    bool ok = (fscanf(f, "rows %u\n", &m.rows) == 1);
+    while (ok && m.num_columns < LOGQUERY_MAX_FIELDS) {
+        struct column &c = m.columns[m.num_columns];
+        if (fscanf(f, "%64s %c %u\n", c.label, &c.type, &c.size) != 3) {
+            break;
+        }
+        m.num_columns++;
+    }
+    fclose(f);
+    return ok;
+}
+
+static const uint8_t *map_file(const char *dir, const char *fname, size_t expected_len, size_t &map_len)
+{
+    char path[PATH_MAX];
+    if (!logcolumns_path(path, sizeof(path), dir, fname)) {
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror(path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != expected_len) {
+        fprintf(stderr, "%s: unexpected size\n", path);
+        close(fd);
+        return NULL;
+    }
+    map_len = expected_len;
+    void *p = mmap(NULL, map_len > 0 ? map_len : 1, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror(path);
+        return NULL;
+    }
+    return (const uint8_t *)p;
+}
+
+static void print_value(const struct column &c, unsigned row)
+{
+    const uint8_t *p = &c.data[(size_t)row * c.size];
+    switch (c.type) {
+    case 'b': { int8_t v;   memcpy(&v, p, sizeof(v)); printf("%d", v); break; }
+    case 'B':
+    case 'M': { uint8_t v;  memcpy(&v, p, sizeof(v)); printf("%u", v); break; }
+    case 'h': { int16_t v;  memcpy(&v, p, sizeof(v)); printf("%d", v); break; }
+    case 'H': { uint16_t v; memcpy(&v, p, sizeof(v)); printf("%u", v); break; }
+    case 'c': { int16_t v;  memcpy(&v, p, sizeof(v)); printf("%.2f", v*0.01); break; }
+    case 'C': { uint16_t v; memcpy(&v, p, sizeof(v)); printf("%.2f", v*0.01); break; }
+    case 'i': { int32_t v;  memcpy(&v, p, sizeof(v)); printf("%d", v); break; }
+    case 'I': { uint32_t v; memcpy(&v, p, sizeof(v)); printf("%u", v); break; }
+    case 'e': { int32_t v;  memcpy(&v, p, sizeof(v)); printf("%.2f", v*0.01); break; }
+    case 'E': { uint32_t v; memcpy(&v, p, sizeof(v)); printf("%.2f", v*0.01); break; }
+    case 'L': { int32_t v;  memcpy(&v, p, sizeof(v)); printf("%.7f", v*1.0e-7); break; }
+    case 'f': { float v;    memcpy(&v, p, sizeof(v)); printf("%g", v); break; }
+    case 'q': { int64_t v;  memcpy(&v, p, sizeof(v)); printf("%lld", (long long)v); break; }
+    case 'Q': { uint64_t v; memcpy(&v, p, sizeof(v)); printf("%llu", (unsigned long long)v); break; }
+    case 'n':
+    case 'N':
+    case 'Z':
+        printf("%.*s", (int)strnlen((const char *)p, c.size), (const char *)p);
+        break;
+    default:
+        printf("?");
+        break;
+    }
+}
+
+/*
+  first row with time >= t
+ */
+static unsigned find_time(const uint64_t *time_us, unsigned rows, uint64_t t)
+{
+    unsigned lo = 0, hi = rows;
+    while (lo < hi) {
+        const unsigned mid = lo + (hi - lo) / 2;
+        if (time_us[mid] < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int list_types(const char *outdir)
+{
+    DIR *d = opendir(outdir);
+    if (d == NULL) {
+        perror(outdir);
+        return 1;
+    }
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        if (de->d_name[0] == '.') {
+            continue;
+        }
+        char dir[PATH_MAX];
+        if (!logcolumns_path(dir, sizeof(dir), outdir, de->d_name)) {
+            continue;
+        }
+        struct message_columns m;
+        if (!read_index(dir, m)) {
+            continue;
+        }
+        printf("%-4s %8u ", de->d_name, m.rows);
+        for (unsigned i=0; i<m.num_columns; i++) {
+            printf("%s%s", i ? "," : "", m.columns[i].label);
+        }
+        printf("\n");
+    }
+    closedir(d);
+    return 0;
+}
+
+static bool field_selected(const char *fields, const char *label)
+{
+    if (fields == NULL) {
+        return true;
+    }
+    const size_t len = strlen(label);
+    const char *p = fields;
+    while ((p = strstr(p, label)) != NULL) {
+        if ((p == fields || p[-1] == ',') && (p[len] == ',' || p[len] == 0)) {
+            return true;
+        }
+        p += len;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *fields = NULL;
+    double start_s = -1, end_s = -1;
+    unsigned decimate = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:e:d:")) != -1) {
+        switch (opt) {
+        case 'f':
+            fields = optarg;
+            break;
+        case 's':
+            start_s = atof(optarg);
+            break;
+        case 'e':
+            end_s = atof(optarg);
+            break;
+        case 'd':
+            decimate = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (argc - optind == 1) {
+        return list_types(argv[optind]);
+    }
+    if (argc - optind != 2) {
+        fprintf(stderr, "Usage: LogQuery DIR\n"
+                        "       LogQuery [-f FIELDS] [-s START] [-e END] [-d N] DIR TYPE\n");
+        return 1;
+    }
+
+    char dir[PATH_MAX];
+    if (!logcolumns_path(dir, sizeof(dir), argv[optind], argv[optind+1])) {
+        return 1;
+    }
+    struct message_columns m;
+    if (!read_index(dir, m)) {
+        fprintf(stderr, "No message type %s in %s\n", argv[optind+1], argv[optind]);
+        return 1;
+    }
+
+    size_t time_len;
+    const uint64_t *time_us = (const uint64_t *)map_file(dir, LOGCOLUMNS_TIME, (size_t)m.rows * sizeof(uint64_t), time_len);
+    if (time_us == NULL) {
+        return 1;
+    }
+    unsigned first = 0, last = m.rows;
+    if (start_s >= 0) {
+        first = find_time(time_us, m.rows, (uint64_t)(start_s * 1.0e6));
+    }
+    if (end_s >= 0) {
+        last = find_time(time_us, m.rows, (uint64_t)(end_s * 1.0e6) + 1);
+    }
+
+    // map only the selected columns
+    bool header = false;
+    for (unsigned i=0; i<m.num_columns; i++) {
+        struct column &c = m.columns[i];
+        if (!field_selected(fields, c.label)) {
+            continue;
+        }
+        c.data = map_file(dir, c.label, (size_t)m.rows * c.size, c.map_len);
+        if (c.data == NULL) {
+            return 1;
+        }
+        printf("%s%s", header ? "," : "", c.label);
+        header = true;
+    }
+    if (!header) {
+        fprintf(stderr, "No matching fields in %s\n", argv[optind+1]);
+        return 1;
+    }
+    printf("\n");
+
+    for (unsigned r=first; r<last; r+=decimate) {
+        bool comma = false;
+        for (unsigned i=0; i<m.num_columns; i++) {
+            const struct column &c = m.columns[i];
+            if (c.data == NULL) {
+                continue;
+            }
+            if (comma) {
+                printf(",");
+            }
+            print_value(c, r);
+            comma = true;
+        }
+        printf("\n");
+    }
+
+    for (unsigned i=0; i<m.num_columns; i++) {
+        if (m.columns[i].data != NULL) {
+            munmap((void *)m.columns[i].data, m.columns[i].map_len > 0 ? m.columns[i].map_len : 1);
+        }
+    }
+    munmap((void *)time_us, time_len > 0 ? time_len : 1);
+    return 0;
+}
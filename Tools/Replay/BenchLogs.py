@@ -0,0 +1,54 @@
+#!/usr/bin/env python
+'''
+run Replay over a set of logs, timing DCM, EKF1 and EKF2 and
+comparing each with the logged truth
+'''
+
+import optparse, os, sys, json, glob
+
+parser = optparse.OptionParser("BenchLogs")
+parser.add_option("--logdir", type='string', default='testlogs', help='directory of logs to use')
+parser.add_option("--results", type='string', default='bench_results.json', help='file to append results to, one JSON object per log')
+parser.add_option("--param", type='string', action='append', default=[], help='NAME=VALUE parameter to pass to Replay')
+
+opts, args = parser.parse_args()
+
+def run_replay(logfile):
+    '''run Replay on one logfile'''
+    from subprocess import call
+    print("Processing %s" % logfile)
+    cmd = "./Replay.elf -- --bench %s" % opts.results
+    for p in opts.param:
+        cmd += " --parm %s" % p
+    cmd += " %s" % logfile
+    call(cmd, shell=True)
+
+def summarise():
+    '''print the mean of each result over all logs'''
+    results = []
+    for line in open(opts.results):
+        try:
+            results.append(json.loads(line))
+        except ValueError:
+            pass
+    if len(results) == 0:
+        return
+    keys = ['us_per_update', 'max_us', 'heap_bytes', 'att_rms_deg', 'att_max_deg', 'pos_rms_m', 'pos_max_m']
+    print("%-5s %s" % ("", " ".join(["%13s" % k for k in keys])))
+    for name in ['DCM', 'EKF1', 'EKF2']:
+        row = []
+        for k in keys:
+            v = [r['estimators'][name][k] for r in results if r['estimators'][name][k] is not None]
+            row.append("%13.3f" % (sum(v)/len(v)) if len(v) else "%13s" % "-")
+        print("%-5s %s" % (name, " ".join(row)))
+    print("Peak RSS %u kB over %u logs" % (max([r['peak_rss_kb'] for r in results]), len(results)))
+
+if os.path.exists(opts.results):
+    os.unlink(opts.results)
+file_list = glob.glob(os.path.join(opts.logdir, "*.bin")) + args
+if len(file_list) == 0:
+    print("No logs to process in %s" % opts.logdir)
+    sys.exit(1)
+for logfile in file_list:
+    run_replay(logfile)
+summarise()
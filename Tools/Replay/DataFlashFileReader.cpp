@@ -12,13 +12,83 @@ bool DataFlashFileReader::open_log(const char *logfile)
     if (fd == -1) {
         return false;
     }
+
+    // compressed logs start with a magic string
+    char magic[DFCOMPRESS_FILE_MAGIC_LEN];
+    if (::read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+        memcmp(magic, DFCOMPRESS_FILE_MAGIC, sizeof(magic)) == 0) {
+        if (!decoder.init()) {
+            ::printf("Out of memory for log decompression\n");
+            return false;
+        }
+        decoder.reset();
+        compressed = true;
+        decoded_len = decoded_ofs = 0;
+    } else if (::lseek(fd, 0, SEEK_SET) == (off_t)-1) {
+        return false;
+    }
+    return true;
+}
+
+/*
+  read and decode the next block of a compressed log. Damaged blocks
+  are skipped, and after a damaged header the file is scanned a byte
+  at a time for the next valid header
+ */
+bool DataFlashFileReader::read_block(void)
+{
+    while (true) {
+        DFCompress_BlockHeader hdr;
+        if (::read(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+            return false;
+        }
+        if (!DFCompress_Model::header_ok(hdr)) {
+            ::printf("bad compressed block header, resyncing\n");
+            uint32_t skipped = 0;
+            do {
+                uint8_t *h = (uint8_t *)&hdr;
+                memmove(h, h+1, sizeof(hdr)-1);
+                if (::read(fd, &h[sizeof(hdr)-1], 1) != 1) {
+                    return false;
+                }
+                skipped++;
+            } while (!DFCompress_Model::header_ok(hdr));
+            ::printf("resynced after %u bytes\n", (unsigned)skipped);
+        }
+        if (::read(fd, encoded, hdr.encoded_len) != hdr.encoded_len) {
+            return false;
+        }
+        decoded_ofs = 0;
+        if (decoder.decode_block(hdr, encoded, decoded, decoded_len)) {
+            return true;
+        }
+        ::printf("skipping damaged compressed block\n");
+    }
+}
+
+bool DataFlashFileReader::read_input(void *buf, uint16_t len)
+{
+    if (!compressed) {
+        return ::read(fd, buf, len) == len;
+    }
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        if (decoded_ofs == decoded_len && !read_block()) {
+            return false;
+        }
+        uint16_t n = MIN(len, decoded_len - decoded_ofs);
+        memcpy(p, &decoded[decoded_ofs], n);
+        decoded_ofs += n;
+        p += n;
+        len -= n;
+    }
     return true;
 }
 
 bool DataFlashFileReader::update(char type[5])
 {
     uint8_t hdr[3];
-    if (::read(fd, hdr, 3) != 3) {
+    if (!read_input(hdr, 3)) {
         return false;
     }
     if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
@@ -29,7 +99,7 @@ bool DataFlashFileReader::update(char type[5])
     if (hdr[2] == LOG_FORMAT_MSG) {
         struct log_Format f;
         memcpy(&f, hdr, 3);
-        if (::read(fd, &f.type, sizeof(f)-3) != sizeof(f)-3) {
+        if (!read_input(&f.type, sizeof(f)-3)) {
             return false;
         }
         memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
@@ -55,7 +125,7 @@ bool DataFlashFileReader::update(char type[5])
     uint8_t msg[f.length];
 
     memcpy(msg, hdr, 3);
-    if (::read(fd, &msg[3], f.length-3) != f.length-3) {
+    if (!read_input(&msg[3], f.length-3)) {
         return false;
     }
 
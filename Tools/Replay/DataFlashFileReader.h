@@ -1,7 +1,10 @@
 #ifndef REPLAY_DATAFLASHREADER_H
 #define REPLAY_DATAFLASHREADER_H
 
-#include <DataFlash/DataFlash.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <DataFlash/LogStructure.h>
+#include <DataFlash/DFCompress.h>
 
 class DataFlashFileReader
 {
@@ -17,6 +20,18 @@ protected:
     bool done_format_msgs = false;
     virtual void end_format_msgs(void) {}
 
+    // read len bytes of log data, expanding compressed logs
+    bool read_input(void *buf, uint16_t len);
+
+    // compressed log support
+    bool compressed = false;
+    bool read_block(void);
+    DFCompress_Decoder decoder;
+    uint8_t decoded[DFCOMPRESS_BLOCK_MAX_DECODED];
+    uint8_t encoded[DFCOMPRESS_BLOCK_MAX_ENCODED];
+    uint16_t decoded_len = 0;
+    uint16_t decoded_ofs = 0;
+
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
 };
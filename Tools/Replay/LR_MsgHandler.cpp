@@ -66,9 +66,12 @@ void LR_MsgHandler_ARSP::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
 
-    airspeed.setHIL(require_field_float(msg, "Airspeed"),
-		    require_field_float(msg, "DiffPress"),
-		    require_field_float(msg, "Temp"));
+    AP_AHRS_Driver::Airspeed_Sample s;
+    s.time_us = last_timestamp_usec;
+    s.airspeed = require_field_float(msg, "Airspeed");
+    s.diff_pressure = require_field_float(msg, "DiffPress");
+    s.temperature = require_field_float(msg, "Temp");
+    driver.push_airspeed(s);
 }
 
 void LR_MsgHandler_FRAM::process_message(uint8_t *msg)
@@ -99,9 +102,13 @@ void LR_MsgHandler_CHEK::process_message(uint8_t *msg)
 void LR_MsgHandler_BARO::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
-    baro.setHIL(0,
-		require_field_float(msg, "Press"),
-		require_field_int16_t(msg, "Temp") * 0.01f);
+
+    AP_AHRS_Driver::Baro_Sample s;
+    s.time_us = last_timestamp_usec;
+    s.instance = 0;
+    s.pressure = require_field_float(msg, "Press");
+    s.temperature = require_field_int16_t(msg, "Temp") * 0.01f;
+    driver.push_baro(s);
 }
 
 
@@ -143,10 +150,11 @@ void LR_MsgHandler_GPS_Base::update_from_msg_gps(uint8_t gps_offset, uint8_t *ms
     }
     wait_timestamp_usec(time_us);
 
-    Location loc;
-    location_from_msg(msg, loc, "Lat", "Lng", "Alt");
-    Vector3f vel;
-    ground_vel_from_msg(msg, vel, "Spd", "GCrs", "VZ");
+    AP_AHRS_Driver::GPS_Sample s;
+    s.time_us = time_us;
+    s.instance = gps_offset;
+    location_from_msg(msg, s.location, "Lat", "Lng", "Alt");
+    ground_vel_from_msg(msg, s.velocity, "Spd", "GCrs", "VZ");
 
     uint8_t status = require_field_uint8_t(msg, "Status");
     uint8_t hdop = 0;
@@ -159,14 +167,11 @@ void LR_MsgHandler_GPS_Base::update_from_msg_gps(uint8_t gps_offset, uint8_t *ms
         ! field_value(msg, "numSV", nsats)) {
         field_not_found(msg, "NSats");
     }
-    gps.setHIL(gps_offset,
-               (AP_GPS::GPS_Status)status,
-               uint32_t(time_us/1000),
-               loc,
-               vel,
-               nsats,
-               hdop,
-               require_field_float(msg, "VZ") != 0);
+    s.status = (AP_GPS::GPS_Status)status;
+    s.num_sats = nsats;
+    s.hdop = hdop;
+    s.have_vertical_velocity = require_field_float(msg, "VZ") != 0;
+    driver.push_gps(s);
     if (status == AP_GPS::GPS_OK_FIX_3D && ground_alt_cm == 0) {
         ground_alt_cm = require_field_int32_t(msg, "Alt");
     }
@@ -207,16 +212,18 @@ void LR_MsgHandler_IMU_Base::update_from_msg_imu(uint8_t imu_offset, uint8_t *ms
 
     uint8_t this_imu_mask = 1 << imu_offset;
 
+    AP_AHRS_Driver::IMU_Sample s {};
+    s.time_us = last_timestamp_usec;
+    s.instance = imu_offset;
     if (gyro_mask & this_imu_mask) {
-        Vector3f gyro;
-        require_field(msg, "Gyr", gyro);
-        ins.set_gyro(imu_offset, gyro);
+        require_field(msg, "Gyr", s.gyro);
+        s.have_gyro = true;
     }
     if (accel_mask & this_imu_mask) {
-        Vector3f accel2;
-        require_field(msg, "Acc", accel2);
-        ins.set_accel(imu_offset, accel2);
+        require_field(msg, "Acc", s.accel);
+        s.have_accel = true;
     }
+    driver.push_imu(s);
 }
 
 
@@ -235,22 +242,21 @@ void LR_MsgHandler_IMT_Base::update_from_msg_imt(uint8_t imu_offset, uint8_t *ms
 
     uint8_t this_imu_mask = 1 << imu_offset;
 
-    float delta_time = 0;
-    require_field(msg, "DelT", delta_time);
-    ins.set_delta_time(delta_time);
+    AP_AHRS_Driver::IMU_Sample s {};
+    s.time_us = last_timestamp_usec;
+    s.instance = imu_offset;
+    require_field(msg, "DelT", s.delta_time);
 
     if (gyro_mask & this_imu_mask) {
-        Vector3f d_angle;
-        require_field(msg, "DelA", d_angle);
-        ins.set_delta_angle(imu_offset, d_angle);
+        require_field(msg, "DelA", s.delta_angle);
+        s.have_delta_angle = true;
     }
     if (accel_mask & this_imu_mask) {
-        float dvt = 0;
-        require_field(msg, "DelvT", dvt);
-        Vector3f d_velocity;
-        require_field(msg, "DelV", d_velocity);
-        ins.set_delta_velocity(imu_offset, dvt, d_velocity);
+        require_field(msg, "DelvT", s.delta_velocity_dt);
+        require_field(msg, "DelV", s.delta_velocity);
+        s.have_delta_velocity = true;
     }
+    driver.push_imu(s);
 }
 
 void LR_MsgHandler_IMT::process_message(uint8_t *msg)
@@ -278,15 +284,14 @@ void LR_MsgHandler_MAG_Base::update_from_msg_compass(uint8_t compass_offset, uin
 {
     wait_timestamp_from_msg(msg);
 
-    Vector3f mag;
-    require_field(msg, "Mag", mag);
-    Vector3f mag_offset;
-    require_field(msg, "Ofs", mag_offset);
-
-    compass.setHIL(compass_offset, mag - mag_offset);
     // compass_offset is which compass we are setting info for;
-    // mag_offset is a vector indicating the compass' calibration...
-    compass.set_offsets(compass_offset, mag_offset);
+    // s.offsets is a vector indicating the compass' calibration...
+    AP_AHRS_Driver::Mag_Sample s;
+    s.time_us = last_timestamp_usec;
+    s.instance = compass_offset;
+    require_field(msg, "Mag", s.field);
+    require_field(msg, "Ofs", s.offsets);
+    driver.push_mag(s);
 }
 
 
@@ -399,4 +404,8 @@ void LR_MsgHandler_SIM::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
     attitude_from_msg(msg, sim_attitude, "Roll", "Pitch", "Yaw");
+    sim_position.lat = require_field_int32_t(msg, "Lat");
+    sim_position.lng = require_field_int32_t(msg, "Lng");
+    sim_position.alt = require_field_float(msg, "Alt") * 100;
+    sim_position.options = 0;
 }
@@ -1,6 +1,8 @@
 #ifndef AP_LR_MSGHANDLER_H
 #define AP_LR_MSGHANDLER_H
 
+#include <DataFlash/DataFlash.h>
+#include <AP_AHRS/AP_AHRS_Driver.h>
 #include "MsgHandler.h"
 
 class LR_MsgHandler : public MsgHandler {
@@ -61,13 +63,13 @@ class LR_MsgHandler_ARSP : public LR_MsgHandler
 {
 public:
     LR_MsgHandler_ARSP(log_Format &_f, DataFlash_Class &_dataflash,
-		    uint64_t &_last_timestamp_usec, AP_Airspeed &_airspeed) :
-	LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), airspeed(_airspeed) { };
+		    uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver) :
+	LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), driver(_driver) { };
 
     virtual void process_message(uint8_t *msg);
 
 private:
-    AP_Airspeed &airspeed;
+    AP_AHRS_Driver &driver;
 };
 
 class LR_MsgHandler_FRAM : public LR_MsgHandler
@@ -113,13 +115,13 @@ class LR_MsgHandler_BARO : public LR_MsgHandler
 {
 public:
     LR_MsgHandler_BARO(log_Format &_f, DataFlash_Class &_dataflash,
-                    uint64_t &_last_timestamp_usec, AP_Baro &_baro)
-        : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), baro(_baro) { };
+                    uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver)
+        : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), driver(_driver) { };
 
     virtual void process_message(uint8_t *msg);
 
 private:
-    AP_Baro &baro;
+    AP_AHRS_Driver &driver;
 };
 
 
@@ -141,17 +143,17 @@ class LR_MsgHandler_GPS_Base : public LR_MsgHandler
 
 public:
     LR_MsgHandler_GPS_Base(log_Format &_f, DataFlash_Class &_dataflash,
-                           uint64_t &_last_timestamp_usec, AP_GPS &_gps,
+                           uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver,
                            uint32_t &_ground_alt_cm, float &_rel_altitude)
         : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
-          gps(_gps), ground_alt_cm(_ground_alt_cm),
+          driver(_driver), ground_alt_cm(_ground_alt_cm),
           rel_altitude(_rel_altitude) { };
 
 protected:
     void update_from_msg_gps(uint8_t imu_offset, uint8_t *data, bool responsible_for_relalt);
 
 private:
-    AP_GPS &gps;
+    AP_AHRS_Driver &driver;
     uint32_t &ground_alt_cm;
     float &rel_altitude;
 };
@@ -161,16 +163,16 @@ class LR_MsgHandler_GPS : public LR_MsgHandler_GPS_Base
 {
 public:
     LR_MsgHandler_GPS(log_Format &_f, DataFlash_Class &_dataflash,
-                   uint64_t &_last_timestamp_usec, AP_GPS &_gps,
+                   uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver,
                    uint32_t &_ground_alt_cm, float &_rel_altitude)
         : LR_MsgHandler_GPS_Base(_f, _dataflash,_last_timestamp_usec,
-                              _gps, _ground_alt_cm, _rel_altitude),
-          gps(_gps), ground_alt_cm(_ground_alt_cm), rel_altitude(_rel_altitude) { };
+                              _driver, _ground_alt_cm, _rel_altitude),
+          driver(_driver), ground_alt_cm(_ground_alt_cm), rel_altitude(_rel_altitude) { };
 
     void process_message(uint8_t *msg);
 
 private:
-    AP_GPS &gps;
+    AP_AHRS_Driver &driver;
     uint32_t &ground_alt_cm;
     float &rel_altitude;
 };
@@ -183,15 +185,15 @@ class LR_MsgHandler_GPS2 : public LR_MsgHandler_GPS_Base
 {
 public:
     LR_MsgHandler_GPS2(log_Format &_f, DataFlash_Class &_dataflash,
-                    uint64_t &_last_timestamp_usec, AP_GPS &_gps,
+                    uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver,
                     uint32_t &_ground_alt_cm, float &_rel_altitude)
         : LR_MsgHandler_GPS_Base(_f, _dataflash, _last_timestamp_usec,
-                                 _gps, _ground_alt_cm,
-                                 _rel_altitude), gps(_gps),
+                                 _driver, _ground_alt_cm,
+                                 _rel_altitude), driver(_driver),
           ground_alt_cm(_ground_alt_cm), rel_altitude(_rel_altitude) { };
     virtual void process_message(uint8_t *msg);
 private:
-    AP_GPS &gps;
+    AP_AHRS_Driver &driver;
     uint32_t &ground_alt_cm;
     float &rel_altitude;
 };
@@ -204,17 +206,17 @@ public:
     LR_MsgHandler_IMU_Base(log_Format &_f, DataFlash_Class &_dataflash,
                         uint64_t &_last_timestamp_usec,
                         uint8_t &_accel_mask, uint8_t &_gyro_mask,
-                        AP_InertialSensor &_ins) :
+                        AP_AHRS_Driver &_driver) :
         LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
         accel_mask(_accel_mask),
         gyro_mask(_gyro_mask),
-        ins(_ins) { };
+        driver(_driver) { };
     void update_from_msg_imu(uint8_t imu_offset, uint8_t *msg);
 
 private:
     uint8_t &accel_mask;
     uint8_t &gyro_mask;
-    AP_InertialSensor &ins;
+    AP_AHRS_Driver &driver;
 };
 
 class LR_MsgHandler_IMU : public LR_MsgHandler_IMU_Base
@@ -223,9 +225,9 @@ public:
     LR_MsgHandler_IMU(log_Format &_f, DataFlash_Class &_dataflash,
                    uint64_t &_last_timestamp_usec,
                    uint8_t &_accel_mask, uint8_t &_gyro_mask,
-                   AP_InertialSensor &_ins)
+                   AP_AHRS_Driver &_driver)
         : LR_MsgHandler_IMU_Base(_f, _dataflash, _last_timestamp_usec,
-                              _accel_mask, _gyro_mask, _ins) { };
+                              _accel_mask, _gyro_mask, _driver) { };
 
     void process_message(uint8_t *msg);
 };
@@ -236,9 +238,9 @@ public:
     LR_MsgHandler_IMU2(log_Format &_f, DataFlash_Class &_dataflash,
                     uint64_t &_last_timestamp_usec,
                     uint8_t &_accel_mask, uint8_t &_gyro_mask,
-                    AP_InertialSensor &_ins)
+                    AP_AHRS_Driver &_driver)
         : LR_MsgHandler_IMU_Base(_f, _dataflash, _last_timestamp_usec,
-                              _accel_mask, _gyro_mask, _ins) {};
+                              _accel_mask, _gyro_mask, _driver) {};
 
     virtual void process_message(uint8_t *msg);
 };
@@ -249,9 +251,9 @@ public:
     LR_MsgHandler_IMU3(log_Format &_f, DataFlash_Class &_dataflash,
                     uint64_t &_last_timestamp_usec,
                     uint8_t &_accel_mask, uint8_t &_gyro_mask,
-                    AP_InertialSensor &_ins)
+                    AP_AHRS_Driver &_driver)
         : LR_MsgHandler_IMU_Base(_f, _dataflash, _last_timestamp_usec,
-                              _accel_mask, _gyro_mask, _ins) {};
+                              _accel_mask, _gyro_mask, _driver) {};
 
     virtual void process_message(uint8_t *msg);
 };
@@ -264,19 +266,19 @@ public:
                            uint64_t &_last_timestamp_usec,
                            uint8_t &_accel_mask, uint8_t &_gyro_mask,
                            bool &_use_imt,
-                           AP_InertialSensor &_ins) :
+                           AP_AHRS_Driver &_driver) :
         LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
         accel_mask(_accel_mask),
         gyro_mask(_gyro_mask),
         use_imt(_use_imt),
-        ins(_ins) { };
+        driver(_driver) { };
     void update_from_msg_imt(uint8_t imu_offset, uint8_t *msg);
 
 private:
     uint8_t &accel_mask;
     uint8_t &gyro_mask;
     bool &use_imt;
-    AP_InertialSensor &ins;
+    AP_AHRS_Driver &driver;
 };
 
 class LR_MsgHandler_IMT : public LR_MsgHandler_IMT_Base
@@ -286,9 +288,9 @@ public:
                       uint64_t &_last_timestamp_usec,
                       uint8_t &_accel_mask, uint8_t &_gyro_mask,
                       bool &_use_imt,
-                      AP_InertialSensor &_ins)
+                      AP_AHRS_Driver &_driver)
         : LR_MsgHandler_IMT_Base(_f, _dataflash, _last_timestamp_usec,
-                                 _accel_mask, _gyro_mask, _use_imt, _ins) { };
+                                 _accel_mask, _gyro_mask, _use_imt, _driver) { };
 
     void process_message(uint8_t *msg);
 };
@@ -300,9 +302,9 @@ public:
                        uint64_t &_last_timestamp_usec,
                        uint8_t &_accel_mask, uint8_t &_gyro_mask,
                        bool &_use_imt,
-                       AP_InertialSensor &_ins)
+                       AP_AHRS_Driver &_driver)
         : LR_MsgHandler_IMT_Base(_f, _dataflash, _last_timestamp_usec,
-                                 _accel_mask, _gyro_mask, _use_imt, _ins) { };
+                                 _accel_mask, _gyro_mask, _use_imt, _driver) { };
 
     void process_message(uint8_t *msg);
 };
@@ -314,9 +316,9 @@ public:
                        uint64_t &_last_timestamp_usec,
                        uint8_t &_accel_mask, uint8_t &_gyro_mask,
                        bool &_use_imt,
-                       AP_InertialSensor &_ins)
+                       AP_AHRS_Driver &_driver)
         : LR_MsgHandler_IMT_Base(_f, _dataflash, _last_timestamp_usec,
-                                 _accel_mask, _gyro_mask, _use_imt, _ins) { };
+                                 _accel_mask, _gyro_mask, _use_imt, _driver) { };
 
     void process_message(uint8_t *msg);
 };
@@ -326,22 +328,22 @@ class LR_MsgHandler_MAG_Base : public LR_MsgHandler
 {
 public:
     LR_MsgHandler_MAG_Base(log_Format &_f, DataFlash_Class &_dataflash,
-                        uint64_t &_last_timestamp_usec, Compass &_compass)
-	: LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), compass(_compass) { };
+                        uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver)
+	: LR_MsgHandler(_f, _dataflash, _last_timestamp_usec), driver(_driver) { };
 
 protected:
     void update_from_msg_compass(uint8_t compass_offset, uint8_t *msg);
 
 private:
-    Compass &compass;
+    AP_AHRS_Driver &driver;
 };
 
 class LR_MsgHandler_MAG : public LR_MsgHandler_MAG_Base
 {
 public:
     LR_MsgHandler_MAG(log_Format &_f, DataFlash_Class &_dataflash,
-                   uint64_t &_last_timestamp_usec, Compass &_compass)
-        : LR_MsgHandler_MAG_Base(_f, _dataflash, _last_timestamp_usec,_compass) {};
+                   uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver)
+        : LR_MsgHandler_MAG_Base(_f, _dataflash, _last_timestamp_usec,_driver) {};
 
     virtual void process_message(uint8_t *msg);
 };
@@ -350,8 +352,8 @@ class LR_MsgHandler_MAG2 : public LR_MsgHandler_MAG_Base
 {
 public:
     LR_MsgHandler_MAG2(log_Format &_f, DataFlash_Class &_dataflash,
-                    uint64_t &_last_timestamp_usec, Compass &_compass)
-        : LR_MsgHandler_MAG_Base(_f, _dataflash, _last_timestamp_usec,_compass) {};
+                    uint64_t &_last_timestamp_usec, AP_AHRS_Driver &_driver)
+        : LR_MsgHandler_MAG_Base(_f, _dataflash, _last_timestamp_usec,_driver) {};
 
     virtual void process_message(uint8_t *msg);
 };
@@ -404,15 +406,18 @@ class LR_MsgHandler_SIM : public LR_MsgHandler
 public:
     LR_MsgHandler_SIM(log_Format &_f, DataFlash_Class &_dataflash,
                    uint64_t &_last_timestamp_usec,
-                   Vector3f &_sim_attitude)
+                   Vector3f &_sim_attitude,
+                   Location &_sim_position)
         : LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
-          sim_attitude(_sim_attitude)
+          sim_attitude(_sim_attitude),
+          sim_position(_sim_position)
         { };
 
     virtual void process_message(uint8_t *msg);
 
 private:
     Vector3f &sim_attitude;
+    Location &sim_position;
 };
 
 
@@ -39,6 +39,7 @@ LogReader::LogReader(AP_AHRS &_ahrs, AP_InertialSensor &_ins, AP_Baro &_baro, Co
     gps(_gps),
     airspeed(_airspeed),
     dataflash(_dataflash),
+    driver(_ahrs, _ins, _baro, _compass, _gps, _airspeed),
     structure(_structure),
     num_types(_num_types),
     accel_mask(7),
@@ -167,12 +168,12 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	    msgparser[f.type] = new LR_MsgHandler_GPS(formats[f.type],
 						   dataflash,
                                                    last_timestamp_usec,
-                                                   gps, ground_alt_cm,
+                                                   driver, ground_alt_cm,
                                                    rel_altitude);
 	} else if (streq(name, "GPS2")) {
 	    msgparser[f.type] = new LR_MsgHandler_GPS2(formats[f.type], dataflash,
                                                     last_timestamp_usec,
-						    gps, ground_alt_cm,
+						    driver, ground_alt_cm,
 						    rel_altitude);
 	} else if (streq(name, "MSG")) {
 	    msgparser[f.type] = new LR_MsgHandler_MSG(formats[f.type], dataflash,
@@ -181,34 +182,34 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	} else if (streq(name, "IMU")) {
 	    msgparser[f.type] = new LR_MsgHandler_IMU(formats[f.type], dataflash,
                                                    last_timestamp_usec,
-						   accel_mask, gyro_mask, ins);
+						   accel_mask, gyro_mask, driver);
 	} else if (streq(name, "IMU2")) {
 	    msgparser[f.type] = new LR_MsgHandler_IMU2(formats[f.type], dataflash,
                                                     last_timestamp_usec,
-						    accel_mask, gyro_mask, ins);
+						    accel_mask, gyro_mask, driver);
 	} else if (streq(name, "IMU3")) {
 	    msgparser[f.type] = new LR_MsgHandler_IMU3(formats[f.type], dataflash,
                                                     last_timestamp_usec,
-						    accel_mask, gyro_mask, ins);
+						    accel_mask, gyro_mask, driver);
 	} else if (streq(name, "IMT")) {
 	    msgparser[f.type] = new LR_MsgHandler_IMT(formats[f.type], dataflash,
                                                       last_timestamp_usec,
-                                                      accel_mask, gyro_mask, use_imt, ins);
+                                                      accel_mask, gyro_mask, use_imt, driver);
 	} else if (streq(name, "IMT2")) {
 	    msgparser[f.type] = new LR_MsgHandler_IMT2(formats[f.type], dataflash,
                                                        last_timestamp_usec,
-                                                       accel_mask, gyro_mask, use_imt, ins);
+                                                       accel_mask, gyro_mask, use_imt, driver);
 	} else if (streq(name, "IMT3")) {
 	    msgparser[f.type] = new LR_MsgHandler_IMT3(formats[f.type], dataflash,
                                                        last_timestamp_usec,
-                                                       accel_mask, gyro_mask, use_imt, ins);
+                                                       accel_mask, gyro_mask, use_imt, driver);
 	} else if (streq(name, "SIM")) {
 	  msgparser[f.type] = new LR_MsgHandler_SIM(formats[f.type], dataflash,
                                                  last_timestamp_usec,
-						 sim_attitude);
+						 sim_attitude, sim_position);
 	} else if (streq(name, "BARO")) {
 	  msgparser[f.type] = new LR_MsgHandler_BARO(formats[f.type], dataflash,
-                                                  last_timestamp_usec, baro);
+                                                  last_timestamp_usec, driver);
 	} else if (streq(name, "ARM")) {
 	  msgparser[f.type] = new LR_MsgHandler_ARM(formats[f.type], dataflash,
                                                   last_timestamp_usec);
@@ -227,10 +228,10 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
                                                  attitude);
 	} else if (streq(name, "MAG")) {
 	  msgparser[f.type] = new LR_MsgHandler_MAG(formats[f.type], dataflash,
-						 last_timestamp_usec, compass);
+						 last_timestamp_usec, driver);
 	} else if (streq(name, "MAG2")) {
 	  msgparser[f.type] = new LR_MsgHandler_MAG2(formats[f.type], dataflash,
-						 last_timestamp_usec, compass);
+						 last_timestamp_usec, driver);
 	} else if (streq(name, "NTUN")) {
 	    // the label "NTUN" is used by rover, copter and plane -
 	    // and they all look different!  creation of a parser is
@@ -241,7 +242,7 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	} else if (streq(name, "ARSP")) { // plane-specific(?!)
 	    msgparser[f.type] = new LR_MsgHandler_ARSP(formats[f.type], dataflash,
                                                     last_timestamp_usec,
-                                                    airspeed);
+                                                    driver);
 	} else if (streq(name, "FRAM")) {
 	    msgparser[f.type] = new LR_MsgHandler_FRAM(formats[f.type], dataflash,
                                                     last_timestamp_usec);
@@ -12,6 +12,8 @@ public:
     const Vector3f &get_ahr2_attitude(void) const { return ahr2_attitude; }
     const Vector3f &get_inavpos(void) const { return inavpos; }
     const Vector3f &get_sim_attitude(void) const { return sim_attitude; }
+    const Location &get_sim_position(void) const { return sim_position; }
+    bool have_sim(void) const { return sim_position.lat != 0 || sim_position.lng != 0; }
     const float &get_relalt(void) const { return rel_altitude; }
     const LR_MsgHandler::CheckState &get_check_state(void) const { return check_state; }
 
@@ -25,6 +27,7 @@ public:
     void set_save_chek_messages(bool _save_chek_messages) { save_chek_messages = _save_chek_messages; }
 
     uint64_t last_timestamp_us(void) const { return last_timestamp_usec; }
+    AP_AHRS_Driver &get_driver(void) { return driver; }
     virtual bool handle_log_format_msg(const struct log_Format &f);
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg);
 
@@ -41,6 +44,7 @@ private:
     AP_GPS &gps;
     AP_Airspeed &airspeed;
     DataFlash_Class &dataflash;
+    AP_AHRS_Driver driver;
 
     uint8_t accel_mask;
     uint8_t gyro_mask;
@@ -53,6 +57,7 @@ private:
     Vector3f attitude;
     Vector3f ahr2_attitude;
     Vector3f sim_attitude;
+    Location sim_position {};
     Vector3f inavpos;
     float rel_altitude;
     uint64_t last_timestamp_usec;
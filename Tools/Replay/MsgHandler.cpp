@@ -28,6 +28,7 @@ uint8_t MsgHandler::size_for_type(char type)
 
 void MsgHandler::init_field_types()
 {
+    memset(size_for_type_table, 0, sizeof(size_for_type_table));
     add_field_type('b', sizeof(int8_t));
     add_field_type('c', sizeof(int16_t));
     add_field_type('e', sizeof(int32_t));
@@ -182,10 +183,8 @@ void MsgHandler::string_for_labels(char *buffer, uint bufferlen)
 
 MsgHandler::~MsgHandler()
 {
-    for (uint8_t k=0; k<LOGREADER_MAX_FIELDS; k++) {
-        if (field_info[k].label != NULL) {
-            free(field_info[k].label);
-        }
+    for (uint8_t k=0; k<next_field; k++) {
+        free(field_info[k].label);
     }
 }
 
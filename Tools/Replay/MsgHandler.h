@@ -1,7 +1,9 @@
 #ifndef AP_MSGHANDLER_H
 #define AP_MSGHANDLER_H
 
-#include <DataFlash/DataFlash.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <DataFlash/LogStructure.h>
 #include "VehicleType.h"
 
 #include <stdio.h>
@@ -41,6 +43,17 @@ public:
     uint16_t require_field_uint16_t(uint8_t *msg, const char *label);
     int16_t require_field_int16_t(uint8_t *msg, const char *label);
 
+    struct format_field_info { // parsed field information
+        char *label;
+        uint8_t type;
+        uint8_t offset;
+        uint8_t length;
+    };
+
+    // iterate over all fields, for tools which handle every field
+    uint8_t num_fields() const { return next_field; }
+    const struct format_field_info &field(uint8_t i) const { return field_info[i]; }
+
 private:
 
     void add_field(const char *_label, uint8_t _type, uint8_t _offset,
@@ -50,12 +63,6 @@ private:
     void field_value_for_type_at_offset(uint8_t *msg, uint8_t type,
                                         uint8_t offset, R &ret);
 
-    struct format_field_info { // parsed field information
-        char *label;
-        uint8_t type;
-        uint8_t offset;
-        uint8_t length;
-    };
     struct format_field_info field_info[LOGREADER_MAX_FIELDS];
 
     uint8_t next_field;
@@ -50,6 +50,11 @@
 #include <errno.h>
 #include <signal.h>
 #include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <time.h>
+#include <sys/resource.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 #include <AP_SerialManager/AP_SerialManager.h>
 #include "Parameters.h"
@@ -270,6 +275,39 @@ private:
         float max_vel_error;
     } check_result {};
 
+    /*
+      --bench: time each estimator separately and compare its
+      solution with the logged truth
+     */
+    const char *bench_filename = NULL;
+    enum {
+        BENCH_DCM = 0,
+        BENCH_EKF1,
+        BENCH_EKF2,
+        BENCH_NUM_ESTIMATORS
+    };
+    struct bench_estimator {
+        uint64_t total_ns;      // CPU time in update
+        uint64_t max_ns;
+        uint32_t updates;
+        uint64_t heap_bytes;    // heap allocated during updates
+        uint32_t att_samples;
+        double att_sq_sum;
+        float att_max;          // degrees
+        uint32_t pos_samples;
+        double pos_sq_sum;
+        float pos_max;          // meters, horizontal
+    } bench[BENCH_NUM_ESTIMATORS] {};
+    const char *bench_pos_truth = "none";
+
+    void bench_update(void);
+    void bench_run(struct bench_estimator &b, void (AP_AHRS_NavEKF::*update_fn)(void));
+    void bench_compare(struct bench_estimator &b,
+                       bool att_valid, const Vector3f &euler,
+                       bool pos_valid, const Location &loc,
+                       const Location *truth_pos);
+    void bench_report(void);
+
     void _parse_command_line(uint8_t argc, char * const argv[]);
 
     uint8_t num_user_parameters;
@@ -309,6 +347,7 @@ void Replay::usage(void)
     ::printf("\t--tolerance-vel    tolerance for velocity in meters/second\n");
     ::printf("\t--nottypes         list of msg types not to output, comma separated\n");
     ::printf("\t--downsample       downsampling rate for output\n");
+    ::printf("\t--bench FILE       time DCM, EKF1 and EKF2 separately and append results to FILE\n");
 }
 
 
@@ -319,7 +358,8 @@ enum {
     OPT_TOLERANCE_POS,
     OPT_TOLERANCE_VEL,
     OPT_NOTTYPES,
-    OPT_DOWNSAMPLE
+    OPT_DOWNSAMPLE,
+    OPT_BENCH
 };
 
 void Replay::flush_dataflash(void) {
@@ -371,6 +411,7 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"tolerance-vel",   true,   0, OPT_TOLERANCE_VEL},
         {"nottypes",        true,   0, OPT_NOTTYPES},
         {"downsample",      true,   0, OPT_DOWNSAMPLE},
+        {"bench",           true,   0, OPT_BENCH},
         {0, false, 0, 0}
     };
 
@@ -441,6 +482,10 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             downsample = atoi(gopt.optarg);
             break;
 
+        case OPT_BENCH:
+            bench_filename = gopt.optarg;
+            break;
+
         case 'h':
         default:
             usage();
@@ -741,7 +786,11 @@ void Replay::read_sensors(const char *type)
     }
     
     if (run_ahrs) {
-        _vehicle.ahrs.update();
+        if (bench_filename != NULL) {
+            bench_update();
+        } else {
+            logreader.get_driver().update();
+        }
         if (_vehicle.ahrs.get_home().lat != 0) {
             _vehicle.inertial_nav.update(_vehicle.ins.get_delta_time());
         }
@@ -1063,6 +1112,9 @@ void Replay::loop()
 
     flush_dataflash();
 
+    if (bench_filename != NULL) {
+        bench_report();
+    }
     if (check_solution) {
         report_checks();
     }
@@ -1070,6 +1122,154 @@ void Replay::loop()
 }
 
 
+/*
+  CPU time of this thread, which is not affected by the replay clock
+ */
+static uint64_t bench_cpu_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static size_t bench_heap_in_use(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+    return mallinfo().uordblks;
+#else
+    return 0;
+#endif
+}
+
+void Replay::bench_run(struct bench_estimator &b, void (AP_AHRS_NavEKF::*update_fn)(void))
+{
+    const size_t heap_before = bench_heap_in_use();
+    const uint64_t start_ns = bench_cpu_time_ns();
+    (_vehicle.ahrs.*update_fn)();
+    const uint64_t elapsed_ns = bench_cpu_time_ns() - start_ns;
+    const size_t heap_after = bench_heap_in_use();
+
+    b.total_ns += elapsed_ns;
+    b.max_ns = MAX(b.max_ns, elapsed_ns);
+    b.updates++;
+    if (heap_after > heap_before) {
+        b.heap_bytes += heap_after - heap_before;
+    }
+}
+
+/*
+  accumulate the attitude and horizontal position error of one
+  estimator against the truth
+ */
+void Replay::bench_compare(struct bench_estimator &b,
+                           bool att_valid, const Vector3f &euler,
+                           bool pos_valid, const Location &loc,
+                           const Location *truth_pos)
+{
+    if (att_valid && logreader.have_sim()) {
+        const Vector3f &truth = logreader.get_sim_attitude();
+        const float err = MAX(MAX(fabsf(degrees(euler.x) - truth.x),
+                                  fabsf(degrees(euler.y) - truth.y)),
+                              fabsf(wrap_180_cd_float(100*(degrees(euler.z) - truth.z))*0.01f));
+        b.att_samples++;
+        b.att_sq_sum += sq(err);
+        b.att_max = MAX(b.att_max, err);
+    }
+    if (pos_valid && truth_pos != NULL) {
+        const float err = get_distance(*truth_pos, loc);
+        b.pos_samples++;
+        b.pos_sq_sum += sq(err);
+        b.pos_max = MAX(b.pos_max, err);
+    }
+}
+
+/*
+  run each estimator in turn, timing it, then compare the solutions
+ */
+void Replay::bench_update(void)
+{
+    bench_run(bench[BENCH_DCM],  &AP_AHRS_NavEKF::update_DCM);
+    bench_run(bench[BENCH_EKF1], &AP_AHRS_NavEKF::update_EKF1);
+    bench_run(bench[BENCH_EKF2], &AP_AHRS_NavEKF::update_EKF2);
+
+    // use simulator truth if the log has it, otherwise GPS for position
+    const Location *truth_pos = NULL;
+    if (logreader.have_sim()) {
+        truth_pos = &logreader.get_sim_position();
+        bench_pos_truth = "SIM";
+    } else if (_vehicle.gps.status() >= AP_GPS::GPS_OK_FIX_3D) {
+        truth_pos = &_vehicle.gps.location();
+        bench_pos_truth = "GPS";
+    }
+
+    Vector3f euler;
+    Location loc {};
+    bool pos_valid;
+
+    _vehicle.ahrs.AP_AHRS_DCM::get_rotation_body_to_ned().to_euler(&euler.x, &euler.y, &euler.z);
+    pos_valid = _vehicle.ahrs.AP_AHRS_DCM::get_position(loc);
+    bench_compare(bench[BENCH_DCM], true, euler, pos_valid, loc, truth_pos);
+
+    _vehicle.EKF.getEulerAngles(euler);
+    pos_valid = _vehicle.EKF.getLLH(loc);
+    bench_compare(bench[BENCH_EKF1], _vehicle.EKF.healthy(), euler, pos_valid, loc, truth_pos);
+
+    _vehicle.EKF2.getEulerAngles(-1, euler);
+    pos_valid = _vehicle.EKF2.getLLH(loc);
+    bench_compare(bench[BENCH_EKF2], _vehicle.EKF2.healthy(), euler, pos_valid, loc, truth_pos);
+}
+
+/*
+  append the results of --bench as one JSON object per line
+ */
+void Replay::bench_report(void)
+{
+    static const char *names[BENCH_NUM_ESTIMATORS] = { "DCM", "EKF1", "EKF2" };
+
+    struct rusage usage;
+    long peak_rss_kb = 0;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        peak_rss_kb = usage.ru_maxrss;
+    }
+
+    FILE *f = fopen(bench_filename, "a");
+    if (f == NULL) {
+        perror(bench_filename);
+        exit(1);
+    }
+    fprintf(f, "{\"log\": \"%s\", \"update_rate\": %u, \"att_truth\": \"%s\", \"pos_truth\": \"%s\", \"peak_rss_kb\": %ld, \"estimators\": {",
+            log_filename, (unsigned)log_info.update_rate,
+            logreader.have_sim() ? "SIM" : "none", bench_pos_truth, peak_rss_kb);
+    for (uint8_t i=0; i<BENCH_NUM_ESTIMATORS; i++) {
+        const struct bench_estimator &b = bench[i];
+        const double us_per_update = b.updates ? b.total_ns * 1.0e-3 / b.updates : 0;
+        fprintf(f, "%s\"%s\": {\"updates\": %u, \"us_per_update\": %.3f, \"max_us\": %.3f, \"heap_bytes\": %llu",
+                i ? ", " : "", names[i], (unsigned)b.updates, us_per_update, b.max_ns * 1.0e-3,
+                (unsigned long long)b.heap_bytes);
+        if (b.att_samples) {
+            fprintf(f, ", \"att_rms_deg\": %.4f, \"att_max_deg\": %.4f",
+                    sqrt(b.att_sq_sum / b.att_samples), b.att_max);
+        } else {
+            fprintf(f, ", \"att_rms_deg\": null, \"att_max_deg\": null");
+        }
+        if (b.pos_samples) {
+            fprintf(f, ", \"pos_rms_m\": %.4f, \"pos_max_m\": %.4f}",
+                    sqrt(b.pos_sq_sum / b.pos_samples), b.pos_max);
+        } else {
+            fprintf(f, ", \"pos_rms_m\": null, \"pos_max_m\": null}");
+        }
+        ::printf("%-4s %8u updates %8.2f us/update (max %.1f) heap %llu bytes\n",
+                 names[i], (unsigned)b.updates, us_per_update, b.max_ns * 1.0e-3,
+                 (unsigned long long)b.heap_bytes);
+    }
+    fprintf(f, "}}\n");
+    fclose(f);
+    ::printf("Peak RSS %ld kB, results appended to %s\n", peak_rss_kb, bench_filename);
+}
+
+
 bool Replay::show_error(const char *text, float max_error, float tolerance)
 {
     bool failed = max_error > tolerance;
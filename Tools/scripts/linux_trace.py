@@ -0,0 +1,138 @@
+#!/usr/bin/env python
+'''
+convert a trace written by the Linux HAL with --trace FILE
+
+  linux_trace.py trace.bin > trace.json             Chrome trace JSON, for chrome://tracing
+  linux_trace.py --folded trace.bin > trace.folded  folded stacks, for flamegraph.pl
+
+The file format is described in libraries/AP_HAL_Linux/Trace.h
+'''
+
+import json
+import struct
+import sys
+from argparse import ArgumentParser
+
+RECORD_NAME = 1
+RECORD_THREAD = 2
+RECORD_EVENTS = 3
+RECORD_DROPPED = 4
+
+EVENT_BEGIN = 1
+EVENT_END = 2
+EVENT_COUNT = 3
+
+EVENT_FORMAT = '<QHB'
+EVENT_SIZE = struct.calcsize(EVENT_FORMAT)
+
+
+def read_trace(filename):
+    '''return start time, names, thread names, per-thread events and drop counts'''
+    data = open(filename, 'rb').read()
+    if len(data) < 16 or data[0:4] != b'APTR':
+        raise ValueError("%s is not a trace file" % filename)
+    (version, start_ns) = struct.unpack('<H2xQ', data[4:16])
+    if version != 1:
+        raise ValueError("unsupported trace version %u" % version)
+
+    names = {}
+    threads = {}
+    events = {}
+    dropped = {}
+    ofs = 16
+    while ofs < len(data):
+        rtype = struct.unpack('<B', data[ofs:ofs+1])[0]
+        ofs += 1
+        try:
+            if rtype == RECORD_NAME:
+                (id, length) = struct.unpack('<HB', data[ofs:ofs+3])
+                names[id] = data[ofs+3:ofs+3+length].decode('utf-8', 'replace')
+                ofs += 3 + length
+            elif rtype == RECORD_THREAD:
+                (thread, length) = struct.unpack('<BB', data[ofs:ofs+2])
+                threads[thread] = data[ofs+2:ofs+2+length].decode('utf-8', 'replace')
+                ofs += 2 + length
+            elif rtype == RECORD_EVENTS:
+                (thread, count) = struct.unpack('<BH', data[ofs:ofs+3])
+                ofs += 3
+                thread_events = events.setdefault(thread, [])
+                for i in range(count):
+                    thread_events.append(struct.unpack(EVENT_FORMAT, data[ofs:ofs+EVENT_SIZE]))
+                    ofs += EVENT_SIZE
+            elif rtype == RECORD_DROPPED:
+                (thread, count) = struct.unpack('<BI', data[ofs:ofs+5])
+                dropped[thread] = count
+                ofs += 5
+            else:
+                sys.stderr.write("Unknown record type %u at offset %u\n" % (rtype, ofs-1))
+                break
+        except struct.error:
+            # file truncated while the vehicle was running
+            break
+    return (start_ns, names, threads, events, dropped)
+
+
+def chrome_trace(start_ns, names, threads, events):
+    out = []
+    for (thread, name) in threads.items():
+        out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": thread,
+                    "args": {"name": name}})
+    phase = {EVENT_BEGIN: "B", EVENT_END: "E"}
+    for (thread, thread_events) in events.items():
+        counts = {}
+        for (time_ns, id, etype) in thread_events:
+            name = names.get(id, "id%u" % id)
+            ts = (time_ns - start_ns) * 0.001
+            if etype == EVENT_COUNT:
+                counts[id] = counts.get(id, 0) + 1
+                out.append({"name": name, "ph": "C", "pid": 1, "tid": thread,
+                            "ts": ts, "args": {"count": counts[id]}})
+            elif etype in phase:
+                out.append({"name": name, "ph": phase[etype], "pid": 1, "tid": thread, "ts": ts})
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+def folded_stacks(names, threads, events):
+    '''microseconds of self time for each stack of begin/end events'''
+    totals = {}
+    for (thread, thread_events) in events.items():
+        root = threads.get(thread, "thread%u" % thread)
+        stack = []
+        last_ns = None
+        for (time_ns, id, etype) in thread_events:
+            if etype == EVENT_COUNT:
+                continue
+            if stack and last_ns is not None:
+                key = ';'.join([root] + stack)
+                totals[key] = totals.get(key, 0) + (time_ns - last_ns)
+            last_ns = time_ns
+            name = names.get(id, "id%u" % id)
+            if etype == EVENT_BEGIN:
+                stack.append(name)
+            elif etype == EVENT_END:
+                # tolerate unbalanced events from the start of the trace
+                if name in stack:
+                    while stack and stack.pop() != name:
+                        pass
+    lines = []
+    for key in sorted(totals.keys()):
+        us = totals[key] // 1000
+        if us > 0:
+            lines.append("%s %u" % (key, us))
+    return lines
+
+
+parser = ArgumentParser(description=__doc__)
+parser.add_argument("--folded", action='store_true', help="output folded stacks instead of Chrome trace JSON")
+parser.add_argument("trace", metavar="TRACE")
+args = parser.parse_args()
+
+(start_ns, names, threads, events, dropped) = read_trace(args.trace)
+for (thread, count) in dropped.items():
+    sys.stderr.write("%s: %u events dropped\n" % (threads.get(thread, "thread%u" % thread), count))
+
+if args.folded:
+    for line in folded_stacks(names, threads, events):
+        print(line)
+else:
+    json.dump(chrome_trace(start_ns, names, threads, events), sys.stdout)
@@ -15,7 +15,7 @@ const AP_Param::GroupInfo AC_Fence::var_info[] = {
     // @Param: TYPE
     // @DisplayName: Fence Type
     // @Description: Enabled fence types held as bitmask
-    // @Values: 0:None,1:Altitude,2:Circle,3:Altitude and Circle
+    // @Values: 0:None,1:Altitude,2:Circle,3:Altitude and Circle,4:Polygon,6:Circle and Polygon,7:All
     // @User: Standard
     AP_GROUPINFO("TYPE",        1,  AC_Fence,   _enabled_fences,  AC_FENCE_TYPE_ALT_MAX | AC_FENCE_TYPE_CIRCLE),
 
@@ -62,6 +62,10 @@ AC_Fence::AC_Fence(const AP_InertialNav& inav) :
     _alt_max_breach_distance(0),
     _circle_breach_distance(0),
     _home_distance(0),
+    _poly_loaded_ms(0),
+    _poly_loaded(false),
+    _polygon_breach_distance(0),
+    _polygon_breach_backup(0),
     _breached_fences(AC_FENCE_TYPE_NONE),
     _breach_time(0),
     _breach_count(0),
@@ -102,7 +106,7 @@ bool AC_Fence::pre_arm_check() const
     }
 
     // if we have horizontal limits enabled, check inertial nav position is ok
-    if ((_enabled_fences & AC_FENCE_TYPE_CIRCLE)!=0 && !_inav.get_filter_status().flags.horiz_pos_abs && !_inav.get_filter_status().flags.pred_horiz_pos_abs) {
+    if ((_enabled_fences & (AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON))!=0 && !_inav.get_filter_status().flags.horiz_pos_abs && !_inav.get_filter_status().flags.pred_horiz_pos_abs) {
         return false;
     }
 
@@ -190,11 +194,51 @@ uint8_t AC_Fence::check_fence(float curr_alt)
         }
     }
 
+    // polygon and exclusion zone check
+    if ((_enabled_fences & AC_FENCE_TYPE_POLYGON) != 0) {
+
+        // reload the fence from storage if it has changed
+        if (!_poly_loaded || _poly_fence.last_change_ms() != _poly_loaded_ms) {
+            _poly_fence.load();
+            _poly_loaded = true;
+            _poly_loaded_ms = _poly_fence.last_change_ms();
+        }
+
+        // without a position estimate the fence state is unknown, so any
+        // existing breach is held until we know we are back inside
+        Location loc;
+        float distance;
+        if (!_inav.get_location(loc)) {
+            // leave the breach state unchanged
+        } else if (_poly_fence.check(loc, distance)) {
+
+            // record distance beyond the breached boundary
+            _polygon_breach_distance = distance;
+
+            // check for a new breach or moving further beyond the fence since the last breach
+            if ((_breached_fences & AC_FENCE_TYPE_POLYGON) == 0 || (!is_zero(_polygon_breach_backup) && distance >= _polygon_breach_backup)) {
+
+                // record that we have breached the polygon fence
+                record_breach(AC_FENCE_TYPE_POLYGON);
+                ret = ret | AC_FENCE_TYPE_POLYGON;
+
+                // refire if we move another 20m beyond the fence
+                _polygon_breach_backup = distance + AC_FENCE_POLYGON_BACKUP_DISTANCE;
+            }
+        }else{
+            // clear polygon breach if present
+            if ((_breached_fences & AC_FENCE_TYPE_POLYGON) != 0) {
+                clear_breach(AC_FENCE_TYPE_POLYGON);
+                _polygon_breach_backup = 0.0f;
+                _polygon_breach_distance = 0.0f;
+            }
+        }
+    }
+
     // return any new breaches that have occurred
     return ret;
 
-    // To-Do: add min alt and polygon check
-    //outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+    // To-Do: add min alt check
 }
 
 /// record_breach - update breach bitmask, time and count
@@ -240,6 +284,18 @@ float AC_Fence::get_breach_distance(uint8_t fence_type) const
             return MAX(_alt_max_breach_distance,_circle_breach_distance);
     }
 
+    // combinations including the polygon fence return the largest breach distance
+    if ((fence_type & AC_FENCE_TYPE_POLYGON) != 0) {
+        float distance = _polygon_breach_distance;
+        if ((fence_type & AC_FENCE_TYPE_ALT_MAX) != 0) {
+            distance = MAX(distance, _alt_max_breach_distance);
+        }
+        if ((fence_type & AC_FENCE_TYPE_CIRCLE) != 0) {
+            distance = MAX(distance, _circle_breach_distance);
+        }
+        return distance;
+    }
+
     // we don't recognise the fence type so just return 0
     return 0;
 }
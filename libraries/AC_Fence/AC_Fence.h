@@ -7,11 +7,13 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_InertialNav/AP_InertialNav.h>     // Inertial Navigation library
+#include "AC_PolyFence.h"
 
 // bit masks for enabled fence types.  Used for TYPE parameter
 #define AC_FENCE_TYPE_NONE                          0       // fence disabled
 #define AC_FENCE_TYPE_ALT_MAX                       1       // high alt fence which usually initiates an RTL
 #define AC_FENCE_TYPE_CIRCLE                        2       // circular horizontal fence (usually initiates an RTL)
+#define AC_FENCE_TYPE_POLYGON                       4       // inclusion and exclusion polygons and circles held in storage
 
 // valid actions should a fence be breached
 #define AC_FENCE_ACTION_REPORT_ONLY                 0       // report to GCS that boundary has been breached but take no further action
@@ -22,6 +24,7 @@
 #define AC_FENCE_CIRCLE_RADIUS_DEFAULT              300.0f  // default circular fence radius is 300m
 #define AC_FENCE_ALT_MAX_BACKUP_DISTANCE            20.0f   // after fence is broken we recreate the fence 20m further up
 #define AC_FENCE_CIRCLE_RADIUS_BACKUP_DISTANCE      20.0f   // after fence is broken we recreate the fence 20m further out
+#define AC_FENCE_POLYGON_BACKUP_DISTANCE            20.0f   // after polygon fence is broken we refire the breach if we move another 20m beyond it
 #define AC_FENCE_MARGIN_DEFAULT                     2.0f    // default distance in meters that autopilot's should maintain from the fence to avoid a breach
 
 // give up distance
@@ -85,6 +88,14 @@ public:
     /// set_home_distance - update vehicle's distance from home in meters - required for circular horizontal fence monitoring
     void set_home_distance(float distance) { _home_distance = distance; }
 
+    ///
+    /// polygon fence
+    ///
+
+    /// polyfence - access to the polygon and exclusion zone store, used to upload new fence items
+    ///     changes are picked up by the next call to check_fence
+    AC_PolyFence &polyfence() { return _poly_fence; }
+
     static const struct AP_Param::GroupInfo var_info[];
 
 private:
@@ -117,6 +128,13 @@ private:
     // other internal variables
     float           _home_distance;         // distance from home in meters (provided by main code)
 
+    // polygon fence
+    AC_PolyFence    _poly_fence;                // inclusion and exclusion polygons and circles
+    uint32_t        _poly_loaded_ms;            // last_change_ms of the polygon fence when it was last loaded
+    bool            _poly_loaded;               // true once the polygon fence has been read from storage
+    float           _polygon_breach_distance;   // distance beyond the polygon fence
+    float           _polygon_breach_backup;     // breach distance at which the polygon breach is refired
+
     // breach information
     uint8_t         _breached_fences;       // bitmask holding the fence type that was breached (i.e. AC_FENCE_TYPE_ALT_MIN, AC_FENCE_TYPE_CIRCLE)
     uint32_t        _breach_time;           // time of last breach in milliseconds
@@ -0,0 +1,481 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#include <AP_HAL/AP_HAL.h>
+#include "AC_PolyFence.h"
+
+extern const AP_HAL::HAL& hal;
+
+// storage object
+StorageAccess AC_PolyFence::_storage(StorageManager::StorageFence);
+
+// sizes of the fixed parts of the storage format
+#define AC_POLYFENCE_HEADER_SIZE        3       // magic and item count
+#define AC_POLYFENCE_ITEM_HEADER_SIZE   2       // type and number of points
+#define AC_POLYFENCE_POINT_SIZE         8       // lat and lng as int32
+#define AC_POLYFENCE_RADIUS_SIZE        4       // circle radius as float
+
+/// Default constructor.
+AC_PolyFence::AC_PolyFence() :
+    _items(NULL),
+    _points(NULL),
+    _num_items(0),
+    _num_points(0),
+    _inclusion_mask(0),
+    _ltp(),
+    _grid(NULL),
+    _write_offset(0),
+    _stored_items(0),
+    _last_change_ms(0),
+    _upload(NULL),
+    _upload_count(0),
+    _upload_next(0)
+{
+}
+
+/// clear - remove all items from storage and the evaluator
+void AC_PolyFence::clear()
+{
+    _storage.write_uint16(0, AC_POLYFENCE_MAGIC);
+    _storage.write_byte(2, 0);
+    _write_offset = AC_POLYFENCE_HEADER_SIZE;
+    _stored_items = 0;
+    _last_change_ms = AP_HAL::millis();
+    free_items();
+}
+
+/// add_polygon - append a polygon to storage
+bool AC_PolyFence::add_polygon(ItemType type, const Vector2l *points, uint8_t num_points)
+{
+    if (type != ITEM_POLYGON_INCLUSION && type != ITEM_POLYGON_EXCLUSION) {
+        return false;
+    }
+    if (points == NULL || num_points < AC_POLYFENCE_POLYGON_MIN_POINTS) {
+        return false;
+    }
+    return append_item(type, num_points, points, 0.0f);
+}
+
+/// add_circle - append a circle to storage
+bool AC_PolyFence::add_circle(ItemType type, const Vector2l &center, float radius)
+{
+    if (type != ITEM_CIRCLE_INCLUSION && type != ITEM_CIRCLE_EXCLUSION) {
+        return false;
+    }
+    if (radius <= 0.0f) {
+        return false;
+    }
+    return append_item(type, 1, &center, radius);
+}
+
+// storage_item_size - returns number of bytes used in storage by an item, zero if the item is invalid
+uint16_t AC_PolyFence::storage_item_size(uint8_t type, uint8_t num_points) const
+{
+    switch (type) {
+    case ITEM_POLYGON_INCLUSION:
+    case ITEM_POLYGON_EXCLUSION:
+        if (num_points < AC_POLYFENCE_POLYGON_MIN_POINTS) {
+            return 0;
+        }
+        return AC_POLYFENCE_ITEM_HEADER_SIZE + num_points * AC_POLYFENCE_POINT_SIZE;
+    case ITEM_CIRCLE_INCLUSION:
+    case ITEM_CIRCLE_EXCLUSION:
+        if (num_points != 1) {
+            return 0;
+        }
+        return AC_POLYFENCE_ITEM_HEADER_SIZE + AC_POLYFENCE_POINT_SIZE + AC_POLYFENCE_RADIUS_SIZE;
+    }
+    return 0;
+}
+
+// append_item - write an item to the end of storage and update the item count
+bool AC_PolyFence::append_item(uint8_t type, uint8_t num_points, const Vector2l *points, float radius)
+{
+    // start a new fence if storage does not hold a valid one
+    if (_write_offset == 0) {
+        clear();
+    }
+
+    if (_stored_items >= AC_POLYFENCE_MAX_ITEMS) {
+        return false;
+    }
+
+    uint16_t size = storage_item_size(type, num_points);
+    if (size == 0 || _write_offset + size > _storage.size()) {
+        return false;
+    }
+
+    uint16_t ofs = _write_offset;
+    _storage.write_byte(ofs++, type);
+    _storage.write_byte(ofs++, num_points);
+    for (uint8_t i=0; i<num_points; i++) {
+        _storage.write_uint32(ofs, (uint32_t)points[i].x);
+        _storage.write_uint32(ofs+4, (uint32_t)points[i].y);
+        ofs += AC_POLYFENCE_POINT_SIZE;
+    }
+    if (type == ITEM_CIRCLE_INCLUSION || type == ITEM_CIRCLE_EXCLUSION) {
+        _storage.write_block(ofs, &radius, sizeof(radius));
+    }
+
+    // only bump the count once the item is completely written
+    _write_offset += size;
+    _stored_items++;
+    _storage.write_byte(2, _stored_items);
+    _last_change_ms = AP_HAL::millis();
+    return true;
+}
+
+/// handle_point - accept one point of a fence upload
+bool AC_PolyFence::handle_point(uint8_t idx, uint8_t count, float lat, float lng)
+{
+    if (idx == 0) {
+        abandon_upload();
+        if (count == 0) {
+            return false;
+        }
+        _upload = (Vector2f *)calloc(count, sizeof(Vector2f));
+        if (_upload == NULL) {
+            return false;
+        }
+        _upload_count = count;
+    }
+    if (_upload == NULL || idx != _upload_next || count != _upload_count) {
+        abandon_upload();
+        return false;
+    }
+    if (isnan(lat) || isnan(lng)) {
+        abandon_upload();
+        return false;
+    }
+    _upload[idx] = Vector2f(lat, lng);
+    _upload_next++;
+
+    if (_upload_next < _upload_count) {
+        return true;
+    }
+    bool ret = commit_upload();
+    abandon_upload();
+    return ret;
+}
+
+// commit_upload - validate a complete upload and replace the stored fence with it
+bool AC_PolyFence::commit_upload()
+{
+    // first pass checks every item and that they all fit, so storage
+    // is not touched unless the whole fence can be written
+    uint16_t size = AC_POLYFENCE_HEADER_SIZE;
+    uint8_t items = 0;
+    for (uint8_t i=0; i<_upload_count; ) {
+        const float type_f = _upload[i].x - AC_POLYFENCE_HEADER_LAT;
+        if (type_f < 0.0f || type_f > 255.0f || !is_equal(type_f, roundf(type_f))) {
+            return false;
+        }
+        const uint8_t type = (uint8_t)type_f;
+        const bool circle = (type == ITEM_CIRCLE_INCLUSION || type == ITEM_CIRCLE_EXCLUSION);
+        const uint8_t num_points = circle ? 1 : (uint8_t)constrain_float(_upload[i].y, 0.0f, 255.0f);
+        const uint16_t item_size = storage_item_size(type, num_points);
+        if (item_size == 0 || i + 1 + num_points > _upload_count ||
+            ++items > AC_POLYFENCE_MAX_ITEMS ||
+            (circle && _upload[i].y <= 0.0f)) {
+            return false;
+        }
+        for (uint8_t p=i+1; p<=i+num_points; p++) {
+            if (fabsf(_upload[p].x) > 90.0f || fabsf(_upload[p].y) > 180.0f) {
+                return false;
+            }
+        }
+        size += item_size;
+        i += 1 + num_points;
+    }
+    if (size > _storage.size()) {
+        return false;
+    }
+
+    Vector2l *points = (Vector2l *)calloc(_upload_count, sizeof(Vector2l));
+    if (points == NULL) {
+        return false;
+    }
+    clear();
+    bool ret = true;
+    for (uint8_t i=0; i<_upload_count && ret; ) {
+        const uint8_t type = (uint8_t)(_upload[i].x - AC_POLYFENCE_HEADER_LAT);
+        const bool circle = (type == ITEM_CIRCLE_INCLUSION || type == ITEM_CIRCLE_EXCLUSION);
+        const uint8_t num_points = circle ? 1 : (uint8_t)_upload[i].y;
+        for (uint8_t p=0; p<num_points; p++) {
+            points[p].x = _upload[i+1+p].x * 1.0e7f;
+            points[p].y = _upload[i+1+p].y * 1.0e7f;
+        }
+        ret = append_item(type, num_points, points, circle ? _upload[i].y : 0.0f);
+        i += 1 + num_points;
+    }
+    free(points);
+    return ret;
+}
+
+// abandon_upload - free the buffer of an upload
+void AC_PolyFence::abandon_upload()
+{
+    free(_upload);
+    _upload = NULL;
+    _upload_count = 0;
+    _upload_next = 0;
+}
+
+/// download_count - number of FENCE_POINT messages needed to send the stored fence
+uint8_t AC_PolyFence::download_count() const
+{
+    if (_storage.read_uint16(0) != AC_POLYFENCE_MAGIC) {
+        return 0;
+    }
+    const uint8_t count = MIN(_storage.read_byte(2), AC_POLYFENCE_MAX_ITEMS);
+    uint16_t ofs = AC_POLYFENCE_HEADER_SIZE;
+    uint16_t total = 0;
+    for (uint8_t i=0; i<count; i++) {
+        const uint8_t num_points = _storage.read_byte(ofs+1);
+        const uint16_t size = storage_item_size(_storage.read_byte(ofs), num_points);
+        if (size == 0 || ofs + size > _storage.size()) {
+            break;
+        }
+        total += 1 + num_points;
+        ofs += size;
+    }
+    return MIN(total, 255);
+}
+
+/// get_point - returns point idx of the stored fence in FENCE_POINT form
+bool AC_PolyFence::get_point(uint8_t idx, float &lat, float &lng) const
+{
+    if (idx >= download_count()) {
+        return false;
+    }
+    uint16_t ofs = AC_POLYFENCE_HEADER_SIZE;
+    for (;;) {
+        const uint8_t type = _storage.read_byte(ofs);
+        const uint8_t num_points = _storage.read_byte(ofs+1);
+        if (idx == 0) {
+            lat = AC_POLYFENCE_HEADER_LAT + type;
+            if (type == ITEM_CIRCLE_INCLUSION || type == ITEM_CIRCLE_EXCLUSION) {
+                _storage.read_block(&lng, ofs + AC_POLYFENCE_ITEM_HEADER_SIZE + AC_POLYFENCE_POINT_SIZE, sizeof(lng));
+            } else {
+                lng = num_points;
+            }
+            return true;
+        }
+        if (idx <= num_points) {
+            const uint16_t pofs = ofs + AC_POLYFENCE_ITEM_HEADER_SIZE + (idx-1) * AC_POLYFENCE_POINT_SIZE;
+            lat = (int32_t)_storage.read_uint32(pofs) * 1.0e-7f;
+            lng = (int32_t)_storage.read_uint32(pofs+4) * 1.0e-7f;
+            return true;
+        }
+        idx -= 1 + num_points;
+        ofs += storage_item_size(type, num_points);
+    }
+}
+
+// free_items - release RAM copies of the fence
+void AC_PolyFence::free_items()
+{
+    free(_items);
+    free(_points);
+    free(_grid);
+    _items = NULL;
+    _points = NULL;
+    _grid = NULL;
+    _num_items = 0;
+    _num_points = 0;
+    _inclusion_mask = 0;
+}
+
+/// load - read all items from storage and rebuild the spatial index
+bool AC_PolyFence::load()
+{
+    free_items();
+    _write_offset = 0;
+    _stored_items = 0;
+
+    if (_storage.size() < AC_POLYFENCE_HEADER_SIZE || _storage.read_uint16(0) != AC_POLYFENCE_MAGIC) {
+        return false;
+    }
+    uint8_t count = _storage.read_byte(2);
+    if (count > AC_POLYFENCE_MAX_ITEMS) {
+        return false;
+    }
+
+    // first pass validates the item headers and counts the vertices
+    uint16_t ofs = AC_POLYFENCE_HEADER_SIZE;
+    uint16_t total_points = 0;
+    for (uint8_t i=0; i<count; i++) {
+        if (ofs + AC_POLYFENCE_ITEM_HEADER_SIZE > _storage.size()) {
+            return false;
+        }
+        uint16_t size = storage_item_size(_storage.read_byte(ofs), _storage.read_byte(ofs+1));
+        if (size == 0 || ofs + size > _storage.size()) {
+            return false;
+        }
+        total_points += _storage.read_byte(ofs+1);
+        ofs += size;
+    }
+
+    // storage is valid so further items can be appended after the last one
+    _write_offset = ofs;
+    _stored_items = count;
+
+    if (count == 0) {
+        return true;
+    }
+
+    _items = (Item *)calloc(count, sizeof(Item));
+    _points = (Vector2f *)calloc(total_points, sizeof(Vector2f));
+    _grid = (uint32_t *)calloc(AC_POLYFENCE_GRID_SIZE * AC_POLYFENCE_GRID_SIZE, sizeof(uint32_t));
+    if (_items == NULL || _points == NULL || _grid == NULL) {
+        free_items();
+        return false;
+    }
+
+    // second pass reads the vertices, converting them to meters from the first vertex
+    ofs = AC_POLYFENCE_HEADER_SIZE;
+    for (uint8_t i=0; i<count; i++) {
+        Item &item = _items[i];
+        item.type = _storage.read_byte(ofs);
+        item.num_points = _storage.read_byte(ofs+1);
+        item.first_point = _num_points;
+        ofs += AC_POLYFENCE_ITEM_HEADER_SIZE;
+
+        // vertices are stored as consecutive lat/lng pairs, so read them
+        // in blocks and convert each block in one pass
+        for (uint8_t p=0; p<item.num_points; ) {
+            Vector2l latlng[8];
+            uint8_t n = MIN(item.num_points - p, (int)ARRAY_SIZE(latlng));
+            _storage.read_block(latlng, ofs, n * AC_POLYFENCE_POINT_SIZE);
+            ofs += n * AC_POLYFENCE_POINT_SIZE;
+            if (_num_points == 0) {
+                Location origin = {};
+                origin.lat = latlng[0].x;
+                origin.lng = latlng[0].y;
+                _ltp.set_origin(origin);
+            }
+            _ltp.diff(latlng, &_points[_num_points], n);
+            _num_points += n;
+            p += n;
+        }
+        for (uint8_t p=0; p<item.num_points; p++) {
+            const Vector2f &pt = _points[item.first_point + p];
+            if (p == 0) {
+                item.bbox_min = item.bbox_max = pt;
+            } else {
+                item.bbox_min.x = MIN(item.bbox_min.x, pt.x);
+                item.bbox_min.y = MIN(item.bbox_min.y, pt.y);
+                item.bbox_max.x = MAX(item.bbox_max.x, pt.x);
+                item.bbox_max.y = MAX(item.bbox_max.y, pt.y);
+            }
+        }
+
+        if (item.type == ITEM_CIRCLE_INCLUSION || item.type == ITEM_CIRCLE_EXCLUSION) {
+            _storage.read_block(&item.radius, ofs, sizeof(item.radius));
+            ofs += AC_POLYFENCE_RADIUS_SIZE;
+            if (isnan(item.radius) || item.radius <= 0.0f) {
+                free_items();
+                return false;
+            }
+            item.bbox_min -= Vector2f(item.radius, item.radius);
+            item.bbox_max += Vector2f(item.radius, item.radius);
+        }
+
+        if (item.type == ITEM_POLYGON_INCLUSION || item.type == ITEM_CIRCLE_INCLUSION) {
+            _inclusion_mask |= (1UL << i);
+        }
+    }
+    _num_items = count;
+
+    // size the grid to cover the bounding box of all items
+    Vector2f grid_max = _items[0].bbox_max;
+    _grid_min = _items[0].bbox_min;
+    for (uint8_t i=1; i<_num_items; i++) {
+        _grid_min.x = MIN(_grid_min.x, _items[i].bbox_min.x);
+        _grid_min.y = MIN(_grid_min.y, _items[i].bbox_min.y);
+        grid_max.x = MAX(grid_max.x, _items[i].bbox_max.x);
+        grid_max.y = MAX(grid_max.y, _items[i].bbox_max.y);
+    }
+    _grid_cell_inv.x = AC_POLYFENCE_GRID_SIZE / MAX(grid_max.x - _grid_min.x, 1.0f);
+    _grid_cell_inv.y = AC_POLYFENCE_GRID_SIZE / MAX(grid_max.y - _grid_min.y, 1.0f);
+
+    // mark each cell with the items whose bounding box overlaps it
+    for (uint8_t i=0; i<_num_items; i++) {
+        const Item &item = _items[i];
+        int16_t x_min = constrain_int16((item.bbox_min.x - _grid_min.x) * _grid_cell_inv.x, 0, AC_POLYFENCE_GRID_SIZE-1);
+        int16_t x_max = constrain_int16((item.bbox_max.x - _grid_min.x) * _grid_cell_inv.x, 0, AC_POLYFENCE_GRID_SIZE-1);
+        int16_t y_min = constrain_int16((item.bbox_min.y - _grid_min.y) * _grid_cell_inv.y, 0, AC_POLYFENCE_GRID_SIZE-1);
+        int16_t y_max = constrain_int16((item.bbox_max.y - _grid_min.y) * _grid_cell_inv.y, 0, AC_POLYFENCE_GRID_SIZE-1);
+        for (int16_t x=x_min; x<=x_max; x++) {
+            for (int16_t y=y_min; y<=y_max; y++) {
+                _grid[x * AC_POLYFENCE_GRID_SIZE + y] |= (1UL << i);
+            }
+        }
+    }
+
+    return true;
+}
+
+// cell_mask - returns the bitmask of items which may contain the position, zero if outside the grid
+uint32_t AC_PolyFence::cell_mask(const Vector2f &pos) const
+{
+    float x = (pos.x - _grid_min.x) * _grid_cell_inv.x;
+    float y = (pos.y - _grid_min.y) * _grid_cell_inv.y;
+    if (x < 0.0f || y < 0.0f || x >= AC_POLYFENCE_GRID_SIZE || y >= AC_POLYFENCE_GRID_SIZE) {
+        return 0;
+    }
+    return _grid[(uint16_t)x * AC_POLYFENCE_GRID_SIZE + (uint16_t)y];
+}
+
+// item_contains - returns true if the position is within the item
+bool AC_PolyFence::item_contains(const Item &item, const Vector2f &pos) const
+{
+    // cheap bounding box rejection before the vertex walk
+    if (pos.x < item.bbox_min.x || pos.x > item.bbox_max.x ||
+        pos.y < item.bbox_min.y || pos.y > item.bbox_max.y) {
+        return false;
+    }
+    const Vector2f *pts = &_points[item.first_point];
+    if (item.type == ITEM_CIRCLE_INCLUSION || item.type == ITEM_CIRCLE_EXCLUSION) {
+        return (pos - pts[0]).length() <= item.radius;
+    }
+    return !Polygon_outside(pos, pts, item.num_points);
+}
+
+// item_boundary_distance - returns distance in meters from the position to the edge of the item
+float AC_PolyFence::item_boundary_distance(const Item &item, const Vector2f &pos) const
+{
+    const Vector2f *pts = &_points[item.first_point];
+    if (item.type == ITEM_CIRCLE_INCLUSION || item.type == ITEM_CIRCLE_EXCLUSION) {
+        return fabsf((pos - pts[0]).length() - item.radius);
+    }
+    return Polygon_distance(pos, pts, item.num_points);
+}
+
+/// check - returns true if the location is outside any inclusion item or inside any exclusion item
+bool AC_PolyFence::check(const Location &loc, float &distance) const
+{
+    distance = 0.0f;
+    if (_num_items == 0) {
+        return false;
+    }
+
+    const Vector2f pos = _ltp.diff(loc);
+    const uint32_t mask = cell_mask(pos);
+    bool breached = false;
+
+    for (uint8_t i=0; i<_num_items; i++) {
+        const uint32_t bit = (1UL << i);
+        bool item_breached;
+        if ((_inclusion_mask & bit) != 0) {
+            // inclusion items that do not touch this cell cannot contain us
+            item_breached = (mask & bit) == 0 || !item_contains(_items[i], pos);
+        } else {
+            item_breached = (mask & bit) != 0 && item_contains(_items[i], pos);
+        }
+        if (item_breached) {
+            breached = true;
+            distance = MAX(distance, item_boundary_distance(_items[i], pos));
+        }
+    }
+
+    return breached;
+}
@@ -0,0 +1,159 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#ifndef AC_POLYFENCE_H
+#define AC_POLYFENCE_H
+
+/*
+ * AC_PolyFence - holds a set of inclusion and exclusion polygons and
+ * circles in the fence storage area and checks a position against them.
+ *
+ * Items are stored back to back in the fence StorageAccess area as
+ *
+ *   header:  uint16 magic, uint8 item count
+ *   polygon: uint8 type, uint8 num_points, num_points * (int32 lat, int32 lng)
+ *   circle:  uint8 type, uint8 1, int32 lat, int32 lng, float radius (meters)
+ *
+ * Fences are uploaded and downloaded as FENCE_POINT messages. Each item
+ * is sent as a header point followed by its vertices, or its center for
+ * a circle. A header point has lat set to AC_POLYFENCE_HEADER_LAT plus
+ * the item type, and lng set to the number of vertices of a polygon or
+ * the radius in meters of a circle. The count field of each message is
+ * the total number of points, headers included.
+ *
+ * On load the vertices are converted to meters north/east of the first
+ * vertex and a coarse grid is laid over the bounding box of the whole
+ * fence set. Each grid cell holds a bitmask of the items whose bounding
+ * box overlaps it, so a check only walks the items near the vehicle.
+ */
+
+#include <inttypes.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <StorageManager/StorageManager.h>
+
+#define AC_POLYFENCE_MAGIC              0x4650  // "PF" marker at the start of the fence storage area
+#define AC_POLYFENCE_MAX_ITEMS          32      // maximum number of polygons and circles (one bit per item in each grid cell)
+#define AC_POLYFENCE_GRID_SIZE          16      // grid is AC_POLYFENCE_GRID_SIZE x AC_POLYFENCE_GRID_SIZE cells
+#define AC_POLYFENCE_POLYGON_MIN_POINTS 3       // minimum number of vertices in a polygon
+#define AC_POLYFENCE_HEADER_LAT         100.0f  // FENCE_POINT latitude of item headers, less the item type
+
+class AC_PolyFence
+{
+public:
+
+    // types of fence items held in storage
+    enum ItemType {
+        ITEM_NONE                = 0,
+        ITEM_POLYGON_INCLUSION   = 1,   // vehicle must remain inside the polygon
+        ITEM_POLYGON_EXCLUSION   = 2,   // vehicle must remain outside the polygon
+        ITEM_CIRCLE_INCLUSION    = 3,   // vehicle must remain inside the circle
+        ITEM_CIRCLE_EXCLUSION    = 4    // vehicle must remain outside the circle
+    };
+
+    /// Constructor
+    AC_PolyFence();
+
+    ///
+    /// storage methods
+    ///
+
+    /// clear - remove all items from storage and the evaluator
+    void clear();
+
+    /// add_polygon - append a polygon to storage.  points should not repeat the first vertex at the end
+    ///     returns false if the item does not fit or is invalid
+    bool add_polygon(ItemType type, const Vector2l *points, uint8_t num_points);
+
+    /// add_circle - append a circle to storage.  center is lat/lng in 1e-7 degrees, radius in meters
+    ///     returns false if the item does not fit or is invalid
+    bool add_circle(ItemType type, const Vector2l &center, float radius);
+
+    /// load - read all items from storage and rebuild the spatial index
+    ///     returns false if storage holds no valid fence
+    bool load();
+
+    /// num_items - number of items loaded into the evaluator
+    uint8_t num_items() const { return _num_items; }
+
+    /// has_inclusion - true if at least one inclusion item is loaded
+    bool has_inclusion() const { return _inclusion_mask != 0; }
+
+    /// last_change_ms - system time of last change to the stored fence
+    uint32_t last_change_ms() const { return _last_change_ms; }
+
+    ///
+    /// upload and download as FENCE_POINT messages
+    ///
+
+    /// handle_point - accept point idx of count from an upload.  idx 0 starts a new upload.
+    ///     the stored fence is only replaced once the last point has arrived and the whole upload is valid
+    ///     returns false if the point is rejected, which abandons the upload
+    bool handle_point(uint8_t idx, uint8_t count, float lat, float lng);
+
+    /// download_count - number of FENCE_POINT messages needed to send the stored fence
+    uint8_t download_count() const;
+
+    /// get_point - returns point idx of the stored fence in FENCE_POINT form
+    bool get_point(uint8_t idx, float &lat, float &lng) const;
+
+    ///
+    /// evaluation
+    ///
+
+    /// check - returns true if the location is outside any inclusion item or inside any exclusion item
+    ///     distance is set to the distance in meters the location is beyond the breached boundary
+    bool check(const Location &loc, float &distance) const;
+
+private:
+
+    // item held in RAM by the evaluator.  Circles use a single point for the center
+    struct Item {
+        uint8_t     type;
+        uint8_t     num_points;
+        uint16_t    first_point;
+        float       radius;
+        Vector2f    bbox_min;
+        Vector2f    bbox_max;
+    };
+
+    // storage helpers
+    uint16_t storage_item_size(uint8_t type, uint8_t num_points) const;
+    bool append_item(uint8_t type, uint8_t num_points, const Vector2l *points, float radius);
+
+    // release RAM copies of the fence
+    void free_items();
+
+    // upload helpers
+    bool commit_upload();
+    void abandon_upload();
+
+    // evaluation helpers
+    bool item_contains(const Item &item, const Vector2f &pos) const;
+    float item_boundary_distance(const Item &item, const Vector2f &pos) const;
+    uint32_t cell_mask(const Vector2f &pos) const;
+
+    static StorageAccess _storage;
+
+    // RAM copy of fence
+    Item        *_items;
+    Vector2f    *_points;                   // vertices in meters north/east of the first vertex
+    uint8_t     _num_items;
+    uint16_t    _num_points;
+    uint32_t    _inclusion_mask;            // bitmask of items which are inclusion fences
+    LocationLTP _ltp;                       // tangent plane at the first vertex that vertices are relative to
+
+    // spatial index
+    Vector2f    _grid_min;                  // north/east corner of the grid in meters from the first vertex
+    Vector2f    _grid_cell_inv;             // inverse of the cell size in meters
+    uint32_t    *_grid;                     // AC_POLYFENCE_GRID_SIZE^2 item bitmasks, row major by north index
+
+    // storage state
+    uint16_t    _write_offset;              // offset in storage at which the next item will be written
+    uint8_t     _stored_items;              // number of items currently in storage
+    uint32_t    _last_change_ms;
+
+    // upload state
+    Vector2f    *_upload;                   // points received so far, as lat/lng in degrees
+    uint8_t     _upload_count;              // number of points in the upload
+    uint8_t     _upload_next;               // index of the next point expected
+};
+#endif	// AC_POLYFENCE_H
@@ -136,8 +136,12 @@ void AP_ADSB::perform_threat_detection(void)
     uint16_t min_distance_index = 0;
     uint16_t max_distance_index = 0;
 
+    // the longitude scale of our own position is shared by all vehicles
+    LocationLTP ltp;
+    ltp.set_origin(my_loc);
+
     for (uint16_t index = 0; index < _vehicle_count; index++) {
-        float distance = get_distance(my_loc, get_location(_vehicle_list[index]));
+        float distance = ltp.distance(get_location(_vehicle_list[index]));
         if (min_distance > distance || index == 0) {
             min_distance = distance;
             min_distance_index = index;
@@ -0,0 +1,90 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_AHRS_Driver.h"
+
+extern const AP_HAL::HAL& hal;
+
+AP_AHRS_Driver::AP_AHRS_Driver(AP_AHRS &ahrs, AP_InertialSensor &ins, AP_Baro &baro,
+                               Compass &compass, AP_GPS &gps, AP_Airspeed &airspeed) :
+    _ahrs(ahrs),
+    _ins(ins),
+    _baro(baro),
+    _compass(compass),
+    _gps(gps),
+    _airspeed(airspeed),
+    _time_us(0)
+{
+}
+
+void AP_AHRS_Driver::set_time_us(uint64_t time_us)
+{
+    if (time_us > _time_us) {
+        _time_us = time_us;
+        hal.scheduler->stop_clock(time_us);
+    }
+}
+
+void AP_AHRS_Driver::push_imu(const IMU_Sample &s)
+{
+    set_time_us(s.time_us);
+    if (s.have_gyro) {
+        _ins.set_gyro(s.instance, s.gyro);
+    }
+    if (s.have_accel) {
+        _ins.set_accel(s.instance, s.accel);
+    }
+    if (s.delta_time > 0) {
+        _ins.set_delta_time(s.delta_time);
+    }
+    if (s.have_delta_angle) {
+        _ins.set_delta_angle(s.instance, s.delta_angle);
+    }
+    if (s.have_delta_velocity) {
+        _ins.set_delta_velocity(s.instance, s.delta_velocity_dt, s.delta_velocity);
+    }
+}
+
+void AP_AHRS_Driver::push_baro(const Baro_Sample &s)
+{
+    set_time_us(s.time_us);
+    _baro.setHIL(s.instance, s.pressure, s.temperature);
+}
+
+void AP_AHRS_Driver::push_mag(const Mag_Sample &s)
+{
+    set_time_us(s.time_us);
+    _compass.setHIL(s.instance, s.field - s.offsets);
+    _compass.set_offsets(s.instance, s.offsets);
+}
+
+void AP_AHRS_Driver::push_gps(const GPS_Sample &s)
+{
+    set_time_us(s.time_us);
+    _gps.setHIL(s.instance, s.status, uint32_t(s.time_us/1000), s.location, s.velocity,
+                s.num_sats, s.hdop, s.have_vertical_velocity);
+}
+
+void AP_AHRS_Driver::push_airspeed(const Airspeed_Sample &s)
+{
+    set_time_us(s.time_us);
+    _airspeed.setHIL(s.airspeed, s.diff_pressure, s.temperature);
+}
+
+void AP_AHRS_Driver::update(void)
+{
+    _ahrs.update();
+}
@@ -0,0 +1,120 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#ifndef __AP_AHRS_DRIVER_H__
+#define __AP_AHRS_DRIVER_H__
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  drive the AHRS and its estimators from timestamped sensor samples,
+  for Replay and other offline estimation.
+
+  The caller puts the sensor libraries in HIL mode, as Replay does,
+  so no backend is polled. Each push_*() call moves the HAL clock
+  forward to the time of the sample with stop_clock(), as the EKFs
+  read the time through AP_HAL::millis()/micros(), and hands the data
+  to the front end of the sensor library. update() then runs one AHRS
+  step. The driver runs no scheduler loop of its own; deciding when to
+  step, and decoding the samples (per message type, through virtual
+  LR_MsgHandler calls in Replay), is left to the caller.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_Baro/AP_Baro.h>
+#include <AP_Compass/AP_Compass.h>
+#include <AP_GPS/AP_GPS.h>
+#include <AP_Airspeed/AP_Airspeed.h>
+#include "AP_AHRS.h"
+
+class AP_AHRS_Driver
+{
+public:
+    struct IMU_Sample {
+        uint64_t time_us;
+        uint8_t instance;
+        bool have_gyro:1;
+        bool have_accel:1;
+        bool have_delta_angle:1;
+        bool have_delta_velocity:1;
+        Vector3f gyro;                  // rad/s
+        Vector3f accel;                 // m/s/s
+        float delta_time;               // seconds covered by delta_angle, 0 if unknown
+        Vector3f delta_angle;           // rad
+        float delta_velocity_dt;        // seconds
+        Vector3f delta_velocity;        // m/s
+    };
+
+    struct Baro_Sample {
+        uint64_t time_us;
+        uint8_t instance;
+        float pressure;                 // Pa
+        float temperature;              // degrees C
+    };
+
+    struct Mag_Sample {
+        uint64_t time_us;
+        uint8_t instance;
+        Vector3f field;                 // milligauss, offsets included
+        Vector3f offsets;               // milligauss
+    };
+
+    struct GPS_Sample {
+        uint64_t time_us;
+        uint8_t instance;
+        AP_GPS::GPS_Status status;
+        Location location;
+        Vector3f velocity;              // NED m/s
+        uint8_t num_sats;
+        uint16_t hdop;
+        bool have_vertical_velocity;
+    };
+
+    struct Airspeed_Sample {
+        uint64_t time_us;
+        float airspeed;                 // m/s
+        float diff_pressure;            // Pa
+        float temperature;              // degrees C
+    };
+
+    AP_AHRS_Driver(AP_AHRS &ahrs, AP_InertialSensor &ins, AP_Baro &baro,
+                   Compass &compass, AP_GPS &gps, AP_Airspeed &airspeed);
+
+    // move the HAL clock to time_us. The clock never goes backwards
+    void set_time_us(uint64_t time_us);
+    uint64_t time_us(void) const { return _time_us; }
+
+    void push_imu(const IMU_Sample &s);
+    void push_baro(const Baro_Sample &s);
+    void push_mag(const Mag_Sample &s);
+    void push_gps(const GPS_Sample &s);
+    void push_airspeed(const Airspeed_Sample &s);
+
+    // run one step of the AHRS with the samples pushed so far
+    void update(void);
+
+private:
+    AP_AHRS &_ahrs;
+    AP_InertialSensor &_ins;
+    AP_Baro &_baro;
+    Compass &_compass;
+    AP_GPS &_gps;
+    AP_Airspeed &_airspeed;
+
+    uint64_t _time_us;
+};
+
+#endif // __AP_AHRS_DRIVER_H__
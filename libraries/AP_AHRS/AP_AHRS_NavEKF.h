@@ -206,6 +206,12 @@ public:
     void setTakeoffExpected(bool val);
     void setTouchdownExpected(bool val);
 
+    // update the estimators one at a time. update() calls all of
+    // these, Replay calls them separately to time each one
+    void update_DCM(void);
+    void update_EKF1(void);
+    void update_EKF2(void);
+
 private:
     enum EKF_TYPE {EKF_TYPE_NONE=0,
                    EKF_TYPE1=1,
@@ -235,9 +241,6 @@ private:
     Flags _flags;
 
     uint8_t ekf_type(void) const;
-    void update_DCM(void);
-    void update_EKF1(void);
-    void update_EKF2(void);
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     SITL::SITL *_sitl;
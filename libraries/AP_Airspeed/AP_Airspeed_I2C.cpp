@@ -28,6 +28,9 @@ extern const AP_HAL::HAL& hal;
 
 #define I2C_ADDRESS_MS4525DO	0x28
 
+// airspeed reads yield to the compass on a shared bus
+#define MS4525DO_BUS_PRIORITY 10
+
 // probe and initialise the sensor
 bool AP_Airspeed_I2C::init(void)
 {
@@ -43,7 +46,11 @@ bool AP_Airspeed_I2C::init(void)
     _collect();
     i2c_sem->give();
     if (_last_sample_time_ms != 0) {
-        hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Airspeed_I2C::_timer, void));
+        /* poll every 1ms on the thread of the I2C bus, so a slow
+         * transfer can't delay the IMU */
+        hal.scheduler->register_bus_process(i2c_sem,
+                                            FUNCTOR_BIND_MEMBER(&AP_Airspeed_I2C::_timer, void),
+                                            1000, MS4525DO_BUS_PRIORITY);
         return true;
     }
     return false;
@@ -101,7 +108,7 @@ void AP_Airspeed_I2C::_collect(void)
     _last_sample_time_ms = AP_HAL::millis();
 }
 
-// 1kHz timer
+// 1kHz bus task
 void AP_Airspeed_I2C::_timer(void)
 {
     AP_HAL::Semaphore* i2c_sem = hal.i2c->get_semaphore();
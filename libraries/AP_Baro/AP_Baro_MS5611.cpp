@@ -48,6 +48,9 @@ extern const AP_HAL::HAL& hal;
 #define ADDR_CMD_CONVERT_D1			ADDR_CMD_CONVERT_D1_OSR1024
 #define ADDR_CMD_CONVERT_D2			ADDR_CMD_CONVERT_D2_OSR1024
 
+// the barometer yields to the compass on a shared bus
+#define MS56XX_BUS_PRIORITY 10
+
 // SPI Device //////////////////////////////////////////////////////////////////
 
 AP_SerialBus_SPI::AP_SerialBus_SPI(enum AP_HAL::SPIDeviceType device, enum AP_HAL::SPIDeviceDriver::bus_speed speed) :
@@ -94,6 +97,22 @@ bool AP_SerialBus_SPI::write(uint8_t reg)
     return true;
 }
 
+bool AP_SerialBus_SPI::read_24bits_and_write(uint8_t reg, uint8_t cmd, uint32_t &value)
+{
+    uint8_t tx[5] = { reg, 0, 0, 0, cmd };
+    uint8_t rx[4];
+    const AP_HAL::SPIDeviceDriver::Transfer xfers[2] = {
+        { &tx[0], rx, 4 },
+        { &tx[4], NULL, 1 },
+    };
+    if (!_spi->transactions(xfers, 2)) {
+        value = 0;
+        return false;
+    }
+    value = (((uint32_t)rx[1])<<16) | (((uint32_t)rx[2])<<8) | ((uint32_t)rx[3]);
+    return true;
+}
+
 bool AP_SerialBus_SPI::sem_take_blocking() 
 {
     return _spi_sem->take(10);
@@ -218,8 +237,11 @@ void AP_Baro_MS56XX::_init()
     hal.scheduler->resume_timer_procs();
 
     if (_use_timer) {
-        /* timer needs to be called every 10ms so set the freq_div to 10 */
-        _timesliced = hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Baro_MS56XX::_timer, void), 10);
+        /* read every 10ms on the thread of our bus, so a slow bus can't
+         * delay the IMU */
+        _timesliced = hal.scheduler->register_bus_process(_serial->get_semaphore(),
+                                                          FUNCTOR_BIND_MEMBER(&AP_Baro_MS56XX::_timer, void),
+                                                          10000, MS56XX_BUS_PRIORITY);
     }
 }
 
@@ -316,8 +338,10 @@ void AP_Baro_MS56XX::_timer(void)
     }
 
     if (_state == 0) {
-        // On state 0 we read temp
-        uint32_t d2 = _serial->read_24bits(0);
+        // On state 0 we read temp, and start the pressure conversion
+        // in the same bus transfer where the bus allows
+        uint32_t d2;
+        bool started = _serial->read_24bits_and_write(0, ADDR_CMD_CONVERT_D1, d2);
         if (d2 != 0) {
             _s_D2 += d2;
             _d2_count++;
@@ -328,17 +352,21 @@ void AP_Baro_MS56XX::_timer(void)
                 _s_D2 >>= 1;
                 _d2_count = 16;
             }
-
-            if (_serial->write(ADDR_CMD_CONVERT_D1)) {      // Command to read pressure
-                _state++;
-            }
-        } else {
+        }
+        if (started) {
+            // a pressure conversion is running, even if this read
+            // failed, so a second command must not be sent
+            _state++;
+        } else if (d2 == 0) {
             /* if read fails, re-initiate a temperature read command or we are
              * stuck */
             _serial->write(ADDR_CMD_CONVERT_D2);
         }
     } else {
-        uint32_t d1 = _serial->read_24bits(0);
+        // every fourth pressure reading is followed by a temperature one
+        uint8_t next_cmd = (_state == 4) ? ADDR_CMD_CONVERT_D2 : ADDR_CMD_CONVERT_D1;
+        uint32_t d1;
+        bool started = _serial->read_24bits_and_write(0, next_cmd, d1);
         if (d1 != 0) {
             // occasional zero values have been seen on the PXF
             // board. These may be SPI errors, but safest to ignore
@@ -353,17 +381,11 @@ void AP_Baro_MS56XX::_timer(void)
             }
             // Now a new reading exists
             _updated = true;
-
-            if (_state == 4) {
-                if (_serial->write(ADDR_CMD_CONVERT_D2)) { // Command to read temperature
-                    _state = 0;
-                }
-            } else {
-                if (_serial->write(ADDR_CMD_CONVERT_D1)) { // Command to read pressure
-                    _state++;
-                }
-            }
-        } else {
+        }
+        if (started) {
+            // next_cmd is running whether or not this read succeeded
+            _state = (_state == 4) ? 0 : _state + 1;
+        } else if (d1 == 0) {
             /* if read fails, re-initiate a pressure read command or we are
              * stuck */
             _serial->write(ADDR_CMD_CONVERT_D1);
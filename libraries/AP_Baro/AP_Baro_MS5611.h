@@ -21,6 +21,15 @@ public:
     /** Write to a register with no data. */
     virtual bool write(uint8_t reg) = 0;
 
+    /** Read a 24-bit value from "reg" then write "cmd", returning
+     * whether cmd was sent. cmd is only sent after a non-zero read,
+     * except on buses that batch both in one transfer, where it is
+     * sent whatever the read returns. */
+    virtual bool read_24bits_and_write(uint8_t reg, uint8_t cmd, uint32_t &value) {
+        value = read_24bits(reg);
+        return value != 0 && write(cmd);
+    }
+
     /** Acquire the internal semaphore for this device.
      * take_nonblocking should be used from the timer process,
      * take_blocking from synchronous code (i.e. init) */
@@ -29,6 +38,9 @@ public:
 
     /** Release the internal semaphore for this device. */
     virtual void sem_give() = 0;
+
+    /** The semaphore of the bus, which identifies it to the scheduler. */
+    virtual AP_HAL::Semaphore *get_semaphore() = 0;
 };
 
 /** SPI serial device. */
@@ -41,9 +53,11 @@ public:
     uint32_t read_24bits(uint8_t reg);
     uint32_t read_adc(uint8_t reg);
     bool write(uint8_t reg);
+    bool read_24bits_and_write(uint8_t reg, uint8_t cmd, uint32_t &value);
     bool sem_take_nonblocking();
     bool sem_take_blocking();
     void sem_give();
+    AP_HAL::Semaphore *get_semaphore() { return _spi_sem; }
 
 private:
     enum AP_HAL::SPIDeviceType _device;
@@ -64,6 +78,7 @@ public:
     bool sem_take_nonblocking();
     bool sem_take_blocking();
     void sem_give();
+    AP_HAL::Semaphore *get_semaphore() { return _i2c_sem; }
 
 private:
     AP_HAL::I2CDriver *_i2c;
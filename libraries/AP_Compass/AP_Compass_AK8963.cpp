@@ -58,6 +58,9 @@
 
 #define AK8963_MILLIGAUSS_SCALE 10.0f
 
+// compass reads go ahead of the barometer on a shared bus
+#define AK8963_BUS_PRIORITY 20
+
 extern const AP_HAL::HAL& hal;
 
 AP_Compass_AK8963::AP_Compass_AK8963(Compass &compass, AP_AK8963_SerialBus *bus) :
@@ -160,8 +163,18 @@ bool AP_Compass_AK8963::init()
     /* register the compass instance in the frontend */
     _compass_instance = register_compass();
     set_dev_id(_compass_instance, _bus->get_dev_id());
-    /* timer needs to be called every 10ms so set the freq_div to 10 */
-    _timesliced = hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Compass_AK8963::_update, void), 10);
+    if (_bus->on_imu_thread()) {
+        /* the IMU polls our bus from the timer thread, so read there too
+         * rather than contend with it for the bus semaphore.
+         * timer needs to be called every 10ms so set the freq_div to 10 */
+        _timesliced = hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Compass_AK8963::_update, void), 10);
+    } else {
+        /* read every 10ms on the thread of our bus, so a slow bus can't
+         * delay the IMU */
+        _timesliced = hal.scheduler->register_bus_process(_bus_sem,
+                                                          FUNCTOR_BIND_MEMBER(&AP_Compass_AK8963::_update, void),
+                                                          10000, AK8963_BUS_PRIORITY);
+    }
 
     _bus_sem->give();
     hal.scheduler->resume_timer_procs();
@@ -33,6 +33,8 @@ public:
     virtual bool start_measurements() = 0;
     virtual void read_raw(struct raw_value *rv) = 0;
     virtual uint32_t get_dev_id() = 0;
+    // true if the bus is read by the IMU driver on the timer thread
+    virtual bool on_imu_thread() { return false; }
 };
 
 class AP_Compass_AK8963 : public AP_Compass_Backend
@@ -100,6 +102,7 @@ public:
     bool start_measurements();
     void read_raw(struct raw_value *rv);
     uint32_t get_dev_id();
+    bool on_imu_thread() { return true; }
 private:
     AuxiliaryBus *_bus = nullptr;
     AuxiliaryBusSlave *_slave = nullptr;
@@ -47,6 +47,10 @@
  * minimum distance is set such that some percentage of the surface of that
  * sphere must be covered by samples.
  *
+ * To keep the acceptance test cheap, accepted samples are kept in a spatial
+ * hash with cells as wide as the minimum distance, so a new sample is only
+ * compared against samples in the 27 cells surrounding it.
+ *
  * Once the sample buffer is full, a sphere fitting algorithm is run, which
  * computes a new sphere radius. The sample buffer is thinned of samples which
  * no longer meet the acceptance criteria, and the state transitions to
@@ -56,6 +60,12 @@
  *
  * The fitting algorithm used is Levenberg-Marquardt. See also:
  * http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm
+ *
+ * Each step of the fit is spread over several calls to update(). The normal
+ * equations are accumulated COMPASS_CAL_SAMPLES_PER_UPDATE samples at a time,
+ * and the two candidate solutions are then evaluated over the samples in a
+ * single shared pass, so the time spent per call is bounded regardless of how
+ * many compasses are being calibrated at once.
  */
 
 #include "CompassCalibrator.h"
@@ -69,7 +79,9 @@ extern const AP_HAL::HAL& hal;
 
 CompassCalibrator::CompassCalibrator():
 _tolerance(COMPASS_CAL_DEFAULT_TOLERANCE),
-_sample_buffer(NULL)
+_sample_buffer(NULL),
+_hash_next(NULL),
+_hash_cell_size(0.0f)
 {
     clear();
 }
@@ -138,6 +150,7 @@ void CompassCalibrator::new_sample(const Vector3f& sample) {
 
     if(running() && _samples_collected < COMPASS_CAL_NUM_SAMPLES && accept_sample(sample)) {
         _sample_buffer[_samples_collected].set(sample);
+        hash_insert(_samples_collected);
         _samples_collected++;
     }
 }
@@ -156,8 +169,7 @@ void CompassCalibrator::update(bool &failure) {
                 failure = true;
             }
             set_status(COMPASS_CAL_RUNNING_STEP_TWO);
-        } else {
-            run_sphere_fit();
+        } else if (run_fit_chunk(false)) {
             _fit_step++;
         }
     } else if(_status == COMPASS_CAL_RUNNING_STEP_TWO) {
@@ -169,10 +181,10 @@ void CompassCalibrator::update(bool &failure) {
                 failure = true;
             }
         } else if (_fit_step < 15) {
-            run_sphere_fit();
-            _fit_step++;
-        } else {
-            run_ellipsoid_fit();
+            if (run_fit_chunk(false)) {
+                _fit_step++;
+            }
+        } else if (run_fit_chunk(true)) {
             _fit_step++;
         }
     }
@@ -200,6 +212,8 @@ void CompassCalibrator::initialize_fit() {
     _sphere_lambda = 1.0f;
     _initial_fitness = _fitness;
     _fit_step = 0;
+    _fit_phase = FIT_PHASE_ACCUMULATE;
+    _fit_sample_idx = 0;
 }
 
 void CompassCalibrator::reset_state() {
@@ -223,10 +237,7 @@ bool CompassCalibrator::set_status(compass_cal_status_t status) {
             reset_state();
             _status = COMPASS_CAL_NOT_STARTED;
 
-            if(_sample_buffer != NULL) {
-                free(_sample_buffer);
-                _sample_buffer = NULL;
-            }
+            free_sample_buffer();
             return true;
 
         case COMPASS_CAL_WAITING_TO_START:
@@ -245,13 +256,7 @@ bool CompassCalibrator::set_status(compass_cal_status_t status) {
                 return false;
             }
 
-            if (_sample_buffer == NULL) {
-                _sample_buffer =
-                        (CompassSample*) malloc(sizeof(CompassSample) *
-                                                COMPASS_CAL_NUM_SAMPLES);
-            }
-
-            if(_sample_buffer != NULL) {
+            if(alloc_sample_buffer()) {
                 initialize_fit();
                 _status = COMPASS_CAL_RUNNING_STEP_ONE;
                 return true;
@@ -273,10 +278,7 @@ bool CompassCalibrator::set_status(compass_cal_status_t status) {
                 return false;
             }
 
-            if(_sample_buffer != NULL) {
-                free(_sample_buffer);
-                _sample_buffer = NULL;
-            }
+            free_sample_buffer();
 
             _status = COMPASS_CAL_SUCCESS;
             return true;
@@ -291,10 +293,7 @@ bool CompassCalibrator::set_status(compass_cal_status_t status) {
                 return true;
             }
 
-            if(_sample_buffer != NULL) {
-                free(_sample_buffer);
-                _sample_buffer = NULL;
-            }
+            free_sample_buffer();
 
             _status = COMPASS_CAL_FAILED;
             return true;
@@ -304,6 +303,34 @@ bool CompassCalibrator::set_status(compass_cal_status_t status) {
     };
 }
 
+bool CompassCalibrator::alloc_sample_buffer() {
+    if (_sample_buffer == NULL) {
+        _sample_buffer =
+                (CompassSample*) malloc(sizeof(CompassSample) *
+                                        COMPASS_CAL_NUM_SAMPLES);
+    }
+    if (_hash_next == NULL) {
+        _hash_next = (uint16_t*) malloc(sizeof(uint16_t) * COMPASS_CAL_NUM_SAMPLES);
+    }
+    if (_sample_buffer == NULL || _hash_next == NULL) {
+        free_sample_buffer();
+        return false;
+    }
+    hash_rebuild(sample_acceptance_distance());
+    return true;
+}
+
+void CompassCalibrator::free_sample_buffer() {
+    if(_sample_buffer != NULL) {
+        free(_sample_buffer);
+        _sample_buffer = NULL;
+    }
+    if(_hash_next != NULL) {
+        free(_hash_next);
+        _hash_next = NULL;
+    }
+}
+
 bool CompassCalibrator::fit_acceptable() {
     if( !isnan(_fitness) &&
         _params.radius > 150 && _params.radius < 950 && //Earth's magnetic field strength range: 250-850mG
@@ -337,11 +364,19 @@ void CompassCalibrator::thin_samples() {
         _sample_buffer[j] = temp;
     }
 
-    for(uint16_t i=0; i < _samples_collected; i++) {
-        if(!accept_sample(_sample_buffer[i])) {
-            _sample_buffer[i] = _sample_buffer[_samples_collected-1];
-            _samples_collected --;
-            _samples_thinned ++;
+    // rebuild the buffer keeping only samples that are far enough from the
+    // samples already kept at the new sphere radius
+    uint16_t num_samples = _samples_collected;
+    _samples_collected = 0;
+    hash_rebuild(sample_acceptance_distance());
+    for(uint16_t i=0; i < num_samples; i++) {
+        CompassSample sample = _sample_buffer[i];
+        if(accept_sample(sample)) {
+            _sample_buffer[_samples_collected] = sample;
+            hash_insert(_samples_collected);
+            _samples_collected++;
+        } else {
+            _samples_thinned++;
         }
     }
 }
@@ -362,22 +397,43 @@ void CompassCalibrator::thin_samples() {
  * The above equation was proved after solving for spherical triangular excess
  * and related equations.
  */
-bool CompassCalibrator::accept_sample(const Vector3f& sample)
+float CompassCalibrator::sample_acceptance_distance() const
 {
     static const uint16_t faces = (2 * COMPASS_CAL_NUM_SAMPLES - 4);
     static const float a = (4.0f * M_PI_F / (3.0f * faces)) + M_PI_F / 3.0f;
     static const float theta = 0.5f * acosf(cosf(a) / (1.0f - cosf(a)));
 
-    if(_sample_buffer == NULL) {
+    return _params.radius * 2*sinf(theta/2);
+}
+
+bool CompassCalibrator::accept_sample(const Vector3f& sample)
+{
+    if(_sample_buffer == NULL || _hash_next == NULL) {
         return false;
     }
 
-    float min_distance = _params.radius * 2*sinf(theta/2);
+    float min_distance = sample_acceptance_distance();
 
-    for (uint16_t i = 0; i<_samples_collected; i++){
-        float distance = (sample - _sample_buffer[i].get()).length();
-        if(distance < min_distance) {
-            return false;
+    // the radius changes during fitting, keep the hash cells matching the acceptance distance
+    if (!is_equal(MAX(min_distance, 1.0f), _hash_cell_size)) {
+        hash_rebuild(min_distance);
+    }
+
+    // any sample closer than min_distance must be in one of the 27 neighbouring cells
+    int32_t ix, iy, iz;
+    hash_cell(sample, ix, iy, iz);
+    for (int8_t dx = -1; dx <= 1; dx++) {
+        for (int8_t dy = -1; dy <= 1; dy++) {
+            for (int8_t dz = -1; dz <= 1; dz++) {
+                uint16_t i = _hash_head[hash_bucket(ix+dx, iy+dy, iz+dz)];
+                while (i != COMPASS_CAL_HASH_EMPTY) {
+                    float distance = (sample - _sample_buffer[i].get()).length();
+                    if(distance < min_distance) {
+                        return false;
+                    }
+                    i = _hash_next[i];
+                }
+            }
         }
     }
     return true;
@@ -387,6 +443,43 @@ bool CompassCalibrator::accept_sample(const CompassSample& sample) {
     return accept_sample(sample.get());
 }
 
+uint16_t CompassCalibrator::hash_bucket(int32_t ix, int32_t iy, int32_t iz) const
+{
+    uint32_t h = ((uint32_t)ix * 73856093U) ^ ((uint32_t)iy * 19349663U) ^ ((uint32_t)iz * 83492791U);
+    return h & (COMPASS_CAL_HASH_BUCKETS-1);
+}
+
+void CompassCalibrator::hash_cell(const Vector3f &sample, int32_t &ix, int32_t &iy, int32_t &iz) const
+{
+    ix = (int32_t)floorf(sample.x / _hash_cell_size);
+    iy = (int32_t)floorf(sample.y / _hash_cell_size);
+    iz = (int32_t)floorf(sample.z / _hash_cell_size);
+}
+
+void CompassCalibrator::hash_insert(uint16_t idx)
+{
+    if (_hash_next == NULL) {
+        return;
+    }
+    int32_t ix, iy, iz;
+    hash_cell(_sample_buffer[idx].get(), ix, iy, iz);
+    uint16_t bucket = hash_bucket(ix, iy, iz);
+    _hash_next[idx] = _hash_head[bucket];
+    _hash_head[bucket] = idx;
+}
+
+void CompassCalibrator::hash_rebuild(float cell_size)
+{
+    // guard against a degenerate radius from a diverging fit
+    _hash_cell_size = MAX(cell_size, 1.0f);
+    for (uint16_t i=0; i<COMPASS_CAL_HASH_BUCKETS; i++) {
+        _hash_head[i] = COMPASS_CAL_HASH_EMPTY;
+    }
+    for (uint16_t i=0; i<_samples_collected; i++) {
+        hash_insert(i);
+    }
+}
+
 float CompassCalibrator::calc_residual(const Vector3f& sample, const param_t& params) const {
     Matrix3f softiron(
         params.diag.x    , params.offdiag.x , params.offdiag.y,
@@ -416,7 +509,7 @@ float CompassCalibrator::calc_mean_squared_residuals(const param_t& params) cons
     return sum;
 }
 
-void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
+float CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
     const Vector3f &offdiag = params.offdiag;
@@ -437,93 +530,11 @@ void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t&
     ret[1] = -1.0f * (((diag.x    * A) + (offdiag.x * B) + (offdiag.y * C))/length);
     ret[2] = -1.0f * (((offdiag.x * A) + (diag.y    * B) + (offdiag.z * C))/length);
     ret[3] = -1.0f * (((offdiag.y * A) + (offdiag.z * B) + (diag.z    * C))/length);
-}
-
-void CompassCalibrator::run_sphere_fit()
-{
-    if(_sample_buffer == NULL) {
-        return;
-    }
-
-    const float lma_damping = 10.0f;
-
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
-
-    float JTJ[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
-    float JTJ2[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
-    float JTFI[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-    memset(&JTJ,0,sizeof(JTJ));
-    memset(&JTJ2,0,sizeof(JTJ2));
-    memset(&JTFI,0,sizeof(JTFI));
-    // Gauss Newton Part common for all kind of extensions including LM
-    for(uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
-
-        float sphere_jacob[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-        calc_sphere_jacob(sample, fit1_params, sphere_jacob);
 
-        for(uint8_t i = 0;i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-            // compute JTJ
-            for(uint8_t j = 0; j < COMPASS_CAL_NUM_SPHERE_PARAMS; j++) {
-                JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];   //a backup JTJ for LM
-            }
-            // compute JTFI
-            JTFI[i] += sphere_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
-
-
-    //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
-    //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for(uint8_t i = 0; i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda/lma_damping;
-    }
-
-    if(!inverse(JTJ, JTJ, 4)) {
-        return;
-    }
-
-    if(!inverse(JTJ2, JTJ2, 4)) {
-        return;
-    }
-
-    for(uint8_t row=0; row < COMPASS_CAL_NUM_SPHERE_PARAMS; row++) {
-        for(uint8_t col=0; col < COMPASS_CAL_NUM_SPHERE_PARAMS; col++) {
-            fit1_params.get_sphere_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-            fit2_params.get_sphere_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-        }
-    }
-
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
-
-    if(fit1 > _fitness && fit2 > _fitness){
-        _sphere_lambda *= lma_damping;
-    } else if(fit2 < _fitness && fit2 < fit1) {
-        _sphere_lambda /= lma_damping;
-        fit1_params = fit2_params;
-        fitness = fit2;
-    } else if(fit1 < _fitness){
-        fitness = fit1;
-    }
-    //--------------------Levenberg-Marquardt-part-ends-here--------------------------------//
-
-    if(!isnan(fitness) && fitness < _fitness) {
-        _fitness = fitness;
-        _params = fit1_params;
-    }
+    return params.radius - length;
 }
 
-
-
-void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
+float CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
     const Vector3f &offdiag = params.offdiag;
@@ -550,91 +561,128 @@ void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param
     ret[6] = -1.0f * (((sample.y + offset.y) * A) + ((sample.x + offset.x) * B))/length;
     ret[7] = -1.0f * (((sample.z + offset.z) * A) + ((sample.x + offset.x) * C))/length;
     ret[8] = -1.0f * (((sample.z + offset.z) * B) + ((sample.y + offset.y) * C))/length;
+
+    return params.radius - length;
 }
 
-void CompassCalibrator::run_ellipsoid_fit()
+bool CompassCalibrator::run_fit_chunk(bool ellipsoid)
 {
     if(_sample_buffer == NULL) {
-        return;
+        return false;
     }
 
     const float lma_damping = 10.0f;
+    const uint8_t num_params = ellipsoid ? COMPASS_CAL_NUM_ELLIPSOID_PARAMS : COMPASS_CAL_NUM_SPHERE_PARAMS;
+    float &lambda = ellipsoid ? _ellipsoid_lambda : _sphere_lambda;
+    uint16_t end = MIN(_fit_sample_idx + COMPASS_CAL_SAMPLES_PER_UPDATE, _samples_collected);
+
+    if (_fit_phase == FIT_PHASE_ACCUMULATE) {
+        if (_fit_sample_idx == 0) {
+            memset(_fit_JTJ, 0, sizeof(_fit_JTJ));
+            memset(_fit_JTFI, 0, sizeof(_fit_JTFI));
+        }
 
+        // Gauss Newton Part common for all kind of extensions including LM
+        // JTJ is symmetric so only the upper triangle is accumulated
+        for(uint16_t k = _fit_sample_idx; k < end; k++) {
+            Vector3f sample = _sample_buffer[k].get();
 
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
-
-
-    float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-    float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-    float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-
-    memset(&JTJ,0,sizeof(JTJ));
-    memset(&JTJ2,0,sizeof(JTJ2));
-    memset(&JTFI,0,sizeof(JTFI));
-    // Gauss Newton Part common for all kind of extensions including LM
-    for(uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
+            float jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+            float residual;
+            if (ellipsoid) {
+                residual = calc_ellipsoid_jacob(sample, _params, jacob);
+            } else {
+                residual = calc_sphere_jacob(sample, _params, jacob);
+            }
 
-        float ellipsoid_jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+            for(uint8_t i = 0; i < num_params; i++) {
+                // compute JTJ
+                for(uint8_t j = i; j < num_params; j++) {
+                    _fit_JTJ[i*num_params+j] += jacob[i] * jacob[j];
+                }
+                // compute JTFI
+                _fit_JTFI[i] += jacob[i] * residual;
+            }
+        }
+        _fit_sample_idx = end;
 
-        calc_ellipsoid_jacob(sample, fit1_params, ellipsoid_jacob);
+        if (_fit_sample_idx < _samples_collected) {
+            return false;
+        }
 
-        for(uint8_t i = 0;i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-            // compute JTJ
-            for(uint8_t j = 0; j < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; j++) {
-                JTJ [i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
+        // fill in the lower triangle
+        for(uint8_t i = 1; i < num_params; i++) {
+            for(uint8_t j = 0; j < i; j++) {
+                _fit_JTJ[i*num_params+j] = _fit_JTJ[j*num_params+i];
             }
-            // compute JTFI
-            JTFI[i] += ellipsoid_jacob[i] * calc_residual(sample, fit1_params);
         }
-    }
 
+        //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
+        //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
+        float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        memcpy(JTJ2, _fit_JTJ, sizeof(float)*num_params*num_params);
+        for(uint8_t i = 0; i < num_params; i++) {
+            _fit_JTJ[i*num_params+i] += lambda;
+            JTJ2[i*num_params+i] += lambda/lma_damping;
+        }
 
+        _fit_sample_idx = 0;
+        if(!inverse(_fit_JTJ, _fit_JTJ, num_params) || !inverse(JTJ2, JTJ2, num_params)) {
+            // singular, give up on this step
+            return true;
+        }
 
-    //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
-    //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for(uint8_t i = 0; i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda/lma_damping;
-    }
+        _fit1_params = _fit2_params = _params;
+        float *fit1 = ellipsoid ? _fit1_params.get_ellipsoid_params() : _fit1_params.get_sphere_params();
+        float *fit2 = ellipsoid ? _fit2_params.get_ellipsoid_params() : _fit2_params.get_sphere_params();
+        for(uint8_t row=0; row < num_params; row++) {
+            for(uint8_t col=0; col < num_params; col++) {
+                fit1[row] -= _fit_JTFI[col] * _fit_JTJ[row*num_params+col];
+                fit2[row] -= _fit_JTFI[col] * JTJ2[row*num_params+col];
+            }
+        }
 
-    if(!inverse(JTJ, JTJ, 9)) {
-        return;
+        _fit1_sum = 0.0f;
+        _fit2_sum = 0.0f;
+        _fit_phase = FIT_PHASE_EVALUATE;
+        return false;
     }
 
-    if(!inverse(JTJ2, JTJ2, 9)) {
-        return;
+    // evaluate both candidate fits in one pass over the samples
+    for(uint16_t k = _fit_sample_idx; k < end; k++) {
+        Vector3f sample = _sample_buffer[k].get();
+        _fit1_sum += sq(calc_residual(sample, _fit1_params));
+        _fit2_sum += sq(calc_residual(sample, _fit2_params));
     }
+    _fit_sample_idx = end;
 
-    for(uint8_t row=0; row < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; row++) {
-        for(uint8_t col=0; col < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; col++) {
-            fit1_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-            fit2_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-        }
+    if (_fit_sample_idx < _samples_collected) {
+        return false;
     }
 
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
+    float fitness = _fitness;
+    float fit1 = _fit1_sum / _samples_collected;
+    float fit2 = _fit2_sum / _samples_collected;
 
     if(fit1 > _fitness && fit2 > _fitness){
-        _ellipsoid_lambda *= lma_damping;
+        lambda *= lma_damping;
     } else if(fit2 < _fitness && fit2 < fit1) {
-        _ellipsoid_lambda /= lma_damping;
-        fit1_params = fit2_params;
+        lambda /= lma_damping;
+        _fit1_params = _fit2_params;
         fitness = fit2;
     } else if(fit1 < _fitness){
         fitness = fit1;
     }
-    //--------------------Levenberg-part-ends-here--------------------------------//
+    //--------------------Levenberg-Marquardt-part-ends-here--------------------------------//
 
-    if(fitness < _fitness) {
+    if(!isnan(fitness) && fitness < _fitness) {
         _fitness = fitness;
-        _params = fit1_params;
+        _params = _fit1_params;
     }
+
+    _fit_phase = FIT_PHASE_ACCUMULATE;
+    _fit_sample_idx = 0;
+    return true;
 }
 
 
@@ -4,6 +4,13 @@
 #define COMPASS_CAL_NUM_ELLIPSOID_PARAMS 9
 #define COMPASS_CAL_NUM_SAMPLES 300
 
+// number of samples processed by the fit on each call to update()
+#define COMPASS_CAL_SAMPLES_PER_UPDATE 100
+
+// number of buckets in the sample acceptance spatial hash, must be a power of 2
+#define COMPASS_CAL_HASH_BUCKETS 128
+#define COMPASS_CAL_HASH_EMPTY 0xFFFF
+
 //RMS tolerance
 #define COMPASS_CAL_DEFAULT_TOLERANCE 5.0f
 
@@ -69,6 +76,12 @@ private:
 
 
 
+    // phase of the current Levenberg-Marquardt step, see run_fit_chunk()
+    enum fit_phase_t {
+        FIT_PHASE_ACCUMULATE=0,
+        FIT_PHASE_EVALUATE=1
+    };
+
     enum compass_cal_status_t _status;
 
     // timeout watchdog state
@@ -93,12 +106,40 @@ private:
     uint16_t _samples_collected;
     uint16_t _samples_thinned;
 
+    // incremental fit state, the normal equations and candidate fits are
+    // built up over several calls to update()
+    fit_phase_t _fit_phase;
+    uint16_t _fit_sample_idx;
+    float _fit_JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    float _fit_JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    param_t _fit1_params;
+    param_t _fit2_params;
+    float _fit1_sum;
+    float _fit2_sum;
+
+    // spatial hash of accepted samples, cells are the acceptance distance wide
+    uint16_t *_hash_next;
+    uint16_t _hash_head[COMPASS_CAL_HASH_BUCKETS];
+    float _hash_cell_size;
+
     bool set_status(compass_cal_status_t status);
 
+    bool alloc_sample_buffer();
+    void free_sample_buffer();
+
     // returns true if sample should be added to buffer
     bool accept_sample(const Vector3f &sample);
     bool accept_sample(const CompassSample &sample);
 
+    // minimum distance between samples for the current sphere radius
+    float sample_acceptance_distance() const;
+
+    // spatial hash used by accept_sample
+    uint16_t hash_bucket(int32_t ix, int32_t iy, int32_t iz) const;
+    void hash_cell(const Vector3f &sample, int32_t &ix, int32_t &iy, int32_t &iz) const;
+    void hash_insert(uint16_t idx);
+    void hash_rebuild(float cell_size);
+
     // returns true if fit is acceptable
     bool fit_acceptable();
 
@@ -114,11 +155,13 @@ private:
     float calc_mean_squared_residuals(const param_t& params) const;
     float calc_mean_squared_residuals() const;
 
-    void calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_sphere_fit();
+    // the jacobian functions return the residual of the sample
+    float calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
+    float calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
 
-    void calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_ellipsoid_fit();
+    // processes the next chunk of samples for a sphere or ellipsoid fit step,
+    // returns true when the step is complete
+    bool run_fit_chunk(bool ellipsoid);
 
     uint16_t get_random();
 };
@@ -38,6 +38,13 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
     // @RebootRequired: True
     AP_GROUPINFO("TYPE2",   1, AP_GPS, _type[1], 0),
 
+    // @Param: TYPE3
+    // @DisplayName: 3rd GPS type
+    // @Description: GPS type of 3rd GPS
+    // @Values: 0:None,1:AUTO,2:uBlox,3:MTK,4:MTK19,5:NMEA,6:SiRF,7:HIL,8:SwiftNav,9:PX4-UAVCAN,10:SBF,11:GSOF
+    // @RebootRequired: True
+    AP_GROUPINFO("TYPE3",   14, AP_GPS, _type[2], 0),
+
     // @Param: NAVFILTER
     // @DisplayName: Navigation filter setting
     // @Description: Navigation filter engine setting
@@ -47,8 +54,8 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
 
     // @Param: AUTO_SWITCH
     // @DisplayName: Automatic Switchover Setting
-    // @Description: Automatic switchover to GPS reporting best lock
-    // @Values: 0:Disabled,1:Enabled
+    // @Description: Automatic switchover to GPS reporting best lock. When set to 2 the receivers with a 3D fix are blended into one solution, each weighted by the inverse of its reported accuracy squared, and the blend is used as the primary GPS
+    // @Values: 0:Disabled,1:Enabled,2:Blend
     // @User: Advanced
     AP_GROUPINFO("AUTO_SWITCH", 3, AP_GPS, _auto_switch, 1),
 
@@ -80,7 +87,7 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
     // @Param: INJECT_TO
     // @DisplayName: Destination for GPS_INJECT_DATA MAVLink packets
     // @Description: The GGS can send raw serial packets to inject data to multiple GPSes.
-    // @Values: 0:send to first GPS,1:send to 2nd GPS,127:send to all
+    // @Values: 0:send to first GPS,1:send to 2nd GPS,2:send to 3rd GPS,127:send to all
     AP_GROUPINFO("INJECT_TO",   7, AP_GPS, _inject_to, GPS_RTK_INJECT_TO_ALL),
 
     // @Param: SBP_LOGMASK
@@ -113,23 +120,54 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("SAVE_CFG", 11, AP_GPS, _save_config, 0),
 
+    // @Param: DETECT_BAUD
+    // @DisplayName: Detected GPS baud rate
+    // @Description: Baud rate the first GPS was last detected at. Detection starts at this rate on the next boot. This is set automatically, and zero means no GPS has been detected yet.
+    // @User: Advanced
+    AP_GROUPINFO("DETECT_BAUD", 12, AP_GPS, _detect_baud[0], 0),
+
+    // @Param: DETECT_BAUD2
+    // @DisplayName: Detected 2nd GPS baud rate
+    // @Description: Baud rate the second GPS was last detected at. Detection starts at this rate on the next boot. This is set automatically, and zero means no GPS has been detected yet.
+    // @User: Advanced
+    AP_GROUPINFO("DETECT_BAUD2", 13, AP_GPS, _detect_baud[1], 0),
+
+    // @Param: DETECT_BAUD3
+    // @DisplayName: Detected 3rd GPS baud rate
+    // @Description: Baud rate the third GPS was last detected at. Detection starts at this rate on the next boot. This is set automatically, and zero means no GPS has been detected yet.
+    // @User: Advanced
+    AP_GROUPINFO("DETECT_BAUD3", 15, AP_GPS, _detect_baud[2], 0),
+
     AP_GROUPEND
 };
 
+// baudrates to try to detect GPSes with, in the order they are tried
+const uint32_t AP_GPS::_baudrates[] = {38400U, 115200U, 57600U, 9600U, 230400U, 4800U};
+
 /// Startup initialisation.
 void AP_GPS::init(DataFlash_Class *dataflash, const AP_SerialManager& serial_manager)
 {
     _DataFlash = dataflash;
     primary_instance = 0;
+    _primary_receiver = 0;
+    _blend_mask = 0;
 
     // search for serial ports with gps protocol
     _port[0] = serial_manager.find_serial(AP_SerialManager::SerialProtocol_GPS, 0);
     _port[1] = serial_manager.find_serial(AP_SerialManager::SerialProtocol_GPS, 1);
+    _port[2] = serial_manager.find_serial(AP_SerialManager::SerialProtocol_GPS, 2);
     _last_instance_swap_ms = 0;
-}
 
-// baudrates to try to detect GPSes with
-const uint32_t AP_GPS::_baudrates[] = {4800U, 38400U, 115200U, 57600U, 9600U, 230400U};
+    // start detection at the rate each GPS was last found at
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        for (uint8_t b=0; b<ARRAY_SIZE(_baudrates); b++) {
+            if (_baudrates[b] == (uint32_t)_detect_baud[i].get()) {
+                detect_state[i].last_baud = b;
+                break;
+            }
+        }
+    }
+}
 
 // initialisation blobs to send to the GPS to try to get it into the
 // right mode
@@ -226,16 +264,21 @@ AP_GPS::detect_instance(uint8_t instance)
         dstate->detect_started_ms = now;
     }
 
-    if (now - dstate->last_baud_change_ms > GPS_BAUD_TIME_MS) {
-        // try the next baud rate
-		dstate->last_baud++;
-		if (dstate->last_baud == ARRAY_SIZE(_baudrates)) {
-			dstate->last_baud = 0;
-		}
+    if (dstate->last_baud_change_ms == 0 ||
+        now - dstate->last_baud_change_ms > GPS_BAUD_TIME_MS ||
+        dstate->noise_bytes >= GPS_DETECT_NOISE_BYTES) {
+        if (dstate->last_baud_change_ms != 0) {
+            // try the next baud rate
+            dstate->last_baud++;
+            if (dstate->last_baud == ARRAY_SIZE(_baudrates)) {
+                dstate->last_baud = 0;
+            }
+        }
 		uint32_t baudrate = _baudrates[dstate->last_baud];
 		_port[instance]->begin(baudrate);
 		_port[instance]->set_flow_control(AP_HAL::UARTDriver::FLOW_CONTROL_DISABLE);
 		dstate->last_baud_change_ms = now;
+        dstate->noise_bytes = 0;
 #if UBLOX_RXM_RAW_LOGGING
     if(_raw_data != 0)
         send_blob_start(instance, _initialisation_raw_blob, sizeof(_initialisation_raw_blob));
@@ -249,6 +292,9 @@ AP_GPS::detect_instance(uint8_t instance)
     while (initblob_state[instance].remaining == 0 && _port[instance]->available() > 0
             && new_gps == NULL) {
         uint8_t data = _port[instance]->read();
+        if (_type[instance] != GPS_TYPE_SBP && !detect_preamble(dstate, data)) {
+            dstate->noise_bytes++;
+        }
         /*
           running a uBlox at less than 38400 will lead to packet
           corruption, as we can't receive the packets in the 200ms
@@ -292,6 +338,10 @@ AP_GPS::detect_instance(uint8_t instance)
 				new_gps = new AP_GPS_NMEA(*this, state[instance], _port[instance]);
 			}
 		}
+        if (new_gps != NULL) {
+            // remember the rate, so detection after a reboot starts there
+            _detect_baud[instance].set_and_save_ifchanged(_baudrates[dstate->last_baud]);
+        }
 	}
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_QURT
@@ -304,9 +354,41 @@ found_gps:
 	}
 }
 
+/*
+  look for the two byte preambles of the protocols we detect. At the
+  wrong baud rate the UART delivers framing garbage, where these pairs
+  are rare, so a long run without one means the rate is wrong. SBP
+  only has a one byte preamble and is not checked
+ */
+bool
+AP_GPS::detect_preamble(struct detect_state *dstate, uint8_t data)
+{
+    const uint8_t last = dstate->last_byte;
+    dstate->last_byte = data;
+    if ((last == 0xB5 && data == 0x62) ||               // uBlox, MTK
+        (last == 0xD0 && data == 0xDD) ||               // MTK19 v16
+        (last == 0xD1 && data == 0xDD) ||               // MTK19 v19
+        (last == 0xA0 && data == 0xA2) ||               // SiRF
+        (last == '$' && (data == 'G' || data == 'P'))) { // NMEA
+        dstate->noise_bytes = 0;
+        return true;
+    }
+    return false;
+}
+
 AP_GPS::GPS_Status 
 AP_GPS::highest_supported_status(uint8_t instance) const
 {
+    if (instance == GPS_BLENDED_INSTANCE) {
+        // the blend is as good as the best receiver
+        GPS_Status ret = NO_GPS;
+        for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+            if (drivers[i] != NULL && drivers[i]->highest_supported_status() > ret) {
+                ret = drivers[i]->highest_supported_status();
+            }
+        }
+        return ret == NO_GPS ? AP_GPS::GPS_OK_FIX_3D : ret;
+    }
     if (drivers[instance] != NULL)
         return drivers[instance]->highest_supported_status();
     return AP_GPS::GPS_OK_FIX_3D;
@@ -315,9 +397,7 @@ AP_GPS::highest_supported_status(uint8_t instance) const
 AP_GPS::GPS_Status 
 AP_GPS::highest_supported_status(void) const
 {
-    if (drivers[primary_instance] != NULL)
-        return drivers[primary_instance]->highest_supported_status();
-    return AP_GPS::GPS_OK_FIX_3D;
+    return highest_supported_status(primary_instance);
 }
 
 
@@ -369,8 +449,18 @@ AP_GPS::update_instance(uint8_t instance)
             state[instance].status = NO_GPS;
             state[instance].hdop = 9999;
             timing[instance].last_message_time_ms = tnow;
+            timing[instance].average_delta_ms = 0;
+            // start detection again at the rate it was working at
+            detect_state[instance].last_baud_change_ms = 0;
         }
     } else {
+        // the blend times each receiver out on its own update interval
+        const uint16_t delta_ms = MIN(tnow - timing[instance].last_message_time_ms, 1200U);
+        if (timing[instance].average_delta_ms == 0) {
+            timing[instance].average_delta_ms = delta_ms;
+        } else {
+            timing[instance].average_delta_ms = (9U * timing[instance].average_delta_ms + delta_ms) / 10U;
+        }
         timing[instance].last_message_time_ms = tnow;
         if (state[instance].status >= GPS_OK_FIX_2D) {
             timing[instance].last_fix_time_ms = tnow;
@@ -384,16 +474,20 @@ AP_GPS::update_instance(uint8_t instance)
 void
 AP_GPS::update(void)
 {
-    for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
         update_instance(i);
     }
 
-    // work out which GPS is the primary, and how many sensors we have
-    for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+    // work out which GPS is the primary, and how many sensors we
+    // have. The switching logic runs on the receivers even when the
+    // blend is in use, so it is ready if the blend is lost
+    primary_instance = _primary_receiver;
+    num_instances = 0;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
         if (state[i].status != NO_GPS) {
             num_instances = i+1;
         }
-        if (_auto_switch) {            
+        if (_auto_switch != GPS_AUTO_SWITCH_NONE) {
             if (i == primary_instance) {
                 continue;
             }
@@ -425,12 +519,220 @@ AP_GPS::update(void)
             primary_instance = 0;
         }
     }
+    _primary_receiver = primary_instance;
+
+    if (_auto_switch == GPS_AUTO_SWITCH_BLEND && update_blend()) {
+        primary_instance = GPS_BLENDED_INSTANCE;
+        num_instances = GPS_MAX_INSTANCES;
+    } else {
+        _blend_mask = 0;
+    }
 
 	// update notify with gps status. We always base this on the primary_instance
     AP_Notify::flags.gps_status = state[primary_instance].status;
     AP_Notify::flags.gps_num_sats = state[primary_instance].num_sats;
 }
 
+/*
+  blend the receivers with a 3D fix into GPS_BLENDED_INSTANCE. Each
+  receiver is weighted by the inverse of its reported variance, and its
+  position is moved forward along its velocity to the fix time of the
+  reference receiver (the one with the most weight), so receivers
+  running at different rates or with different latency line up.
+  Returns false if no receiver can be blended
+ */
+bool
+AP_GPS::update_blend(void)
+{
+    const uint32_t now = AP_HAL::millis();
+    float weight_h[GPS_MAX_RECEIVERS] {};
+    float weight_v[GPS_MAX_RECEIVERS] {};
+    float weight_s[GPS_MAX_RECEIVERS] {};
+    float sum_h = 0, sum_v = 0, sum_s = 0;
+    bool all_vertical = true, all_speed = true;
+    uint8_t mask = 0;
+    uint8_t ref = 0;
+
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        const GPS_State &s = state[i];
+        const uint32_t timeout_ms = MAX(GPS_BLEND_TIMEOUT_MS,
+                                        GPS_BLEND_TIMEOUT_INTERVALS * timing[i].average_delta_ms);
+        if (s.status < GPS_OK_FIX_3D ||
+            !s.have_horizontal_accuracy || s.horizontal_accuracy <= 0 ||
+            now - timing[i].last_message_time_ms > timeout_ms) {
+            continue;
+        }
+        mask |= (1U<<i);
+        weight_h[i] = 1.0f / sq(s.horizontal_accuracy);
+        sum_h += weight_h[i];
+        if (s.have_vertical_accuracy && s.vertical_accuracy > 0) {
+            weight_v[i] = 1.0f / sq(s.vertical_accuracy);
+            sum_v += weight_v[i];
+        } else {
+            all_vertical = false;
+        }
+        if (s.have_speed_accuracy && s.speed_accuracy > 0) {
+            weight_s[i] = 1.0f / sq(s.speed_accuracy);
+            sum_s += weight_s[i];
+        } else {
+            all_speed = false;
+        }
+        if (weight_h[i] > weight_h[ref]) {
+            ref = i;
+        }
+    }
+    if (mask == 0) {
+        return false;
+    }
+
+    // a receiver missing an accuracy would otherwise get no say in
+    // that axis, so use the horizontal weights for all of them
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        weight_h[i] /= sum_h;
+        weight_v[i] = all_vertical ? weight_v[i] / sum_v : weight_h[i];
+        weight_s[i] = all_speed ? weight_s[i] / sum_s : weight_h[i];
+    }
+
+    // the blend only gets a new fix when the reference receiver does
+    if (mask == _blend_mask && timing[ref].last_message_time_ms == _blend_ref_message_ms) {
+        return true;
+    }
+
+    GPS_State &blend = state[GPS_BLENDED_INSTANCE];
+    const GPS_State &rs = state[ref];
+
+    // receivers joining the blend start with the offset which puts
+    // them on the current blended position. If the blend is starting
+    // afresh there is nothing to be continuous with
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (!(mask & (1U<<i)) || (_blend_mask & (1U<<i))) {
+            continue;
+        }
+        if (_blend_mask == 0) {
+            _blend_ne_offset_m[i].zero();
+            _blend_alt_offset_cm[i] = 0;
+        } else {
+            _blend_ne_offset_m[i] = location_diff(state[i].location, blend.location);
+            _blend_alt_offset_cm[i] = blend.location.alt - state[i].location.alt;
+        }
+    }
+
+    // position of each receiver relative to the reference, at the
+    // reference fix time, with its offset applied
+    Vector2f ne[GPS_MAX_RECEIVERS];
+    float alt_cm[GPS_MAX_RECEIVERS] {};
+    Vector2f blend_ne;
+    float blend_alt_cm = 0;
+    Vector3f blend_vel;
+    float hacc = 0, vacc = 0, sacc = 0;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (!(mask & (1U<<i))) {
+            continue;
+        }
+        const GPS_State &s = state[i];
+        float dt;
+        if (s.time_week == rs.time_week && s.time_week_ms != 0) {
+            dt = (int32_t)(rs.time_week_ms - s.time_week_ms) * 0.001f;
+        } else {
+            dt = (int32_t)(rs.last_gps_time_ms - s.last_gps_time_ms) * 0.001f;
+        }
+        dt = constrain_float(dt, -0.5f, 0.5f);
+        ne[i] = location_diff(rs.location, s.location) + _blend_ne_offset_m[i] +
+            Vector2f(s.velocity.x, s.velocity.y) * dt;
+        alt_cm[i] = (s.location.alt - rs.location.alt) + _blend_alt_offset_cm[i] -
+            s.velocity.z * dt * 100.0f;
+
+        blend_ne += ne[i] * weight_h[i];
+        blend_alt_cm += alt_cm[i] * weight_v[i];
+        blend_vel += s.velocity * weight_s[i];
+
+        // the weighted mean of the accuracies, rather than the smaller
+        // figure of independent errors, as receivers near each other
+        // share most of their error sources
+        hacc += s.horizontal_accuracy * weight_h[i];
+        vacc += s.vertical_accuracy * weight_v[i];
+        sacc += s.speed_accuracy * weight_s[i];
+    }
+
+    // without the receivers that left, the weights renormalise and the
+    // blend would step by their weighted deviation. Move the offsets of
+    // the remaining receivers so the blend carries on from where the
+    // last one was heading
+    if ((_blend_mask & ~mask) != 0) {
+        const float dt_fix = constrain_float((int32_t)(rs.last_gps_time_ms - blend.last_gps_time_ms) * 0.001f, 0.0f, 1.0f);
+        Location expected = blend.location;
+        location_offset(expected, blend.velocity.x * dt_fix, blend.velocity.y * dt_fix);
+        const Vector2f step_ne = location_diff(rs.location, expected) - blend_ne;
+        const float step_alt_cm = (expected.alt - blend.velocity.z * dt_fix * 100.0f) -
+            rs.location.alt - blend_alt_cm;
+        for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+            if (!(mask & (1U<<i))) {
+                continue;
+            }
+            _blend_ne_offset_m[i] += step_ne;
+            _blend_alt_offset_cm[i] += step_alt_cm;
+        }
+        blend_ne += step_ne;
+        blend_alt_cm += step_alt_cm;
+    }
+
+    // decay every offset towards zero, so the position step that a
+    // joining or leaving receiver would cause is spread over about
+    // GPS_BLEND_TIME_CONSTANT seconds and the blend then settles on
+    // the weighted mean of the raw receiver positions
+    float dt_update = (now - _blend_update_ms) * 0.001f;
+    if (_blend_mask == 0 || dt_update > 1.0f) {
+        dt_update = 1.0f;
+    }
+    const float alpha = dt_update / (GPS_BLEND_TIME_CONSTANT + dt_update);
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (!(mask & (1U<<i))) {
+            continue;
+        }
+        _blend_ne_offset_m[i] *= (1.0f - alpha);
+        _blend_alt_offset_cm[i] *= (1.0f - alpha);
+    }
+
+    blend.instance = GPS_BLENDED_INSTANCE;
+    blend.status = NO_FIX;
+    blend.num_sats = 0;
+    blend.hdop = 9999;
+    blend.vdop = 9999;
+    blend.have_vertical_velocity = true;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (!(mask & (1U<<i))) {
+            continue;
+        }
+        const GPS_State &s = state[i];
+        blend.status = MAX(blend.status, s.status);
+        blend.num_sats = MAX(blend.num_sats, s.num_sats);
+        blend.hdop = MIN(blend.hdop, s.hdop);
+        blend.vdop = MIN(blend.vdop, s.vdop);
+        blend.have_vertical_velocity &= s.have_vertical_velocity;
+    }
+    blend.time_week = rs.time_week;
+    blend.time_week_ms = rs.time_week_ms;
+    blend.last_gps_time_ms = rs.last_gps_time_ms;
+    blend.location = rs.location;
+    location_offset(blend.location, blend_ne.x, blend_ne.y);
+    blend.location.alt = rs.location.alt + blend_alt_cm;
+    blend.velocity = blend_vel;
+    blend.ground_speed = pythagorous2(blend_vel.x, blend_vel.y);
+    blend.ground_course_cd = wrap_360_cd(degrees(atan2f(blend_vel.y, blend_vel.x)) * 100UL);
+    blend.horizontal_accuracy = hacc;
+    blend.have_horizontal_accuracy = true;
+    blend.vertical_accuracy = vacc;
+    blend.have_vertical_accuracy = all_vertical;
+    blend.speed_accuracy = sacc;
+    blend.have_speed_accuracy = all_speed;
+    timing[GPS_BLENDED_INSTANCE] = timing[ref];
+
+    _blend_mask = mask;
+    _blend_ref_message_ms = timing[ref].last_message_time_ms;
+    _blend_update_ms = now;
+    return true;
+}
+
 /*
   set HIL (hardware in the loop) status for a GPS instance
  */
@@ -439,7 +741,7 @@ AP_GPS::setHIL(uint8_t instance, GPS_Status _status, uint64_t time_epoch_ms,
                const Location &_location, const Vector3f &_velocity, uint8_t _num_sats, 
                uint16_t hdop, bool _have_vertical_velocity)
 {
-    if (instance >= GPS_MAX_INSTANCES) {
+    if (instance >= GPS_MAX_RECEIVERS) {
         return;
     }
     uint32_t tnow = AP_HAL::millis();
@@ -471,7 +773,7 @@ void
 AP_GPS::lock_port(uint8_t instance, bool lock)
 {
 
-    if (instance >= GPS_MAX_INSTANCES) {
+    if (instance >= GPS_MAX_RECEIVERS) {
         return;
     }
     if (lock) {
@@ -487,7 +789,7 @@ AP_GPS::inject_data(uint8_t *data, uint8_t len)
 {
     //Support broadcasting to all GPSes.
     if (_inject_to == GPS_RTK_INJECT_TO_ALL) {
-        for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+        for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
             inject_data(i, data, len);
         }
     } else {
@@ -498,7 +800,7 @@ AP_GPS::inject_data(uint8_t *data, uint8_t len)
 void 
 AP_GPS::inject_data(uint8_t instance, uint8_t *data, uint8_t len)
 {
-    if (instance < GPS_MAX_INSTANCES && drivers[instance] != NULL)
+    if (instance < GPS_MAX_RECEIVERS && drivers[instance] != NULL)
         drivers[instance]->inject_data(data, len);
 }  
 
@@ -28,10 +28,24 @@
 #include <AP_SerialManager/AP_SerialManager.h>
 
 /**
-   maximum number of GPS instances available on this platform. If more
+   maximum number of GPS receivers available on this platform. If more
    than 1 then redundent sensors may be available
  */
-#define GPS_MAX_INSTANCES 2
+#define GPS_MAX_RECEIVERS 3
+
+// one more instance than there are receivers, holding the blended
+// solution of the receivers when GPS_AUTO_SWITCH is 2
+#define GPS_MAX_INSTANCES (GPS_MAX_RECEIVERS + 1)
+#define GPS_BLENDED_INSTANCE GPS_MAX_RECEIVERS
+
+// time constant of the per-receiver offsets which keep the blended
+// position continuous as receivers join and leave the blend
+#define GPS_BLEND_TIME_CONSTANT 10.0f
+
+// receivers with no message for this many of their own update
+// intervals, and at least GPS_BLEND_TIMEOUT_MS, are left out of the blend
+#define GPS_BLEND_TIMEOUT_INTERVALS 2
+#define GPS_BLEND_TIMEOUT_MS 500
 #define GPS_RTK_INJECT_TO_ALL 127
 
 class DataFlash_Class;
@@ -72,6 +86,13 @@ public:
 		GPS_TYPE_QURT  = 12,
     };
 
+    // GPS_AUTO_SWITCH settings
+    enum GPS_Auto_Switch {
+        GPS_AUTO_SWITCH_NONE  = 0,
+        GPS_AUTO_SWITCH_BEST  = 1,
+        GPS_AUTO_SWITCH_BLEND = 2
+    };
+
     /// GPS status codes
     enum GPS_Status {
         NO_GPS = 0,             ///< No GPS connected/detected
@@ -307,7 +328,7 @@ public:
     DataFlash_Class *_DataFlash;
 
     // configuration parameters
-    AP_Int8 _type[GPS_MAX_INSTANCES];
+    AP_Int8 _type[GPS_MAX_RECEIVERS];
     AP_Int8 _navfilter;
     AP_Int8 _auto_switch;
     AP_Int8 _min_dgps;
@@ -319,6 +340,7 @@ public:
     AP_Int8 _raw_data;
     AP_Int8 _gnss_mode;
     AP_Int8 _save_config;
+    AP_Int32 _detect_baud[GPS_MAX_RECEIVERS];
     
     // handle sending of initialisation strings to the GPS
     void send_blob_start(uint8_t instance, const char *_blob, uint16_t size);
@@ -345,49 +367,74 @@ private:
 
         // the time we got our last fix in system milliseconds
         uint32_t last_message_time_ms;
+
+        // filtered time between messages, 0 until measured
+        uint16_t average_delta_ms;
     };
     GPS_timing timing[GPS_MAX_INSTANCES];
     GPS_State state[GPS_MAX_INSTANCES];
-    AP_GPS_Backend *drivers[GPS_MAX_INSTANCES];
-    AP_HAL::UARTDriver *_port[GPS_MAX_INSTANCES];
+    AP_GPS_Backend *drivers[GPS_MAX_RECEIVERS];
+    AP_HAL::UARTDriver *_port[GPS_MAX_RECEIVERS];
 
-    /// primary GPS instance
+    /// primary GPS instance, GPS_BLENDED_INSTANCE when blending
     uint8_t primary_instance:2;
 
     /// number of GPS instances present
-    uint8_t num_instances:2;
+    uint8_t num_instances:3;
 
     // which ports are locked
-    uint8_t locked_ports:2;
+    uint8_t locked_ports:GPS_MAX_RECEIVERS;
+
+    // the receiver auto switch would use, which is the primary when
+    // the blend is not in use
+    uint8_t _primary_receiver;
+
+    // blending state. Each receiver has an offset which moves it
+    // towards the blended solution. A joining receiver starts on the
+    // blended position, and when a receiver leaves the offsets of the
+    // others are moved so the blended position does not step
+    Vector2f _blend_ne_offset_m[GPS_MAX_RECEIVERS];
+    float _blend_alt_offset_cm[GPS_MAX_RECEIVERS];
+    uint8_t _blend_mask;                // receivers in the last blend
+    uint32_t _blend_ref_message_ms;     // message time of the reference receiver in the last blend
+    uint32_t _blend_update_ms;
 
     // state of auto-detection process, per instance
     struct detect_state {
         uint32_t detect_started_ms;
-        uint32_t last_baud_change_ms;
+        uint32_t last_baud_change_ms;   // 0 until the port is opened
         uint8_t last_baud;
+        uint16_t noise_bytes;           // bytes since the last preamble
+        uint8_t last_byte;
         struct UBLOX_detect_state ublox_detect_state;
         struct MTK_detect_state mtk_detect_state;
         struct MTK19_detect_state mtk19_detect_state;
         struct SIRF_detect_state sirf_detect_state;
         struct NMEA_detect_state nmea_detect_state;
         struct SBP_detect_state sbp_detect_state;
-    } detect_state[GPS_MAX_INSTANCES];
+    } detect_state[GPS_MAX_RECEIVERS];
 
     struct {
         const char *blob;
         uint16_t remaining;
-    } initblob_state[GPS_MAX_INSTANCES];
+    } initblob_state[GPS_MAX_RECEIVERS];
 
     static const uint32_t  _baudrates[];
     static const char _initialisation_blob[];
     static const char _initialisation_raw_blob[];
 
     void detect_instance(uint8_t instance);
+    bool detect_preamble(struct detect_state *dstate, uint8_t data);
+    bool update_blend(void);
     void update_instance(uint8_t instance);
 };
 
 #define GPS_BAUD_TIME_MS 1200
 
+// bytes received at one baud rate without any protocol preamble before
+// the rate is taken to be wrong and the next one is tried
+#define GPS_DETECT_NOISE_BYTES 512
+
 #include "GPS_Backend.h"
 #include "AP_GPS_UBLOX.h"
 #include "AP_GPS_MTK.h"
@@ -118,23 +118,26 @@ AP_GPS_NMEA::AP_GPS_NMEA(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::UARTDr
 
 bool AP_GPS_NMEA::read(void)
 {
-    int16_t numc;
+    uint8_t buf[64];
+    uint16_t numc;
     bool parsed = false;
 
-    numc = port->available();
-    while (numc--) {
-        char c = port->read();
+    // NMEA terms are decoded a character at a time, but the port is
+    // read a span at a time
+    while ((numc = port->read(buf, sizeof(buf))) > 0) {
 #ifdef NMEA_LOG_PATH
         static FILE *logf = NULL;
         if (logf == NULL) {
             logf = fopen(NMEA_LOG_PATH, "wb");
         }
         if (logf != NULL) {
-            ::fwrite(&c, 1, 1, logf);
+            ::fwrite(buf, 1, numc, logf);
         }
 #endif
-        if (_decode(c)) {
-            parsed = true;
+        for (uint16_t i = 0; i < numc; i++) {
+            if (_decode((char)buf[i])) {
+                parsed = true;
+            }
         }
     }
     return parsed;
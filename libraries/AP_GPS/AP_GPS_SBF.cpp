@@ -43,8 +43,6 @@ AP_GPS_SBF::AP_GPS_SBF(AP_GPS &_gps, AP_GPS::GPS_State &_state,
                        AP_HAL::UARTDriver *_port) :
     AP_GPS_Backend(_gps, _state, _port)
 {
-    sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE1;
-
     port->write((const uint8_t*)_initialisation_blob[0], strlen(_initialisation_blob[0]));
 }
 
@@ -69,95 +67,76 @@ AP_GPS_SBF::read(void)
     }
 
     bool ret = false;
-    while (port->available() > 0) {
-        uint8_t temp = port->read();
-        ret |= parse(temp);
+    while (_framer.fill(port) > 0) {
+        ret |= parse();
     }
 
     return ret;
 }
 
+/*
+  process the complete blocks and command replies in the framer. A
+  partial block is left for the next read()
+ */
 bool
-AP_GPS_SBF::parse(uint8_t temp)
+AP_GPS_SBF::parse(void)
 {
-    switch (sbf_msg.sbf_state)
-    {
-        default:
-        case sbf_msg_parser_t::PREAMBLE1:
-            if (temp == SBF_PREAMBLE1) {
-                sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE2;
-                sbf_msg.read = 0;
-            } else if (temp == '$') {
-                // this is a command response
-                sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE2;
-            }
-            break;
-        case sbf_msg_parser_t::PREAMBLE2:
-            if (temp == SBF_PREAMBLE2) {
-                sbf_msg.sbf_state = sbf_msg_parser_t::CRC1;
-            } else if (temp == 'R') {
-                validcommand = true;
-                sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE1;
-            }
-            else
-            {
-                sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE1;
-            }
-            break;
-        case sbf_msg_parser_t::CRC1:
-            sbf_msg.crc = temp;
-            sbf_msg.sbf_state = sbf_msg_parser_t::CRC2;
-            break;
-        case sbf_msg_parser_t::CRC2:
-            sbf_msg.crc += (uint16_t)(temp << 8);
-            sbf_msg.sbf_state = sbf_msg_parser_t::BLOCKID1;
-            break;
-        case sbf_msg_parser_t::BLOCKID1:
-            sbf_msg.blockid = temp;
-            sbf_msg.sbf_state = sbf_msg_parser_t::BLOCKID2;
-            break;
-        case sbf_msg_parser_t::BLOCKID2:
-            sbf_msg.blockid += (uint16_t)(temp << 8);
-            sbf_msg.sbf_state = sbf_msg_parser_t::LENGTH1;
-            break;
-        case sbf_msg_parser_t::LENGTH1:
-            sbf_msg.length = temp;
-            sbf_msg.sbf_state = sbf_msg_parser_t::LENGTH2;
+    bool ret = false;
+
+    // both blocks and command replies start with '$'
+    while (_framer.sync(SBF_PREAMBLE1)) {
+        if (_framer.available() < 2) {
             break;
-        case sbf_msg_parser_t::LENGTH2:
-            sbf_msg.length += (uint16_t)(temp << 8);
-            sbf_msg.sbf_state = sbf_msg_parser_t::DATA;
-            if (sbf_msg.length % 4 != 0) {
-                sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE1;
-                Debug("bad packet length=%u\n", (unsigned)sbf_msg.length);
-            }
+        }
+        const uint8_t *frame = _framer.data();
+        if (frame[1] == 'R') {
+            // this is a command response
+            validcommand = true;
+            _framer.consume(2);
+            continue;
+        }
+        if (frame[1] != SBF_PREAMBLE2) {
+            _framer.consume(1);
+            continue;
+        }
+
+        // preamble, crc, block id and length
+        if (_framer.available() < 8) {
             break;
-        case sbf_msg_parser_t::DATA:
-            if (sbf_msg.read >= sizeof(sbf_msg.data)) {
-                Debug("parse overflow length=%u\n", (unsigned)sbf_msg.read);
-                sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE1;
-                break;
-            }
-            sbf_msg.data.bytes[sbf_msg.read] = temp;
-            sbf_msg.read++;
-            if (sbf_msg.read >= (sbf_msg.length - 8)) {
-                uint16_t crc = crc16_ccitt((uint8_t*)&sbf_msg.blockid, 2, 0);
-                crc = crc16_ccitt((uint8_t*)&sbf_msg.length, 2, crc);
-                crc = crc16_ccitt((uint8_t*)&sbf_msg.data, sbf_msg.length - 8, crc);
-
-                sbf_msg.sbf_state = sbf_msg_parser_t::PREAMBLE1;
-
-                if (sbf_msg.crc == crc) {
-                    return process_message();
-                } else {
-                    Debug("crc fail\n");
-                    crc_error_counter++;
-                }
-            }
+        }
+        const uint16_t length = frame[6] | ((uint16_t)frame[7] << 8);
+        if (length % 4 != 0 || length < 8) {
+            Debug("bad packet length=%u\n", (unsigned)length);
+            _framer.consume(1);
+            continue;
+        }
+        if (length - 8U > sizeof(sbf_msg.data)) {
+            Debug("parse overflow length=%u\n", (unsigned)length);
+            _framer.consume(1);
+            continue;
+        }
+        if (_framer.available() < length) {
             break;
+        }
+
+        // the crc covers the block id, length and data
+        const uint16_t crc = crc16_ccitt(&frame[4], length - 4, 0);
+        if (crc != (frame[2] | ((uint16_t)frame[3] << 8))) {
+            Debug("crc fail\n");
+            crc_error_counter++;
+            _framer.consume(1);
+            continue;
+        }
+
+        sbf_msg.blockid = frame[4] | ((uint16_t)frame[5] << 8);
+        sbf_msg.length = length;
+        memcpy(sbf_msg.data.bytes, &frame[8], length - 8);
+        _framer.consume(length);
+
+        ret |= process_message();
     }
 
-    return false;
+    return ret;
 }
 
 void
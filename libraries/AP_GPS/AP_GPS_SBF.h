@@ -23,6 +23,7 @@
 #define __AP_GPS_SBF_H__
 
 #include "AP_GPS.h"
+#include "GPS_Framer.h"
 
 #define SBF_SETUP_MSG "\nsso, Stream1, COM1, PVTGeodetic+DOP+ExtEventPVTGeodetic, msec100\n"
 
@@ -40,7 +41,7 @@ public:
 
 private:
 
-    bool parse(uint8_t temp);
+    bool parse(void);
     bool process_message();
 
     static const uint8_t SBF_PREAMBLE1 = '$';
@@ -114,28 +115,17 @@ private:
         uint8_t bytes[128];
     };
 
-    struct sbf_msg_parser_t
+    // the last block received with a good crc
+    struct sbf_msg_t
     {
-        enum
-        {
-            PREAMBLE1 = 0,
-            PREAMBLE2,
-            CRC1,
-            CRC2,
-            BLOCKID1,
-            BLOCKID2,
-            LENGTH1,
-            LENGTH2,
-            DATA
-        } sbf_state;
-        uint16_t preamble;
-        uint16_t crc;
         uint16_t blockid;
         uint16_t length;
         msgbuffer data;
-        uint16_t read;
     } sbf_msg;
 
+    // received blocks: preamble, crc, block id, length and data
+    GPS_Framer<8 + sizeof(msgbuffer)> _framer;
+
     void log_ExtEventPVTGeodetic(const msg4007 &temp);
 };
 
@@ -58,8 +58,6 @@ AP_GPS_SBP::AP_GPS_SBP(AP_GPS &_gps, AP_GPS::GPS_State &_state,
 
     Debug("SBP Driver Initialized");
 
-    parser_state.state = sbp_parser_state_t::WAITING;
-
     //Externally visible state
     state.status = AP_GPS::NO_FIX;
     state.have_vertical_velocity = true;
@@ -98,84 +96,40 @@ AP_GPS_SBP::inject_data(uint8_t *data, uint8_t len)
 }
 
 //This attempts to reads all SBP messages from the incoming port.
-//Returns true if a new message was read, false if we failed to read a message.
+//Frames are collected in bulk by the framer, and each complete frame
+//with a good CRC is copied to parser_state and dispatched.
 void
 AP_GPS_SBP::_sbp_process() 
 {
-
-    while (port->available() > 0) {
-        uint8_t temp = port->read();
-        uint16_t crc;
-
-
-        //This switch reads one character at a time,
-        //parsing it into buffers until a full message is dispatched
-        switch(parser_state.state) {
-            case sbp_parser_state_t::WAITING:
-                if (temp == SBP_PREAMBLE) {
-                    parser_state.n_read = 0;
-                    parser_state.state = sbp_parser_state_t::GET_TYPE;
-                }
+    while (_framer.fill(port) > 0) {
+        while (_framer.sync(SBP_PREAMBLE)) {
+            // preamble, type, sender and length
+            if (_framer.available() < 6) {
                 break;
-
-            case sbp_parser_state_t::GET_TYPE:
-                *((uint8_t*)&(parser_state.msg_type) + parser_state.n_read) = temp;
-                parser_state.n_read += 1;
-                if (parser_state.n_read >= 2) {
-                    parser_state.n_read = 0;
-                    parser_state.state = sbp_parser_state_t::GET_SENDER;
-                }
-                break;
-
-            case sbp_parser_state_t::GET_SENDER:
-                *((uint8_t*)&(parser_state.sender_id) + parser_state.n_read) = temp;
-                parser_state.n_read += 1;
-                if (parser_state.n_read >= 2) {
-                    parser_state.n_read = 0;
-                    parser_state.state = sbp_parser_state_t::GET_LEN;
-                }
-                break;
-
-            case sbp_parser_state_t::GET_LEN:
-                parser_state.msg_len = temp;
-                parser_state.n_read = 0;
-                parser_state.state = sbp_parser_state_t::GET_MSG;
+            }
+            const uint8_t *frame = _framer.data();
+            const uint8_t msg_len = frame[5];
+            if (_framer.available() < msg_len + 8U) {
                 break;
+            }
 
-            case sbp_parser_state_t::GET_MSG:
-                *((uint8_t*)&(parser_state.msg_buff) + parser_state.n_read) = temp;
-                parser_state.n_read += 1;
-                if (parser_state.n_read >= parser_state.msg_len) {
-                    parser_state.n_read = 0;
-                    parser_state.state = sbp_parser_state_t::GET_CRC;
-                }
-                break;
+            // the CRC covers everything after the preamble
+            const uint16_t crc = crc16_ccitt(&frame[1], msg_len + 5, 0);
+            if (crc != (frame[msg_len+6] | ((uint16_t)frame[msg_len+7] << 8))) {
+                Debug("CRC Error Occurred!");
+                crc_error_counter += 1;
+                _framer.consume(1);
+                continue;
+            }
 
-            case sbp_parser_state_t::GET_CRC:
-                *((uint8_t*)&(parser_state.crc) + parser_state.n_read) = temp;
-                parser_state.n_read += 1;
-                if (parser_state.n_read >= 2) {
-                    parser_state.state = sbp_parser_state_t::WAITING;
-
-                    crc = crc16_ccitt((uint8_t*)&(parser_state.msg_type), 2, 0);
-                    crc = crc16_ccitt((uint8_t*)&(parser_state.sender_id), 2, crc);
-                    crc = crc16_ccitt(&(parser_state.msg_len), 1, crc);
-                    crc = crc16_ccitt(parser_state.msg_buff, parser_state.msg_len, crc);
-                    if (parser_state.crc == crc) {
-                        _sbp_process_message();
-                    } else {
-                        Debug("CRC Error Occurred!");
-                        crc_error_counter += 1;
-                    }
-
-                    parser_state.state = sbp_parser_state_t::WAITING;                
-                }
-                break;
+            parser_state.msg_type = frame[1] | ((uint16_t)frame[2] << 8);
+            parser_state.sender_id = frame[3] | ((uint16_t)frame[4] << 8);
+            parser_state.msg_len = msg_len;
+            memcpy(parser_state.msg_buff, &frame[6], msg_len);
+            _framer.consume(msg_len + 8);
 
-            default:
-                parser_state.state = sbp_parser_state_t::WAITING;
-                break;
-            }
+            _sbp_process_message();
+        }
     }
 }
 
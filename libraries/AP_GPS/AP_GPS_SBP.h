@@ -25,6 +25,7 @@
 #define __AP_GPS_SBP_H__
 
 #include "AP_GPS.h"
+#include "GPS_Framer.h"
 
 class AP_GPS_SBP : public AP_GPS_Backend
 {
@@ -46,24 +47,18 @@ private:
     // Swift Navigation SBP protocol types and definitions
     // ************************************************************************
   
+    // the last message received with a good CRC
     struct sbp_parser_state_t {
-      enum {
-        WAITING = 0,
-        GET_TYPE = 1,
-        GET_SENDER = 2,
-        GET_LEN = 3,
-        GET_MSG = 4,
-        GET_CRC = 5
-      } state:8;
       uint16_t msg_type;
       uint16_t sender_id;
-      uint16_t crc;
       uint8_t msg_len;
-      uint8_t n_read;
       uint8_t msg_buff[256];
     } parser_state;
 
     static const uint8_t SBP_PREAMBLE = 0x55;
+
+    // received frames: preamble, type, sender, length, payload and CRC
+    GPS_Framer<8 + 255> _framer;
     
     //Message types supported by this driver
     static const uint16_t SBP_STARTUP_MSGTYPE        = 0xFF00;    
@@ -44,10 +44,8 @@ extern const AP_HAL::HAL& hal;
 
 AP_GPS_UBLOX::AP_GPS_UBLOX(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::UARTDriver *_port) :
     AP_GPS_Backend(_gps, _state, _port),
-    _step(0),
     _msg_id(0),
     _payload_length(0),
-    _payload_counter(0),
     _fix_count(0),
     _class(0),
     _cfg_saved(false),
@@ -144,18 +142,15 @@ AP_GPS_UBLOX::send_next_rate_update(void)
 
 // Process bytes available from the stream
 //
-// The stream is assumed to contain only messages we recognise.  If it
-// contains other messages, and those messages contain the preamble
-// bytes, it is possible for this code to fail to synchronise to the
-// stream immediately.  Without buffering the entire message and
-// re-processing it from the top, this is unavoidable. The parser
-// attempts to avoid this when possible.
+// Everything waiting on the port is pulled into the framer in bulk.
+// Frames are found by scanning for the preamble, and only checksummed
+// and parsed once the whole frame has arrived. A frame that fails its
+// checksum is skipped one byte at a time, so a preamble appearing as
+// data in some other message can't make us lose the next real one.
 //
 bool
 AP_GPS_UBLOX::read(void)
 {
-    uint8_t data;
-    int16_t numc;
     bool parsed = false;
     uint32_t millis_now = AP_HAL::millis();
 
@@ -167,108 +162,43 @@ AP_GPS_UBLOX::read(void)
         _num_cfg_save_tries++;
     }
 
-    numc = port->available();
-    for (int16_t i = 0; i < numc; i++) {        // Process bytes received
-
-        // read the next byte
-        data = port->read();
-
-	reset:
-        switch(_step) {
-
-        // Message preamble detection
-        //
-        // If we fail to match any of the expected bytes, we reset
-        // the state machine and re-consider the failed byte as
-        // the first byte of the preamble.  This improves our
-        // chances of recovering from a mismatch and makes it less
-        // likely that we will be fooled by the preamble appearing
-        // as data in some other message.
-        //
-        case 1:
-            if (PREAMBLE2 == data) {
-                _step++;
+    while (_framer.fill(port) > 0) {
+        while (_framer.sync(PREAMBLE1, PREAMBLE2)) {
+            // preamble, class, id and payload length
+            if (_framer.available() < 6) {
                 break;
             }
-            _step = 0;
-            Debug("reset %u", __LINE__);
-            /* no break */
-        case 0:
-            if(PREAMBLE1 == data)
-                _step++;
-            break;
-
-        // Message header processing
-        //
-        // We sniff the class and message ID to decide whether we
-        // are going to gather the message bytes or just discard
-        // them.
-        //
-        // We always collect the length so that we can avoid being
-        // fooled by preamble bytes in messages.
-        //
-        case 2:
-            _step++;
-            _class = data;
-            _ck_b = _ck_a = data;                               // reset the checksum accumulators
-            break;
-        case 3:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-            _msg_id = data;
-            break;
-        case 4:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-            _payload_length = data;                             // payload length low byte
-            break;
-        case 5:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-
-            _payload_length += (uint16_t)(data<<8);
-            if (_payload_length > sizeof(_buffer)) {
-                Debug("large payload %u", (unsigned)_payload_length);
+            const uint8_t *frame = _framer.data();
+            const uint16_t payload_length = frame[4] | ((uint16_t)frame[5] << 8);
+            if (payload_length > sizeof(_buffer)) {
+                Debug("large payload %u", (unsigned)payload_length);
                 // assume any payload bigger then what we know about is noise
-                _payload_length = 0;
-                _step = 0;
-				goto reset;
+                _framer.consume(1);
+                continue;
             }
-            _payload_counter = 0;                               // prepare to receive payload
-            break;
-
-        // Receive message data
-        //
-        case 6:
-            _ck_b += (_ck_a += data);                   // checksum byte
-            if (_payload_counter < sizeof(_buffer)) {
-                _buffer.bytes[_payload_counter] = data;
+            if (_framer.available() < payload_length + 8) {
+                break;
             }
-            if (++_payload_counter == _payload_length)
-                _step++;
-            break;
 
-        // Checksum and message processing
-        //
-        case 7:
-            _step++;
-            if (_ck_a != data) {
-                Debug("bad cka %x should be %x", data, _ck_a);
-                _step = 0;
-				goto reset;
-            }
-            break;
-        case 8:
-            _step = 0;
-            if (_ck_b != data) {
-                Debug("bad ckb %x should be %x", data, _ck_b);
-                break;                                                  // bad checksum
+            // the checksum covers class, id, length and payload
+            uint8_t ck_a = 0, ck_b = 0;
+            _update_checksum(&frame[2], payload_length + 4, ck_a, ck_b);
+            if (ck_a != frame[payload_length+6] || ck_b != frame[payload_length+7]) {
+                Debug("bad checksum %x %x should be %x %x",
+                      frame[payload_length+6], frame[payload_length+7], ck_a, ck_b);
+                _framer.consume(1);
+                continue;
             }
 
+            _class = frame[2];
+            _msg_id = frame[3];
+            _payload_length = payload_length;
+            memcpy(_buffer.bytes, &frame[6], payload_length);
+            _framer.consume(payload_length + 8);
+
             if (_parse_gps()) {
                 parsed = true;
             }
-            break;
         }
     }
     return parsed;
@@ -723,7 +653,7 @@ AP_GPS_UBLOX::_parse_gps(void)
  *  update checksum for a set of bytes
  */
 void
-AP_GPS_UBLOX::_update_checksum(uint8_t *data, uint16_t len, uint8_t &ck_a, uint8_t &ck_b)
+AP_GPS_UBLOX::_update_checksum(const uint8_t *data, uint16_t len, uint8_t &ck_a, uint8_t &ck_b)
 {
     while (len--) {
         ck_a += *data;
@@ -25,6 +25,7 @@
 
 #include <AP_HAL/AP_HAL.h>
 #include "AP_GPS.h"
+#include "GPS_Framer.h"
 
 /*
  *  try to put a UBlox into binary mode. This is in two parts. 
@@ -387,15 +388,12 @@ private:
         UBLOX_M8
     };
 
-    // Packet checksum accumulators
-    uint8_t         _ck_a;
-    uint8_t         _ck_b;
+    // received frames, preamble to checksum
+    GPS_Framer<sizeof(_buffer) + 8> _framer;
 
-    // State machine state
-    uint8_t         _step;
+    // header of the message in _buffer
     uint8_t         _msg_id;
     uint16_t        _payload_length;
-    uint16_t        _payload_counter;
 
     // 8 bit count of fix messages processed, used for periodic
     // processing
@@ -431,7 +429,7 @@ private:
     void        _configure_message_rate(uint8_t msg_class, uint8_t msg_id, uint8_t rate);
     void        _configure_gps(void);
     void        _configure_sbas(bool enable);
-    void        _update_checksum(uint8_t *data, uint16_t len, uint8_t &ck_a, uint8_t &ck_b);
+    void        _update_checksum(const uint8_t *data, uint16_t len, uint8_t &ck_a, uint8_t &ck_b);
     void        _send_message(uint8_t msg_class, uint8_t msg_id, void *msg, uint16_t size);
     void		send_next_rate_update(void);
     void        _request_version(void);
@@ -444,9 +442,11 @@ private:
     void log_rxm_raw(const struct ubx_rxm_raw &raw);
     void log_rxm_rawx(const struct ubx_rxm_rawx &raw);
 
-    // Calculates the correct log message ID based on what GPS instance is being logged
+    // Calculates the correct log message ID based on what GPS instance
+    // is being logged. Only two sets of messages exist, so the third
+    // receiver shares the second's and is told apart by the instance field
     uint8_t _ubx_msg_log_index(uint8_t ubx_msg) {
-        return (uint8_t)(ubx_msg + (state.instance * UBX_MSG_TYPES));
+        return (uint8_t)(ubx_msg + (MIN(state.instance, 1) * UBX_MSG_TYPES));
     }
 };
 
@@ -0,0 +1,115 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  framing buffer for binary GPS protocols
+
+  Rather than feeding the UART a byte at a time through a state
+  machine, a driver pulls everything waiting on the port into the
+  framer in one read, skips to the next preamble with memchr(), and
+  once a whole frame is buffered checks its checksum over the span
+  and decodes it in place. Partial frames stay in the buffer until
+  the rest arrives.
+
+  A driver reads like this:
+
+    while (framer.fill(port) > 0) {
+        while (framer.sync(PREAMBLE1, PREAMBLE2)) {
+            if (framer.available() < header length) break;
+            ...work out the frame length from the header...
+            if (frame too long for the buffer) { framer.consume(1); continue; }
+            if (framer.available() < frame length) break;
+            ...check the checksum and decode framer.data()...
+            framer.consume(frame length);
+        }
+    }
+
+  SIZE must be at least the longest frame the driver accepts.
+ */
+#ifndef __GPS_FRAMER_H__
+#define __GPS_FRAMER_H__
+
+#include <AP_HAL/AP_HAL.h>
+#include <string.h>
+
+template <uint16_t SIZE>
+class GPS_Framer
+{
+public:
+    GPS_Framer() : _start(0), _end(0) {}
+
+    // move the unparsed bytes to the front of the buffer and append
+    // as much of the port's input as fits. Returns the bytes added
+    uint16_t fill(AP_HAL::UARTDriver *port) {
+        if (_start != 0) {
+            memmove(&_buf[0], &_buf[_start], _end - _start);
+            _end -= _start;
+            _start = 0;
+        }
+        if (_end == SIZE) {
+            return 0;
+        }
+        uint16_t n = port->read(&_buf[_end], SIZE - _end);
+        _end += n;
+        return n;
+    }
+
+    const uint8_t *data(void) const { return &_buf[_start]; }
+    uint16_t available(void) const { return _end - _start; }
+
+    void consume(uint16_t n) {
+        if (n > available()) {
+            n = available();
+        }
+        _start += n;
+    }
+
+    // discard bytes before the first preamble1 byte. Returns true if
+    // the data now starts with it
+    bool sync(uint8_t preamble1) {
+        const uint8_t *p = (const uint8_t *)memchr(data(), preamble1, available());
+        if (p == NULL) {
+            _start = _end;
+            return false;
+        }
+        _start = p - &_buf[0];
+        return true;
+    }
+
+    // discard bytes before the first preamble1, preamble2 pair. A
+    // preamble1 in the last byte is kept, as the pair may be completed
+    // by the next fill(). Returns true if the data now starts with the
+    // whole pair
+    bool sync(uint8_t preamble1, uint8_t preamble2) {
+        while (sync(preamble1)) {
+            if (available() < 2) {
+                return false;
+            }
+            if (_buf[_start+1] == preamble2) {
+                return true;
+            }
+            _start++;
+        }
+        return false;
+    }
+
+private:
+    uint8_t _buf[SIZE];
+    uint16_t _start;
+    uint16_t _end;
+};
+
+#endif // __GPS_FRAMER_H__
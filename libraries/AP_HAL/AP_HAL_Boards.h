@@ -186,7 +186,16 @@
 #define HAL_CPU_CLASS HAL_CPU_CLASS_1000
 #define HAL_OS_POSIX_IO 1
 #define HAL_OS_SOCKETS 1
+// the log-structured storage backend is not limited to the size of
+// the old flat storage file
+#ifndef HAL_LINUX_STORAGE_LOG
+#define HAL_LINUX_STORAGE_LOG 0
+#endif
+#if HAL_LINUX_STORAGE_LOG
+#define HAL_STORAGE_SIZE            32768
+#else
 #define HAL_STORAGE_SIZE            16384
+#endif
 #define HAL_STORAGE_SIZE_AVAILABLE  HAL_STORAGE_SIZE
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NONE
 #define HAL_BOARD_LOG_DIRECTORY "logs"
@@ -55,6 +55,13 @@ public:
 
     /* execute receiver bind */
     virtual bool rc_bind(int dsmMode) { return false; };
+
+    /**
+     * Time in microseconds, on the AP_HAL::micros64() clock, that the
+     * last complete frame from the receiver ended, or 0 if the
+     * implementation does not time frames
+     */
+    virtual uint64_t last_frame_us(void) { return 0; }
 };
 
 #endif // __AP_HAL_RC_INPUT_H__
@@ -22,6 +22,27 @@ public:
     virtual AP_HAL::Semaphore* get_semaphore() = 0;
     virtual bool transaction(const uint8_t *tx, uint8_t *rx, uint16_t len) = 0;
 
+    /**
+       optional batched interface: perform count transactions, with
+       the chip select released between each of them. HALs which can
+       submit them to the bus in one go override this; the default is
+       one transaction() call per transfer.
+     */
+    struct Transfer {
+        const uint8_t *tx;
+        uint8_t *rx;
+        uint16_t len;
+    };
+
+    virtual bool transactions(const struct Transfer *xfers, uint8_t count) {
+        for (uint8_t i=0; i<count; i++) {
+            if (!transaction(xfers[i].tx, xfers[i].rx, xfers[i].len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     virtual void cs_assert() = 0;
     virtual void cs_release() = 0;
     virtual uint8_t transfer (uint8_t data) = 0;
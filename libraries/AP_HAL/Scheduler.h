@@ -42,6 +42,25 @@ public:
         return false;
     }
 
+    /*
+      register a task to run every period_usec on the thread that
+      serves the bus owning bus_sem, ahead of that bus's tasks of
+      lower priority. A period of 0 runs the task once. HALs without
+      bus threads run periodic tasks as timer processes, timesliced
+      where they can, and one-shot tasks immediately. Returns true if
+      the HAL keeps to the period, so the task need not throttle itself
+     */
+    virtual bool     register_bus_process(AP_HAL::Semaphore *bus_sem, AP_HAL::MemberProc proc,
+                                          uint32_t period_usec, uint8_t priority)
+    {
+        if (period_usec == 0) {
+            proc();
+            return true;
+        }
+        uint32_t freq_div = period_usec / 1000;
+        return register_timer_process(proc, freq_div > 255 ? 255 : freq_div);
+    }
+
     // register a low priority IO task
     virtual void     register_io_process(AP_HAL::MemberProc) = 0;
 
@@ -95,6 +95,10 @@ public:
     virtual void perf_end(perf_counter_t h) {}
     virtual void perf_count(perf_counter_t h) {}
 
+    // true if perf counters are being recorded for offline analysis, so
+    // callers can skip counters that are only worth their cost then
+    virtual bool perf_trace_enabled(void) const { return false; }
+
     // create a new semaphore
     virtual Semaphore *new_semaphore(void) { return nullptr; }
     
@@ -19,6 +19,21 @@ public:
      * -1 if nothing available, uint8_t value otherwise. */
     virtual int16_t read() = 0;
 
+    /* read up to count bytes into buffer, returning the number of
+     * bytes read. Ports with a receive ring buffer should override
+     * this to copy whole spans at once */
+    virtual uint16_t read(uint8_t *buffer, uint16_t count) {
+        uint16_t n = 0;
+        while (n < count) {
+            int16_t c = read();
+            if (c < 0) {
+                break;
+            }
+            buffer[n++] = (uint8_t)c;
+        }
+        return n;
+    }
+
 };
 
 #endif // __AP_HAL_UTILITY_STREAM_H__
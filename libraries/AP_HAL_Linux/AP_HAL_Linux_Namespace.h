@@ -17,6 +17,7 @@ namespace Linux {
     class GPIO_Sysfs;
     class Storage;
     class Storage_FRAM;
+    class Storage_Log;
     class DigitalSource;
     class DigitalSource_Sysfs;
     class PWM_Sysfs;
@@ -52,6 +53,7 @@ namespace Linux {
     class OpticalFlow_Onboard;
     class Flow_PX4;
     class Perf_Lttng;
+    class Trace;
 }
 
 #endif // __AP_HAL_LINUX_NAMESPACE_H__
@@ -45,5 +45,6 @@
 #include "VideoIn.h"
 #include "OpticalFlow_Onboard.h"
 #include "Flow_PX4.h"
+#include "Trace.h"
 
 #endif // __AP_HAL_LINUX_PRIVATE_H__
@@ -91,10 +91,12 @@ static AnalogIn analogIn;
 #endif
 
 /*
-  select between FRAM and FS
+  select between FRAM, log-structured FS and FS
  */
 #if LINUX_STORAGE_USE_FRAM == 1
 static Storage_FRAM storageDriver;
+#elif HAL_LINUX_STORAGE_LOG
+static Storage_Log storageDriver;
 #else
 static Storage storageDriver;
 #endif
@@ -233,6 +235,9 @@ void _usage(void)
     printf("\t-custom terrain path:\n");
     printf("\t                   --terrain-directory /var/APM/terrain\n");
     printf("\t                   -t /var/APM/terrain\n");
+    printf("\t-timing trace:\n");
+    printf("\t                   --trace /var/APM/trace.bin\n");
+    printf("\t                   -T /var/APM/trace.bin\n");
 }
 
 void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
@@ -252,11 +257,12 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
 #endif
         {"log-directory",       true,  0, 'l'},
         {"terrain-directory",   true,  0, 't'},
+        {"trace",               true,  0, 'T'},
         {"help",                false,  0, 'h'},
         {0, false, 0, 0}
     };
 
-    GetOptLong gopt(argc, argv, "A:B:C:D:E:l:t:he:S",
+    GetOptLong gopt(argc, argv, "A:B:C:D:E:l:t:T:he:S",
                     options);
 
     /*
@@ -293,6 +299,9 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         case 't':
             utilInstance.set_custom_terrain_directory(gopt.optarg);
             break;
+        case 'T':
+            Linux::Trace::start(gopt.optarg);
+            break;
         case 'h':
             _usage();
             exit(0);
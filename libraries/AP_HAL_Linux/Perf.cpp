@@ -26,6 +26,7 @@
 #include <AP_Math/AP_Math.h>
 
 #include "AP_HAL_Linux.h"
+#include "Trace.h"
 #include "Util.h"
 
 using namespace Linux;
@@ -33,6 +34,7 @@ using namespace Linux;
 struct perf_counter_base_t {
     const char *name;
     enum Util::perf_counter_type type;
+    uint16_t trace_id;
 };
 
 struct perf_counter_count_t {
@@ -94,6 +96,7 @@ Util::perf_counter_t Util::perf_alloc(perf_counter_type type, const char *name)
 
     base->name = name;
     base->type = type;
+    base->trace_id = Trace::name_id(name);
     return (perf_counter_t)base;
 }
 
@@ -116,6 +119,8 @@ void Util::perf_begin(perf_counter_t perf)
         return;
     }
 
+    Trace::begin(perf_elapsed->base.trace_id);
+
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
     perf_elapsed->start = timespec_to_nsec(&ts);
@@ -145,6 +150,8 @@ void Util::perf_end(perf_counter_t perf)
     clock_gettime(CLOCK_MONOTONIC, &ts);
     const uint64_t elapsed = timespec_to_nsec(&ts) - perf_elapsed->start;
 
+    Trace::end(perf_elapsed->base.trace_id);
+
     perf_elapsed->count++;
     perf_elapsed->total += elapsed;
 
@@ -184,6 +191,13 @@ void Util::perf_count(perf_counter_t perf)
     }
 
     perf_counter->count++;
+
+    Trace::count(perf_counter->base.trace_id);
+}
+
+bool Util::perf_trace_enabled(void) const
+{
+    return Trace::enabled();
 }
 
 #endif
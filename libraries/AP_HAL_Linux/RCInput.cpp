@@ -18,12 +18,19 @@
 #include "sbus.h"
 #include <AP_HAL/utility/dsm.h>
 
+// set to 1 to log every RC input pulse to /tmp/rcin.log, useful for debugging
+#ifndef RCIN_LOG
+#define RCIN_LOG 0
+#endif
+
 extern const AP_HAL::HAL& hal;
 
 using namespace Linux;
 
 RCInput::RCInput() :
-    new_rc_input(false)
+    new_rc_input(false),
+    _pulse_end_us(0),
+    _last_frame_us(0)
 {
     ppm_state._channel_counter = -1;
 }
@@ -114,6 +121,7 @@ void RCInput::_process_ppmsum_pulse(uint16_t width_usec)
                 _pwm_values[i] = ppm_state._pulse_capt[i];
             }
             _num_channels = ppm_state._channel_counter;
+            _last_frame_us = _pulse_end_us;
             new_rc_input = true;
         }
         ppm_state._channel_counter = 0;
@@ -145,6 +153,7 @@ void RCInput::_process_ppmsum_pulse(uint16_t width_usec)
             _pwm_values[i] = ppm_state._pulse_capt[i];
         }
         _num_channels = ppm_state._channel_counter;
+        _last_frame_us = _pulse_end_us;
         new_rc_input = true;
         ppm_state._channel_counter = -1;
     }
@@ -222,6 +231,7 @@ void RCInput::_process_sbus_pulse(uint16_t width_s0, uint16_t width_s1)
                 _pwm_values[i] = values[i];
             }
             _num_channels = num_values;
+            _last_frame_us = _pulse_end_us;
             new_rc_input = true;
         }
         goto reset;
@@ -285,12 +295,13 @@ void RCInput::_process_dsm_pulse(uint16_t width_s0, uint16_t width_s1)
             }
             uint16_t values[8];
             uint16_t num_values=0;
-            if (dsm_decode(AP_HAL::micros64(), bytes, values, &num_values, 8) && 
+            if (dsm_decode(_pulse_end_us, bytes, values, &num_values, 8) && 
                 num_values >= 5) {
                 for (i=0; i<num_values; i++) {
                     _pwm_values[i] = values[i];
                 }
                 _num_channels = num_values;                
+                _last_frame_us = _pulse_end_us;
                 new_rc_input = true;
             }
         }
@@ -313,12 +324,11 @@ reset:
 }
 
 /*
-  process a RC input pulse of the given width
+  log a RC input pulse when RCIN_LOG is enabled
  */
-void RCInput::_process_rc_pulse(uint16_t width_s0, uint16_t width_s1)
+void RCInput::_log_rc_pulse(uint16_t width_s0, uint16_t width_s1)
 {
-#if 0
-    // useful for debugging
+#if RCIN_LOG
     static FILE *rclog;
     if (rclog == NULL) {
         rclog = fopen("/tmp/rcin.log", "w");
@@ -327,6 +337,16 @@ void RCInput::_process_rc_pulse(uint16_t width_s0, uint16_t width_s1)
         fprintf(rclog, "%u %u\n", (unsigned)width_s0, (unsigned)width_s1);
     }
 #endif
+}
+
+/*
+  process a RC input pulse of the given width
+ */
+void RCInput::_process_rc_pulse(uint16_t width_s0, uint16_t width_s1)
+{
+    _log_rc_pulse(width_s0, width_s1);
+    _pulse_end_us = AP_HAL::micros64();
+
     // treat as PPM-sum
     _process_ppmsum_pulse(width_s0 + width_s1);
 
@@ -337,6 +357,47 @@ void RCInput::_process_rc_pulse(uint16_t width_s0, uint16_t width_s1)
     _process_dsm_pulse(width_s0, width_s1);
 }
 
+/*
+  process a span of RC input pulses. Each decoder makes its own pass
+  over the span, rather than the three being interleaved per pulse.
+
+  The capture buffers only hold pulse widths, so frame stamps are
+  estimated by working back from end_us, the time the span was read,
+  through the widths. Frames within a span are spaced correctly, but
+  all of them are late by the time between the last edge and the read,
+  which is up to one timer tick plus the part of a pulse in progress
+ */
+void RCInput::_process_rc_pulses(const uint16_t *widths_s0, const uint16_t *widths_s1,
+                                 uint16_t count, uint64_t end_us)
+{
+    uint64_t start_us = end_us;
+    for (uint16_t i=0; i<count; i++) {
+        _log_rc_pulse(widths_s0[i], widths_s1[i]);
+        start_us -= widths_s0[i] + widths_s1[i];
+    }
+
+    // treat as PPM-sum
+    _pulse_end_us = start_us;
+    for (uint16_t i=0; i<count; i++) {
+        _pulse_end_us += widths_s0[i] + widths_s1[i];
+        _process_ppmsum_pulse(widths_s0[i] + widths_s1[i]);
+    }
+
+    // treat as SBUS
+    _pulse_end_us = start_us;
+    for (uint16_t i=0; i<count; i++) {
+        _pulse_end_us += widths_s0[i] + widths_s1[i];
+        _process_sbus_pulse(widths_s0[i], widths_s1[i]);
+    }
+
+    // treat as DSM
+    _pulse_end_us = start_us;
+    for (uint16_t i=0; i<count; i++) {
+        _pulse_end_us += widths_s0[i] + widths_s1[i];
+        _process_dsm_pulse(widths_s0[i], widths_s1[i]);
+    }
+}
+
 /*
  * Update channel values directly
  */
@@ -349,6 +410,7 @@ void RCInput::_update_periods(uint16_t *periods, uint8_t len)
         _pwm_values[i] = periods[i];
     }
     _num_channels = len;
+    _last_frame_us = AP_HAL::micros64();
     new_rc_input = true;
 }
 
@@ -386,7 +448,8 @@ void RCInput::add_dsm_input(const uint8_t *bytes, size_t nbytes)
             dsm.partial_frame_count = 0;
             uint16_t values[16] {};
             uint16_t num_values=0;
-            if (dsm_decode(AP_HAL::micros64(), dsm.frame, values, &num_values, 16) &&
+            _last_frame_us = AP_HAL::micros64();
+            if (dsm_decode(_last_frame_us, dsm.frame, values, &num_values, 16) &&
                 num_values >= 5) {
                 for (uint8_t i=0; i<num_values; i++) {
                     if (values[i] != 0) {
@@ -30,10 +30,19 @@ public:
 
     // add some DSM input bytes, for RCInput over a serial port
     void add_dsm_input(const uint8_t *bytes, size_t nbytes);
-    
-    
+
+    // time the last complete frame ended, in microseconds. For
+    // pulses from a capture buffer this is estimated, see
+    // _process_rc_pulses()
+    uint64_t last_frame_us(void) { return _last_frame_us; }
+
  protected:
     void _process_rc_pulse(uint16_t width_s0, uint16_t width_s1);
+
+    // process a span of pulses taken from a capture buffer in one
+    // go. end_us is taken as the time the last pulse of the span ended
+    void _process_rc_pulses(const uint16_t *widths_s0, const uint16_t *widths_s1,
+                            uint16_t count, uint64_t end_us);
     void _update_periods(uint16_t *periods, uint8_t len);
 
  private:
@@ -42,6 +51,11 @@ public:
     uint16_t _pwm_values[LINUX_RC_INPUT_NUM_CHANNELS];    
     uint8_t  _num_channels;
 
+    // end time of the pulse being decoded, and of the last frame
+    uint64_t _pulse_end_us;
+    uint64_t _last_frame_us;
+
+    void _log_rc_pulse(uint16_t width_s0, uint16_t width_s1);
     void _process_ppmsum_pulse(uint16_t width);
     void _process_sbus_pulse(uint16_t width_s0, uint16_t width_s1);
     void _process_dsm_pulse(uint16_t width_s0, uint16_t width_s1);
@@ -50,16 +50,32 @@ void RCInput_AioPRU::init()
  */
 void RCInput_AioPRU::_timer_tick()
 {
-    while (ring_buffer->ring_head != ring_buffer->ring_tail) {
-        if (ring_buffer->ring_tail >= NUM_RING_ENTRIES) {
-            // invalid ring_tail from PRU - ignore RC input
-            return;
-        }
-        _process_rc_pulse((ring_buffer->buffer[ring_buffer->ring_head].s1_t) / TICK_PER_US,
-                          (ring_buffer->buffer[ring_buffer->ring_head].s0_t) / TICK_PER_US);
-        // move to the next ring buffer entry
-        ring_buffer->ring_head = (ring_buffer->ring_head + 1) % NUM_RING_ENTRIES;
+    const uint16_t tail = ring_buffer->ring_tail;
+    if (tail >= NUM_RING_ENTRIES) {
+        // invalid ring_tail from PRU - ignore RC input
+        return;
     }
+    uint16_t head = ring_buffer->ring_head;
+    if (head == tail) {
+        return;
+    }
+    const uint64_t now = AP_HAL::micros64();
+
+    // PRU RAM is uncached, so copy everything the PRU has written out
+    // in one pass, release it with a single head update and decode
+    // the copy
+    uint16_t widths_s0[NUM_RING_ENTRIES];
+    uint16_t widths_s1[NUM_RING_ENTRIES];
+    uint16_t count = 0;
+    while (head != tail) {
+        widths_s0[count] = ring_buffer->buffer[head].s1_t / TICK_PER_US;
+        widths_s1[count] = ring_buffer->buffer[head].s0_t / TICK_PER_US;
+        count++;
+        head = (head + 1) % NUM_RING_ENTRIES;
+    }
+    ring_buffer->ring_head = head;
+
+    _process_rc_pulses(widths_s0, widths_s1, count, now);
 }
 
 #endif // CONFIG_HAL_BOARD_SUBTYPE
@@ -46,22 +46,45 @@ void RCInput_PRU::init()
  */
 void RCInput_PRU::_timer_tick()
 {
-    while (ring_buffer->ring_head != ring_buffer->ring_tail) {
-        if (ring_buffer->ring_tail >= NUM_RING_ENTRIES) {
-            // invalid ring_tail from PRU - ignore RC input
-            return;
-        }
-        if (ring_buffer->buffer[ring_buffer->ring_head].pin_value == 1) {
+    const uint16_t tail = ring_buffer->ring_tail;
+    if (tail >= NUM_RING_ENTRIES) {
+        // invalid ring_tail from PRU - ignore RC input
+        return;
+    }
+    uint16_t head = ring_buffer->ring_head;
+    if (head == tail) {
+        return;
+    }
+    const uint64_t now = AP_HAL::micros64();
+
+    // the shared RAM is uncached, so copy everything the PRU has
+    // written out in one pass, pairing the low and high state times
+    // into pulses, then release it with a single head update
+    uint16_t widths_s0[NUM_RING_ENTRIES];
+    uint16_t widths_s1[NUM_RING_ENTRIES];
+    uint16_t count = 0;
+    uint16_t trailing_us = 0;
+    while (head != tail) {
+        const uint16_t delta_t = ring_buffer->buffer[head].delta_t;
+        if (ring_buffer->buffer[head].pin_value == 1) {
             // remember the time we spent in the low state
-            _s0_time = ring_buffer->buffer[ring_buffer->ring_head].delta_t;
+            _s0_time = delta_t;
+            trailing_us = delta_t;
         } else {
             // the pulse value is the sum of the time spent in the low
             // and high states
-            _process_rc_pulse(_s0_time, ring_buffer->buffer[ring_buffer->ring_head].delta_t);
+            widths_s0[count] = _s0_time;
+            widths_s1[count] = delta_t;
+            count++;
+            trailing_us = 0;
         }
-        // move to the next ring buffer entry
-        ring_buffer->ring_head = (ring_buffer->ring_head + 1) % NUM_RING_ENTRIES;        
+        head = (head + 1) % NUM_RING_ENTRIES;
     }
+    ring_buffer->ring_head = head;
+
+    // a low state recorded after the last complete pulse puts the end
+    // of that pulse at least that long before now
+    _process_rc_pulses(widths_s0, widths_s1, count, now - trailing_us);
 }
 
 #endif // CONFIG_HAL_BOARD_SUBTYPE
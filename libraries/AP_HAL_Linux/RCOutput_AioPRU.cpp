@@ -101,7 +101,33 @@ void RCOutput_AioPRU::disable_ch(uint8_t ch)
 void RCOutput_AioPRU::write(uint8_t ch, uint16_t period_us)
 {
    if(ch < PWM_CHAN_COUNT) {
-      pwm->channel[ch].time_high = TICK_PER_US * period_us;
+      _pending[ch] = TICK_PER_US * period_us;
+      _pending_mask |= 1U << ch;
+      if(!_corking) {
+         push();
+      }
+   }
+}
+
+void RCOutput_AioPRU::cork()
+{
+   _corking = true;
+}
+
+/*
+  copy the staged frame into PRU RAM in one pass, so the PRU picks up
+  all the channels of a frame in the same PWM period
+ */
+void RCOutput_AioPRU::push()
+{
+   uint8_t i;
+
+   _corking = false;
+   for(i = 0; _pending_mask != 0 && i < PWM_CHAN_COUNT; i++) {
+      if(_pending_mask & (1U << i)) {
+         pwm->channel[i].time_high = _pending[i];
+         _pending_mask &= ~(1U << i);
+      }
    }
 }
 
@@ -26,6 +26,8 @@ class Linux::RCOutput_AioPRU : public AP_HAL::RCOutput {
     void     enable_ch(uint8_t ch);
     void     disable_ch(uint8_t ch);
     void     write(uint8_t ch, uint16_t period_us);
+    void     cork() override;
+    void     push() override;
     uint16_t read(uint8_t ch);
     void     read(uint16_t* period_us, uint8_t len);
 
@@ -42,6 +44,11 @@ private:
     };
 
     volatile struct pwm *pwm;
+
+    // high times staged between cork() and push(), in ticks
+    uint32_t _pending[PWM_CHAN_COUNT];
+    uint32_t _pending_mask = 0;
+    bool _corking = false;
 };
 
 #endif // __AP_HAL_LINUX_RCOUTPUT_AIOPRU_H__
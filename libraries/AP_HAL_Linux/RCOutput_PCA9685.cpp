@@ -63,11 +63,12 @@ RCOutput_PCA9685::RCOutput_PCA9685(uint8_t addr,
     _i2c_sem(NULL),
     _enable_pin(NULL),
     _frequency(50),
-    _pulses_buffer(new uint16_t[PWM_CHAN_COUNT - channel_offset]),
+    _pulses_buffer(new uint16_t[PWM_CHAN_COUNT - channel_offset]()),
     _addr(addr),
     _external_clock(external_clock),
     _channel_offset(channel_offset),
-    _oe_pin_number(oe_pin_number)
+    _oe_pin_number(oe_pin_number),
+    _pending_write_mask(0)
 {
     if (_external_clock)
         _osc_clock = PCA9685_EXTERNAL_CLOCK;
@@ -71,7 +71,34 @@ void RCOutput_PRU::disable_ch(uint8_t ch)
 
 void RCOutput_PRU::write(uint8_t ch, uint16_t period_us)
 {
-    sharedMem_cmd->periodhi[chan_pru_map[ch]][1] = TICK_PER_US*period_us;
+    if (ch >= PWM_CHAN_COUNT) {
+        return;
+    }
+    _pending[ch] = TICK_PER_US*period_us;
+    _pending_mask |= 1U<<ch;
+    if (!_corking) {
+        push();
+    }
+}
+
+void RCOutput_PRU::cork()
+{
+    _corking = true;
+}
+
+/*
+  copy the staged frame into PRU shared memory in one pass, so the PRU
+  picks up all the channels of a frame in the same PWM period
+ */
+void RCOutput_PRU::push()
+{
+    _corking = false;
+    for (uint8_t i=0; _pending_mask != 0 && i<PWM_CHAN_COUNT; i++) {
+        if (_pending_mask & (1U<<i)) {
+            sharedMem_cmd->periodhi[chan_pru_map[i]][1] = _pending[i];
+            _pending_mask &= ~(1U<<i);
+        }
+    }
 }
 
 uint16_t RCOutput_PRU::read(uint8_t ch)
@@ -31,6 +31,9 @@ RCOutput_Sysfs::RCOutput_Sysfs(uint8_t chip, uint8_t channel_count)
     : _chip(chip)
     , _channel_count(channel_count)
     , _pwm_channels(new PWM_Sysfs *[_channel_count])
+    , _pending(new uint16_t[_channel_count]())
+    , _pending_mask(0)
+    , _corking(false)
 {
 }
 
@@ -41,6 +44,7 @@ RCOutput_Sysfs::~RCOutput_Sysfs()
     }
 
     delete _pwm_channels;
+    delete [] _pending;
 }
 
 void RCOutput_Sysfs::init()
@@ -101,7 +105,39 @@ void RCOutput_Sysfs::write(uint8_t ch, uint16_t period_us)
         return;
     }
 
-    _pwm_channels[ch]->set_duty_cycle(usec_to_nsec(period_us));
+    _pending[ch] = period_us;
+    _pending_mask |= (1U << ch);
+
+    if (!_corking) {
+        push();
+    }
+}
+
+void RCOutput_Sysfs::cork()
+{
+    _corking = true;
+}
+
+/*
+  each channel is its own sysfs file, so a frame can't go out in a
+  single write. Writing the staged channels back to back keeps them
+  close together, and channels whose value didn't change are skipped
+  rather than costing a syscall each
+ */
+void RCOutput_Sysfs::push()
+{
+    _corking = false;
+
+    for (uint8_t i = 0; _pending_mask != 0 && i < _channel_count; i++) {
+        if (!(_pending_mask & (1U << i))) {
+            continue;
+        }
+        _pending_mask &= ~(1U << i);
+        const uint32_t duty = usec_to_nsec(_pending[i]);
+        if (duty != _pwm_channels[i]->get_duty_cycle()) {
+            _pwm_channels[i]->set_duty_cycle(duty);
+        }
+    }
 }
 
 uint16_t RCOutput_Sysfs::read(uint8_t ch)
@@ -19,6 +19,8 @@ public:
     void enable_ch(uint8_t ch);
     void disable_ch(uint8_t ch);
     void write(uint8_t ch, uint16_t period_us);
+    void cork() override;
+    void push() override;
     uint16_t read(uint8_t ch);
     void read(uint16_t *period_us, uint8_t len);
 
@@ -26,4 +28,9 @@ private:
     const uint8_t _chip;
     const uint8_t _channel_count;
     PWM_Sysfs **_pwm_channels;
+
+    // writes staged between cork() and push()
+    uint16_t *_pending;
+    uint32_t _pending_mask;
+    bool _corking;
 };
@@ -93,7 +93,9 @@ SPIDeviceDriver::SPIDeviceDriver(const char *name, uint16_t bus, uint16_t subdev
     _highspeed(highspeed),
     _speed(highspeed),
     _cs_pin(cs_pin),
-    _cs(NULL)
+    _cs(NULL),
+    _mode_owner(this),
+    _current_mode(-1)
 {
 }
 
@@ -122,6 +124,30 @@ bool SPIDeviceDriver::transaction(const uint8_t *tx, uint8_t *rx, uint16_t len)
     return SPIDeviceManager::transaction(*this, tx, rx, len);
 }
 
+bool SPIDeviceDriver::transactions(const struct Transfer *xfers, uint8_t count)
+{
+    struct SPIDeviceManager::Transfer batch[LINUX_SPI_MAX_TRANSFERS];
+
+    while (count > 0) {
+        uint8_t n = count;
+        if (n > LINUX_SPI_MAX_TRANSFERS) {
+            n = LINUX_SPI_MAX_TRANSFERS;
+        }
+        for (uint8_t i=0; i<n; i++) {
+            batch[i].driver = this;
+            batch[i].tx = xfers[i].tx;
+            batch[i].rx = xfers[i].rx;
+            batch[i].len = xfers[i].len;
+        }
+        if (!SPIDeviceManager::transactions(batch, n)) {
+            return false;
+        }
+        xfers += n;
+        count -= n;
+    }
+    return true;
+}
+
 void SPIDeviceDriver::set_bus_speed(enum bus_speed speed)
 {
     if (speed == SPI_SPEED_LOW) {
@@ -172,6 +198,15 @@ void SPIDeviceManager::init()
         fflush(stdout);
 #endif
         _device[i].init();
+
+        // entries on the same spidev node share its mode
+        for (uint8_t j=0; j<i; j++) {
+            if (_device[j]._bus == _device[i]._bus &&
+                _device[j]._subdev == _device[i]._subdev) {
+                _device[i]._mode_owner = &_device[j];
+                break;
+            }
+        }
     }
 }
 
@@ -237,34 +272,61 @@ void SPIDeviceManager::cs_release(enum AP_HAL::SPIDeviceType type)
     }
 }
 
-bool SPIDeviceManager::transaction(SPIDeviceDriver &driver, const uint8_t *tx, uint8_t *rx, uint16_t len)
+/*
+  write the mode of the spidev node if the last transaction on it was
+  in a different mode. The speed goes with each transfer, so it never
+  needs an ioctl of its own
+ */
+bool SPIDeviceManager::_set_mode(SPIDeviceDriver &driver)
+{
+    SPIDeviceDriver *owner = driver._mode_owner;
+    if (owner->_current_mode == driver._mode) {
+        return true;
+    }
+    if (ioctl(driver._fd, SPI_IOC_WR_MODE, &driver._mode) == -1) {
+        hal.console->printf("SPI: error on setting mode\n");
+        owner->_current_mode = -1;
+        return false;
+    }
+    owner->_current_mode = driver._mode;
+    return true;
+}
+
+/*
+  submit transfers for a single spidev node as one message, releasing
+  the kernel chip select between them
+ */
+bool SPIDeviceManager::_message(const struct Transfer *xfers, uint8_t count)
 {
-    int r;
+    SPIDeviceDriver &driver = *xfers[0].driver;
+
     // we set the mode before we assert the CS line so that the bus is
     // in the correct idle state before the chip is selected
-    r = ioctl(driver._fd, SPI_IOC_WR_MODE, &driver._mode);
-    if (r == -1) {
-        hal.console->printf("SPI: error on setting mode\n");
+    if (!_set_mode(driver)) {
         return false;
     }
 
-    cs_assert(driver._type);
-    struct spi_ioc_transfer spi[1];
-    memset(spi, 0, sizeof(spi));
-    spi[0].tx_buf        = (uint64_t)tx;
-    spi[0].rx_buf        = (uint64_t)rx;
-    spi[0].len           = len;
-    spi[0].delay_usecs   = 0;
-    spi[0].speed_hz      = driver._speed;
-    spi[0].bits_per_word = driver._bitsPerWord;
-    spi[0].cs_change     = 0;
-
-    if (rx != NULL) {
-        // keep valgrind happy
-        memset(rx, 0, len);
+    struct spi_ioc_transfer spi[LINUX_SPI_MAX_TRANSFERS];
+    memset(spi, 0, count * sizeof(spi[0]));
+    for (uint8_t i=0; i<count; i++) {
+        spi[i].tx_buf        = (uint64_t)xfers[i].tx;
+        spi[i].rx_buf        = (uint64_t)xfers[i].rx;
+        spi[i].len           = xfers[i].len;
+        spi[i].delay_usecs   = 0;
+        spi[i].speed_hz      = xfers[i].driver->_speed;
+        spi[i].bits_per_word = xfers[i].driver->_bitsPerWord;
+        // on all but the last transfer this deselects the chip
+        // before the next one
+        spi[i].cs_change     = (i + 1 < count);
+
+        if (xfers[i].rx != NULL) {
+            // keep valgrind happy
+            memset(xfers[i].rx, 0, xfers[i].len);
+        }
     }
 
-    r = ioctl(driver._fd, SPI_IOC_MESSAGE(1), &spi);
+    cs_assert(driver._type);
+    int r = ioctl(driver._fd, SPI_IOC_MESSAGE(count), spi);
     cs_release(driver._type);
 
     if (r == -1) {
@@ -275,6 +337,38 @@ bool SPIDeviceManager::transaction(SPIDeviceDriver &driver, const uint8_t *tx, u
     return true;
 }
 
+bool SPIDeviceManager::transaction(SPIDeviceDriver &driver, const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    struct Transfer xfer = { &driver, tx, rx, len };
+    return _message(&xfer, 1);
+}
+
+bool SPIDeviceManager::transactions(const struct Transfer *xfers, uint8_t count)
+{
+    while (count > 0) {
+        SPIDeviceDriver &driver = *xfers[0].driver;
+        uint8_t n = 1;
+
+        // with the chip select in userspace each transfer needs its
+        // own CS toggle, so only kernel CS transfers are combined
+        if (driver._cs_pin == SPI_CS_KERNEL) {
+            while (n < count && n < LINUX_SPI_MAX_TRANSFERS &&
+                   xfers[n].driver->_mode_owner == driver._mode_owner &&
+                   xfers[n].driver->_mode == driver._mode &&
+                   xfers[n].driver->_cs_pin == SPI_CS_KERNEL) {
+                n++;
+            }
+        }
+
+        if (!_message(xfers, n)) {
+            return false;
+        }
+        xfers += n;
+        count -= n;
+    }
+    return true;
+}
+
 /*
   return a SPIDeviceDriver for a particular device
  */
@@ -7,6 +7,9 @@
 
 #define LINUX_SPI_MAX_BUSES 3
 
+// most transfers submitted to the kernel in one SPI_IOC_MESSAGE
+#define LINUX_SPI_MAX_TRANSFERS 16
+
 // Fake CS pin to indicate in-kernel handling
 #define SPI_CS_KERNEL -1
 
@@ -19,6 +22,7 @@ public:
     void init();
     AP_HAL::Semaphore *get_semaphore();
     bool transaction(const uint8_t *tx, uint8_t *rx, uint16_t len);
+    bool transactions(const struct Transfer *xfers, uint8_t count);
 
     void cs_assert();
     void cs_release();
@@ -39,6 +43,11 @@ private:
     uint32_t _speed;
     enum AP_HAL::SPIDeviceType _type;
     int _fd;	// Per-device FD.
+
+    // the first table entry for the same spidev node, which holds the
+    // mode last written to it. Entries sharing a node share the mode
+    SPIDeviceDriver *_mode_owner;
+    int16_t _current_mode;
 };
 
 class Linux::SPIDeviceManager : public AP_HAL::SPIDeviceManager {
@@ -52,7 +61,25 @@ public:
     static void cs_release(enum AP_HAL::SPIDeviceType type);
     static bool transaction(SPIDeviceDriver &driver, const uint8_t *tx, uint8_t *rx, uint16_t len);
 
+    /*
+      a transfer for one of the devices in the table. A batch may mix
+      devices: consecutive transfers for the same spidev node with
+      kernel chip select go to the kernel in a single SPI_IOC_MESSAGE,
+      others are done one at a time. The caller holds the semaphore of
+      every bus involved.
+     */
+    struct Transfer {
+        SPIDeviceDriver *driver;
+        const uint8_t *tx;
+        uint8_t *rx;
+        uint16_t len;
+    };
+    static bool transactions(const struct Transfer *xfers, uint8_t count);
+
 private:
+    static bool _set_mode(SPIDeviceDriver &driver);
+    static bool _message(const struct Transfer *xfers, uint8_t count);
+
     static SPIDeviceDriver _device[];
     static Semaphore _semaphore[LINUX_SPI_MAX_BUSES];
 };
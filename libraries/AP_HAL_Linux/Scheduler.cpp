@@ -8,6 +8,7 @@
 #include "UARTDriver.h"
 #include "Util.h"
 #include "SPIUARTDriver.h"
+#include "Trace.h"
 #include "RPIOUARTDriver.h"
 #include <algorithm>
 #include <poll.h>
@@ -31,6 +32,7 @@ extern const AP_HAL::HAL& hal;
 
 #define APM_LINUX_TIMER_PRIORITY        15
 #define APM_LINUX_UART_PRIORITY         14
+#define APM_LINUX_BUS_PRIORITY          14
 #define APM_LINUX_RCIN_PRIORITY         13
 #define APM_LINUX_MAIN_PRIORITY         12
 #define APM_LINUX_TONEALARM_PRIORITY    11
@@ -51,6 +53,12 @@ extern const AP_HAL::HAL& hal;
 #define APM_LINUX_IO_PERIOD             20000
 #endif // CONFIG_HAL_BOARD_SUBTYPE
 
+// how long a bus thread with nothing to do sleeps before looking again
+#define APM_LINUX_BUS_IDLE_PERIOD       10000
+
+// set on the bus threads, which count as timer processes
+static __thread bool in_bus_thread;
+
 
 
 
@@ -59,7 +67,8 @@ Scheduler::Scheduler()
 
 void Scheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
                                              const char *name,
-                                             pthread_startroutine_t start_routine)
+                                             pthread_startroutine_t start_routine,
+                                             void *arg)
 {
     struct sched_param param = { .sched_priority = rtprio };
     pthread_attr_t attr;
@@ -76,7 +85,7 @@ void Scheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
         pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
         pthread_attr_setschedparam(&attr, &param);
     }
-    r = pthread_create(ctx, &attr, start_routine, this);
+    r = pthread_create(ctx, &attr, start_routine, arg ? arg : this);
     if (r != 0) {
         hal.console->printf("Error creating thread '%s': %s\n",
                             name, strerror(r));
@@ -259,6 +268,72 @@ bool Scheduler::_register_timesliced_proc(AP_HAL::MemberProc proc,
     return true;
 }
 
+bool Scheduler::register_bus_process(AP_HAL::Semaphore *bus_sem, AP_HAL::MemberProc proc,
+                                     uint32_t period_usec, uint8_t priority)
+{
+    _bus_register_semaphore.take(0);
+
+    bus_thread *bt = NULL;
+    for (uint8_t i = 0; i < _num_bus_threads; i++) {
+        if (_bus_thread[i].bus_sem == bus_sem) {
+            bt = &_bus_thread[i];
+            break;
+        }
+    }
+
+    if (bt == NULL) {
+        if (_num_bus_threads == LINUX_SCHEDULER_MAX_BUS_THREADS) {
+            _bus_register_semaphore.give();
+            hal.console->printf("Out of bus threads\n");
+            register_timer_process(proc);
+            return false;
+        }
+        bt = &_bus_thread[_num_bus_threads];
+        bt->sched = this;
+        bt->bus_sem = bus_sem;
+        snprintf(bt->name, sizeof(bt->name), "sched-bus%u", (unsigned)_num_bus_threads);
+        _create_realtime_thread(&bt->ctx, APM_LINUX_BUS_PRIORITY, bt->name,
+                                &Linux::Scheduler::_bus_thread_main, bt);
+        _num_bus_threads++;
+    }
+
+    // reuse the slot of a finished one-shot, or take a new one
+    bus_proc *bp = NULL;
+    for (uint8_t i = 0; i < bt->num_procs; i++) {
+        bus_proc &p = bt->procs[i];
+        if (__atomic_load_n(&p.active, __ATOMIC_ACQUIRE)) {
+            if (p.period_usec != 0 && p.proc == proc) {
+                _bus_register_semaphore.give();
+                return true;
+            }
+        } else if (bp == NULL) {
+            bp = &p;
+        }
+    }
+    if (bp == NULL) {
+        if (bt->num_procs == LINUX_SCHEDULER_MAX_BUS_PROCS) {
+            _bus_register_semaphore.give();
+            hal.console->printf("Out of bus processes\n");
+            register_timer_process(proc);
+            return false;
+        }
+        bp = &bt->procs[bt->num_procs];
+    }
+
+    bp->proc = proc;
+    bp->period_usec = period_usec;
+    bp->priority = priority;
+    bp->next_run_usec = AP_HAL::micros64();
+    // the bus thread picks the task up once it is active
+    __atomic_store_n(&bp->active, true, __ATOMIC_RELEASE);
+    if (bp == &bt->procs[bt->num_procs]) {
+        __atomic_store_n(&bt->num_procs, bt->num_procs + 1, __ATOMIC_RELEASE);
+    }
+
+    _bus_register_semaphore.give();
+    return true;
+}
+
 void Scheduler::register_io_process(AP_HAL::MemberProc proc)
 {
     for (uint8_t i = 0; i < _num_io_procs; i++) {
@@ -285,10 +360,21 @@ void Scheduler::suspend_timer_procs()
     if (!_timer_semaphore.take(0)) {
         printf("Failed to take timer semaphore\n");
     }
+    // bus threads created while suspended start out running, so
+    // remember how many we hold
+    uint8_t n = __atomic_load_n(&_num_bus_threads, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < n; i++) {
+        _bus_thread[i].lock.take(0);
+    }
+    _bus_threads_suspended = n;
 }
 
 void Scheduler::resume_timer_procs()
 {
+    for (uint8_t i = 0; i < _bus_threads_suspended; i++) {
+        _bus_thread[i].lock.give();
+    }
+    _bus_threads_suspended = 0;
     _timer_semaphore.give();
 }
 
@@ -360,6 +446,7 @@ void *Scheduler::_timer_thread(void* arg)
       this aims to run at an average of 1kHz, so that it can be used
       to drive 1kHz processes without drift
      */
+    const uint16_t trace_id = Trace::name_id("timer_tick");
     uint64_t next_run_usec = AP_HAL::micros64() + 1000;
     while (true) {
         uint64_t dt = next_run_usec - AP_HAL::micros64();
@@ -370,6 +457,7 @@ void *Scheduler::_timer_thread(void* arg)
             sched->_microsleep(dt);
         }
         next_run_usec += 1000;
+        Trace::begin(trace_id);
         // run registered timers
         sched->_run_timers(true);
 
@@ -382,6 +470,82 @@ void *Scheduler::_timer_thread(void* arg)
         _run_uarts();
         RCInput::from(hal.rcin)->_timer_tick();
 #endif
+        Trace::end(trace_id);
+    }
+    return NULL;
+}
+
+/*
+  run the tasks of a bus which are due, highest priority first
+ */
+void Scheduler::_run_bus_procs(bus_thread &bt, uint64_t now)
+{
+    uint8_t due[LINUX_SCHEDULER_MAX_BUS_PROCS];
+    uint8_t num_due = 0;
+
+    const uint8_t num_procs = __atomic_load_n(&bt.num_procs, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < num_procs; i++) {
+        const bus_proc &p = bt.procs[i];
+        if (!__atomic_load_n(&p.active, __ATOMIC_ACQUIRE) || p.next_run_usec > now) {
+            continue;
+        }
+        // insertion sort by descending priority
+        uint8_t j = num_due++;
+        while (j > 0 && bt.procs[due[j-1]].priority < p.priority) {
+            due[j] = due[j-1];
+            j--;
+        }
+        due[j] = i;
+    }
+
+    for (uint8_t i = 0; i < num_due; i++) {
+        bus_proc &p = bt.procs[due[i]];
+        p.proc();
+        if (p.period_usec == 0) {
+            __atomic_store_n(&p.active, false, __ATOMIC_RELEASE);
+            continue;
+        }
+        p.next_run_usec += p.period_usec;
+        if (p.next_run_usec <= now) {
+            // we've lost sync - restart
+            p.next_run_usec = now + p.period_usec;
+        }
+    }
+}
+
+void *Scheduler::_bus_thread_main(void *arg)
+{
+    bus_thread *bt = (bus_thread *)arg;
+    Scheduler *sched = bt->sched;
+
+    while (sched->system_initializing()) {
+        poll(NULL, 0, 1);
+    }
+
+    in_bus_thread = true;
+    const uint16_t trace_id = Trace::name_id(bt->name);
+    while (true) {
+        bt->lock.take(0);
+        Trace::begin(trace_id);
+        uint64_t now = AP_HAL::micros64();
+        sched->_run_bus_procs(*bt, now);
+        Trace::end(trace_id);
+        bt->lock.give();
+
+        // sleep until the next task is due
+        uint64_t next_run_usec = now + APM_LINUX_BUS_IDLE_PERIOD;
+        const uint8_t num_procs = __atomic_load_n(&bt->num_procs, __ATOMIC_ACQUIRE);
+        for (uint8_t i = 0; i < num_procs; i++) {
+            const bus_proc &p = bt->procs[i];
+            if (__atomic_load_n(&p.active, __ATOMIC_ACQUIRE) &&
+                p.next_run_usec < next_run_usec) {
+                next_run_usec = p.next_run_usec;
+            }
+        }
+        now = AP_HAL::micros64();
+        if (next_run_usec > now) {
+            sched->_microsleep(next_run_usec - now);
+        }
     }
     return NULL;
 }
@@ -409,10 +573,13 @@ void *Scheduler::_rcin_thread(void *arg)
     while (sched->system_initializing()) {
         poll(NULL, 0, 1);
     }
+    const uint16_t trace_id = Trace::name_id("rcin_tick");
     while (true) {
         sched->_microsleep(APM_LINUX_RCIN_PERIOD);
 #if !HAL_LINUX_UARTS_ON_TIMER_THREAD
+        Trace::begin(trace_id);
         RCInput::from(hal.rcin)->_timer_tick();
+        Trace::end(trace_id);
 #endif
     }
     return NULL;
@@ -445,10 +612,13 @@ void *Scheduler::_uart_thread(void* arg)
     while (sched->system_initializing()) {
         poll(NULL, 0, 1);
     }
+    const uint16_t trace_id = Trace::name_id("uart_tick");
     while (true) {
         sched->_microsleep(APM_LINUX_UART_PERIOD);
 #if !HAL_LINUX_UARTS_ON_TIMER_THREAD
+        Trace::begin(trace_id);
         _run_uarts();
+        Trace::end(trace_id);
 #endif
     }
     return NULL;
@@ -461,11 +631,14 @@ void *Scheduler::_tonealarm_thread(void* arg)
     while (sched->system_initializing()) {
         poll(NULL, 0, 1);
     }
+    const uint16_t trace_id = Trace::name_id("tonealarm_tick");
     while (true) {
         sched->_microsleep(APM_LINUX_TONEALARM_PERIOD);
 
         // process tone command
+        Trace::begin(trace_id);
         Util::from(hal.util)->_toneAlarm_timer_tick();
+        Trace::end(trace_id);
     }
     return NULL;
 }
@@ -477,21 +650,29 @@ void *Scheduler::_io_thread(void* arg)
     while (sched->system_initializing()) {
         poll(NULL, 0, 1);
     }
+    const uint16_t trace_id = Trace::name_id("io_tick");
     while (true) {
         sched->_microsleep(APM_LINUX_IO_PERIOD);
 
+        Trace::begin(trace_id);
+
         // process any pending storage writes
         Storage::from(hal.storage)->_timer_tick();
 
         // run registered IO procepsses
         sched->_run_io();
+
+        Trace::end(trace_id);
+
+        // write out trace events from all threads
+        Trace::flush();
     }
     return NULL;
 }
 
 bool Scheduler::in_timerprocess()
 {
-    return _in_timer_proc;
+    return _in_timer_proc || in_bus_thread;
 }
 
 void Scheduler::begin_atomic()
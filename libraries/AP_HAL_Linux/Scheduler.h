@@ -12,6 +12,8 @@
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_TIMESLICED_PROCS 10
 #define LINUX_SCHEDULER_MAX_IO_PROCS 10
+#define LINUX_SCHEDULER_MAX_BUS_THREADS 4
+#define LINUX_SCHEDULER_MAX_BUS_PROCS 8
 
 class Linux::Scheduler : public AP_HAL::Scheduler {
 
@@ -32,6 +34,8 @@ public:
 
     void     register_timer_process(AP_HAL::MemberProc);
     bool     register_timer_process(AP_HAL::MemberProc, uint8_t);
+    bool     register_bus_process(AP_HAL::Semaphore *bus_sem, AP_HAL::MemberProc proc,
+                                  uint32_t period_usec, uint8_t priority);
     void     register_io_process(AP_HAL::MemberProc);
     void     suspend_timer_procs();
     void     resume_timer_procs();
@@ -84,6 +88,33 @@ private:
 
     volatile bool _timer_event_missed;
 
+    /*
+      a thread per bus, so a slow transfer on one bus (a blocking I2C
+      ioctl, say) can't delay the timer thread or another bus. The
+      thread runs the due tasks of its bus in priority order while
+      holding lock, which suspend_timer_procs() also takes
+     */
+    struct bus_proc {
+        AP_HAL::MemberProc proc;
+        uint64_t next_run_usec;
+        uint32_t period_usec;   // 0 for a one-shot task
+        uint8_t priority;       // higher runs first
+        bool active;
+    };
+    struct bus_thread {
+        Scheduler *sched;
+        AP_HAL::Semaphore *bus_sem;
+        pthread_t ctx;
+        Semaphore lock;
+        bus_proc procs[LINUX_SCHEDULER_MAX_BUS_PROCS];
+        uint8_t num_procs;
+        char name[16];
+    };
+    bus_thread _bus_thread[LINUX_SCHEDULER_MAX_BUS_THREADS];
+    uint8_t _num_bus_threads;
+    uint8_t _bus_threads_suspended;
+    Semaphore _bus_register_semaphore;
+
     pthread_t _timer_thread_ctx;
     pthread_t _io_thread_ctx;
     pthread_t _rcin_thread_ctx;
@@ -96,11 +127,14 @@ private:
     static void *_uart_thread(void* arg);
     static void _run_uarts(void);
     static void *_tonealarm_thread(void* arg);
+    static void *_bus_thread_main(void* arg);
+    void _run_bus_procs(bus_thread &bt, uint64_t now);
 
     void _run_timers(bool called_from_timer_thread);
     void _run_io(void);
     void _create_realtime_thread(pthread_t *ctx, int rtprio, const char *name,
-                                 pthread_startroutine_t start_routine);
+                                 pthread_startroutine_t start_routine,
+                                 void *arg = nullptr);
     bool _register_timesliced_proc(AP_HAL::MemberProc, uint8_t);
 
     uint64_t _stopped_clock_usec;
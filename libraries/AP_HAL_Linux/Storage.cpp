@@ -18,15 +18,6 @@ using namespace Linux;
   in-memory buffer. This keeps the latency down.
  */
 
-// name the storage file after the sketch so you can use the same board
-// card for ArduCopter and ArduPlane
-#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BEBOP
-#define STORAGE_DIR "/data/ftp/internal_000/APM"
-#else
-#define STORAGE_DIR "/var/APM"
-#endif
-#define STORAGE_FILE STORAGE_DIR "/" SKETCHNAME ".stg"
-
 extern const AP_HAL::HAL& hal;
 
 void Storage::_storage_create(void)
@@ -12,6 +12,15 @@
 #define LINUX_STORAGE_LINE_SIZE (1<<LINUX_STORAGE_LINE_SHIFT)
 #define LINUX_STORAGE_NUM_LINES (LINUX_STORAGE_SIZE/LINUX_STORAGE_LINE_SIZE)
 
+// name the storage file after the sketch so you can use the same board
+// card for ArduCopter and ArduPlane
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BEBOP
+#define STORAGE_DIR "/data/ftp/internal_000/APM"
+#else
+#define STORAGE_DIR "/var/APM"
+#endif
+#define STORAGE_FILE STORAGE_DIR "/" SKETCHNAME ".stg"
+
 class Linux::Storage : public AP_HAL::Storage
 {
 public:
@@ -34,7 +43,7 @@ public:
 
     virtual void _timer_tick(void);
 protected:
-    void _mark_dirty(uint16_t loc, uint16_t length);
+    virtual void _mark_dirty(uint16_t loc, uint16_t length);
     virtual void _storage_create(void);
     virtual void _storage_open(void);
     int _fd;
@@ -44,6 +53,7 @@ protected:
 };
 
 #include "Storage_FRAM.h"
+#include "Storage_Log.h"
 
 #endif // __AP_HAL_LINUX_STORAGE_H__
 
@@ -0,0 +1,367 @@
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Storage.h"
+
+using namespace Linux;
+
+#define STORAGE_LOG_FILE_MAGIC   0x4c535041  // "APSL"
+#define STORAGE_LOG_VERSION      1
+#define STORAGE_LOG_RECORD_MAGIC 0x5253      // "SR"
+#define STORAGE_LOG_RECORD_SIZE  (sizeof(struct record_header) + LINUX_STORAGE_LOG_CHUNK_SIZE)
+
+extern const AP_HAL::HAL& hal;
+
+Storage_Log::Storage_Log() :
+    _seq(0),
+    _log_size(0),
+    _snapshot_fail_ms(0),
+    _batch(NULL)
+{
+    memset((void *)_dirty, 0, sizeof(_dirty));
+}
+
+uint32_t Storage_Log::_crc32(uint32_t crc, const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (uint8_t i=0; i<8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+void Storage_Log::_set_dirty(uint16_t chunk)
+{
+    __sync_fetch_and_or(&_dirty[chunk/32], 1U << (chunk%32));
+}
+
+/*
+  mark the chunks covering a write as dirty
+ */
+void Storage_Log::_mark_dirty(uint16_t loc, uint16_t length)
+{
+    if (length == 0) {
+        return;
+    }
+    uint16_t last = (loc + length - 1) >> LINUX_STORAGE_LOG_CHUNK_SHIFT;
+    for (uint16_t chunk=loc>>LINUX_STORAGE_LOG_CHUNK_SHIFT; chunk <= last; chunk++) {
+        _set_dirty(chunk);
+    }
+}
+
+void Storage_Log::_build_record(uint8_t *p, uint16_t chunk, uint32_t &batch_crc)
+{
+    struct record_header hdr {};
+    hdr.magic = STORAGE_LOG_RECORD_MAGIC;
+    hdr.type = RECORD_CHUNK;
+    hdr.chunk = chunk;
+    hdr.seq = _seq;
+    memcpy(&p[sizeof(hdr)], &_buffer[chunk << LINUX_STORAGE_LOG_CHUNK_SHIFT], LINUX_STORAGE_LOG_CHUNK_SIZE);
+    hdr.crc = _crc32(_crc32(0, &hdr, sizeof(hdr)), &p[sizeof(hdr)], LINUX_STORAGE_LOG_CHUNK_SIZE);
+    memcpy(p, &hdr, sizeof(hdr));
+    batch_crc = _crc32(batch_crc, p, STORAGE_LOG_RECORD_SIZE);
+}
+
+void Storage_Log::_build_commit(uint8_t *p, uint16_t count, uint32_t &batch_crc)
+{
+    struct record_header hdr {};
+    hdr.magic = STORAGE_LOG_RECORD_MAGIC;
+    hdr.type = RECORD_COMMIT;
+    hdr.chunk = count;
+    hdr.seq = _seq;
+    hdr.crc = _crc32(batch_crc, &hdr, sizeof(hdr));
+    memcpy(p, &hdr, sizeof(hdr));
+}
+
+/*
+  apply the committed batches of a log to _buffer. valid_len is set to
+  the length of the log up to the end of the last good commit
+ */
+bool Storage_Log::_replay(const uint8_t *log, uint32_t len, uint32_t &valid_len)
+{
+    struct file_header fh;
+    valid_len = 0;
+    if (len < sizeof(fh)) {
+        return false;
+    }
+    memcpy(&fh, log, sizeof(fh));
+    if (fh.magic != STORAGE_LOG_FILE_MAGIC ||
+        fh.version != STORAGE_LOG_VERSION ||
+        fh.chunk_size != LINUX_STORAGE_LOG_CHUNK_SIZE ||
+        fh.storage_size > LINUX_STORAGE_SIZE) {
+        return false;
+    }
+
+    uint32_t ofs = sizeof(fh);
+    uint32_t batch_start = ofs;
+    uint32_t batch_crc = 0;
+    uint16_t count = 0;
+    valid_len = ofs;
+    while (ofs + sizeof(struct record_header) <= len) {
+        struct record_header hdr;
+        memcpy(&hdr, &log[ofs], sizeof(hdr));
+        if (hdr.magic != STORAGE_LOG_RECORD_MAGIC) {
+            break;
+        }
+        if (hdr.type == RECORD_CHUNK) {
+            if (ofs + STORAGE_LOG_RECORD_SIZE > len ||
+                hdr.chunk >= LINUX_STORAGE_LOG_NUM_CHUNKS) {
+                break;
+            }
+            const uint32_t crc = hdr.crc;
+            hdr.crc = 0;
+            if (_crc32(_crc32(0, &hdr, sizeof(hdr)), &log[ofs+sizeof(hdr)], LINUX_STORAGE_LOG_CHUNK_SIZE) != crc) {
+                break;
+            }
+            batch_crc = _crc32(batch_crc, &log[ofs], STORAGE_LOG_RECORD_SIZE);
+            count++;
+            ofs += STORAGE_LOG_RECORD_SIZE;
+            continue;
+        }
+        if (hdr.type != RECORD_COMMIT) {
+            break;
+        }
+        const uint32_t crc = hdr.crc;
+        hdr.crc = 0;
+        if (hdr.chunk != count || _crc32(batch_crc, &hdr, sizeof(hdr)) != crc) {
+            break;
+        }
+        // the batch is complete, apply it
+        for (uint32_t r=batch_start; r<ofs; r += STORAGE_LOG_RECORD_SIZE) {
+            struct record_header rec;
+            memcpy(&rec, &log[r], sizeof(rec));
+            memcpy(&_buffer[rec.chunk << LINUX_STORAGE_LOG_CHUNK_SHIFT], &log[r+sizeof(rec)], LINUX_STORAGE_LOG_CHUNK_SIZE);
+        }
+        _seq = hdr.seq + 1;
+        ofs += sizeof(hdr);
+        valid_len = ofs;
+        batch_start = ofs;
+        batch_crc = 0;
+        count = 0;
+    }
+    return true;
+}
+
+/*
+  write the whole of _buffer as a single batch to a new log and rename
+  it over the current one. A power loss at any point leaves either the
+  old or the new log in place
+ */
+bool Storage_Log::_write_snapshot(void)
+{
+    const char *tmpname = LINUX_STORAGE_LOG_FILE ".new";
+    int fd = open(tmpname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct file_header fh;
+    fh.magic = STORAGE_LOG_FILE_MAGIC;
+    fh.version = STORAGE_LOG_VERSION;
+    fh.chunk_size = LINUX_STORAGE_LOG_CHUNK_SIZE;
+    fh.storage_size = LINUX_STORAGE_SIZE;
+    bool ok = (write(fd, &fh, sizeof(fh)) == sizeof(fh));
+    uint32_t size = sizeof(fh);
+
+    // chunks which are all zero are left out
+    static const uint8_t zero[LINUX_STORAGE_LOG_CHUNK_SIZE] {};
+    uint32_t batch_crc = 0;
+    uint16_t count = 0;
+    uint8_t record[STORAGE_LOG_RECORD_SIZE];
+    for (uint16_t chunk=0; chunk<LINUX_STORAGE_LOG_NUM_CHUNKS && ok; chunk++) {
+        if (memcmp(&_buffer[chunk << LINUX_STORAGE_LOG_CHUNK_SHIFT], zero, sizeof(zero)) == 0) {
+            continue;
+        }
+        _build_record(record, chunk, batch_crc);
+        ok = (write(fd, record, sizeof(record)) == (ssize_t)sizeof(record));
+        size += sizeof(record);
+        count++;
+    }
+    if (ok) {
+        _build_commit(record, count, batch_crc);
+        ok = (write(fd, record, sizeof(struct record_header)) == sizeof(struct record_header));
+        size += sizeof(struct record_header);
+    }
+    if (ok) {
+        ok = (fsync(fd) == 0);
+    }
+    close(fd);
+    if (!ok || rename(tmpname, LINUX_STORAGE_LOG_FILE) != 0) {
+        unlink(tmpname);
+        return false;
+    }
+
+    // make the rename durable
+    int dfd = open(STORAGE_DIR, O_RDONLY);
+    if (dfd != -1) {
+        fsync(dfd);
+        close(dfd);
+    }
+
+    if (_fd != -1) {
+        close(_fd);
+        _fd = -1;
+    }
+    _seq++;
+    _log_size = size;
+    return true;
+}
+
+/*
+  create a new log, starting from the old flat storage file if there
+  is one
+ */
+void Storage_Log::_storage_create(void)
+{
+    mkdir(STORAGE_DIR, 0777);
+    memset(_buffer, 0, sizeof(_buffer));
+    int fd = open(STORAGE_FILE, O_RDONLY);
+    if (fd != -1) {
+        ssize_t ret = read(fd, _buffer, sizeof(_buffer));
+        close(fd);
+        if (ret > 0) {
+            ::printf("Storage: converting %s\n", STORAGE_FILE);
+        }
+    }
+    if (!_write_snapshot()) {
+        AP_HAL::panic("Failed to create " LINUX_STORAGE_LOG_FILE);
+    }
+}
+
+void Storage_Log::_storage_open(void)
+{
+    if (_initialised) {
+        return;
+    }
+
+    if (_batch == NULL) {
+        _batch = (uint8_t *)malloc(LINUX_STORAGE_LOG_MAX_BATCH * STORAGE_LOG_RECORD_SIZE +
+                                   sizeof(struct record_header));
+        if (_batch == NULL) {
+            AP_HAL::panic("Failed to allocate storage batch");
+        }
+    }
+
+    memset(_buffer, 0, sizeof(_buffer));
+    memset((void *)_dirty, 0, sizeof(_dirty));
+
+    bool replayed = false;
+    int fd = open(LINUX_STORAGE_LOG_FILE, O_RDWR);
+    if (fd != -1) {
+        struct stat st;
+        uint8_t *log = NULL;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            log = (uint8_t *)malloc(st.st_size);
+        }
+        uint32_t valid_len;
+        if (log != NULL &&
+            read(fd, log, st.st_size) == st.st_size &&
+            _replay(log, st.st_size, valid_len)) {
+            if (valid_len != (uint32_t)st.st_size) {
+                // drop a batch that was interrupted by a power loss
+                ::printf("Storage: discarding %u bytes of incomplete writes\n",
+                         (unsigned)(st.st_size - valid_len));
+                if (ftruncate(fd, valid_len) != 0) {
+                    AP_HAL::panic("Failed to truncate " LINUX_STORAGE_LOG_FILE);
+                }
+            }
+            _log_size = valid_len;
+            replayed = true;
+        }
+        free(log);
+        close(fd);
+    }
+    if (!replayed) {
+        _storage_create();
+    }
+    _initialised = true;
+}
+
+/*
+  append the dirty chunks to the log as one batch
+ */
+void Storage_Log::_timer_tick(void)
+{
+    if (!_initialised) {
+        return;
+    }
+
+    if (_log_size > LINUX_STORAGE_LOG_MAX_FILE &&
+        (_snapshot_fail_ms == 0 ||
+         AP_HAL::millis() - _snapshot_fail_ms > LINUX_STORAGE_LOG_SNAPSHOT_RETRY_MS)) {
+        if (_write_snapshot()) {
+            _snapshot_fail_ms = 0;
+            return;
+        }
+        // compaction failed, perhaps for lack of space. Keep appending
+        // changes to the current log and try again later
+        _snapshot_fail_ms = AP_HAL::millis();
+        if (_snapshot_fail_ms == 0) {
+            _snapshot_fail_ms = 1;
+        }
+    }
+
+    uint16_t chunks[LINUX_STORAGE_LOG_MAX_BATCH];
+    uint16_t count = 0;
+    for (uint16_t i=0; i<ARRAY_SIZE(_dirty) && count < LINUX_STORAGE_LOG_MAX_BATCH; i++) {
+        if (_dirty[i] == 0) {
+            continue;
+        }
+        for (uint8_t b=0; b<32 && count < LINUX_STORAGE_LOG_MAX_BATCH; b++) {
+            const uint32_t bit = 1U << b;
+            if (_dirty[i] & bit) {
+                // clear before copying the data, so a write that
+                // races with the copy marks the chunk dirty again
+                __sync_fetch_and_and(&_dirty[i], ~bit);
+                chunks[count++] = i*32 + b;
+            }
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+
+    if (_fd == -1) {
+        _fd = open(LINUX_STORAGE_LOG_FILE, O_WRONLY);
+    }
+
+    uint32_t batch_crc = 0;
+    uint32_t len = 0;
+    for (uint16_t i=0; i<count; i++) {
+        _build_record(&_batch[len], chunks[i], batch_crc);
+        len += STORAGE_LOG_RECORD_SIZE;
+    }
+    _build_commit(&_batch[len], count, batch_crc);
+    len += sizeof(struct record_header);
+
+    if (_fd == -1 ||
+        pwrite(_fd, _batch, len, _log_size) != (ssize_t)len ||
+        fdatasync(_fd) != 0) {
+        // try again on the next tick. A partly written batch has no
+        // valid commit, so it is overwritten by the retry
+        for (uint16_t i=0; i<count; i++) {
+            _set_dirty(chunks[i]);
+        }
+        if (_fd != -1) {
+            close(_fd);
+            _fd = -1;
+        }
+        return;
+    }
+    _log_size += len;
+    _seq++;
+}
+
+#endif // CONFIG_HAL_BOARD
@@ -0,0 +1,75 @@
+#ifndef __AP_HAL_LINUX_STORAGE_LOG_H__
+#define __AP_HAL_LINUX_STORAGE_LOG_H__
+
+#include <AP_HAL/AP_HAL.h>
+#include "AP_HAL_Linux_Namespace.h"
+
+#define LINUX_STORAGE_LOG_FILE STORAGE_DIR "/" SKETCHNAME ".stl"
+#define LINUX_STORAGE_LOG_CHUNK_SHIFT 6
+#define LINUX_STORAGE_LOG_CHUNK_SIZE (1<<LINUX_STORAGE_LOG_CHUNK_SHIFT)
+#define LINUX_STORAGE_LOG_NUM_CHUNKS (LINUX_STORAGE_SIZE/LINUX_STORAGE_LOG_CHUNK_SIZE)
+#define LINUX_STORAGE_LOG_MAX_BATCH 64      // chunks appended per _timer_tick()
+#define LINUX_STORAGE_LOG_MAX_FILE (8*LINUX_STORAGE_SIZE) // compact when the log is larger than this
+#define LINUX_STORAGE_LOG_SNAPSHOT_RETRY_MS 10000 // wait this long to compact again after a failure
+
+/*
+  log-structured storage on the SD card or flash filesystem.
+
+  Changes are appended to the file as records of whole chunks, in
+  batches which end with a commit record. On startup the log is
+  replayed into the in-memory buffer, applying only batches whose
+  commit record and checksums are intact, so a write interrupted by a
+  power loss leaves the storage as it was before that batch. When the
+  log grows past LINUX_STORAGE_LOG_MAX_FILE it is compacted by writing
+  a snapshot to a new file and renaming it over the log.
+ */
+class Linux::Storage_Log : public Linux::Storage
+{
+public:
+    Storage_Log();
+    void _timer_tick(void);
+
+protected:
+    void _mark_dirty(uint16_t loc, uint16_t length);
+    void _storage_create(void);
+    void _storage_open(void);
+
+private:
+    enum record_type {
+        RECORD_CHUNK  = 1,  // data for one chunk
+        RECORD_COMMIT = 2   // end of a batch
+    };
+
+    struct PACKED file_header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t chunk_size;
+        uint32_t storage_size;
+    };
+
+    struct PACKED record_header {
+        uint16_t magic;
+        uint8_t  type;
+        uint8_t  reserved;
+        uint16_t chunk;     // chunk number, or number of chunks for a commit
+        uint16_t reserved2;
+        uint32_t seq;       // batch sequence number
+        uint32_t crc;       // chunk: crc32 of header and data. commit: crc32 of the batch
+    };
+
+    static uint32_t _crc32(uint32_t crc, const void *data, uint32_t len);
+
+    bool _replay(const uint8_t *log, uint32_t len, uint32_t &valid_len);
+    void _build_record(uint8_t *p, uint16_t chunk, uint32_t &batch_crc);
+    void _build_commit(uint8_t *p, uint16_t count, uint32_t &batch_crc);
+    bool _write_snapshot(void);
+    void _set_dirty(uint16_t chunk);
+
+    uint32_t _seq;
+    uint32_t _log_size;
+    uint32_t _snapshot_fail_ms;     // time compaction last failed, 0 if it has not
+    uint8_t *_batch;
+    volatile uint32_t _dirty[(LINUX_STORAGE_LOG_NUM_CHUNKS+31)/32];
+};
+
+#endif // __AP_HAL_LINUX_STORAGE_LOG_H__
@@ -0,0 +1,242 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <AP_Math/AP_Math.h>
+
+#include "Trace.h"
+
+using namespace Linux;
+
+#define TRACE_MAGIC    "APTR"
+#define TRACE_VERSION  1
+#define TRACE_OUT_SIZE 65536
+
+// the ring of a thread which could not get one
+#define TRACE_NO_RING ((struct ring *)1)
+
+int Trace::_fd = -1;
+struct Trace::ring *Trace::_rings[LINUX_TRACE_MAX_THREADS];
+uint32_t Trace::_num_rings;
+char Trace::_names[LINUX_TRACE_MAX_NAMES][LINUX_TRACE_NAME_LEN];
+uint16_t Trace::_num_names;
+uint16_t Trace::_names_written;
+
+static pthread_mutex_t trace_names_mutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread void *trace_thread_ring;
+
+// output buffer, only used by flush() on the IO thread
+static uint8_t trace_out[TRACE_OUT_SIZE];
+static uint32_t trace_out_len;
+
+static uint64_t trace_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_nsec + (ts.tv_sec * NSEC_PER_SEC);
+}
+
+bool Trace::start(const char *path)
+{
+    int fd = ::open(path, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "Failed to open trace file %s: %m\n", path);
+        return false;
+    }
+    uint8_t header[16] {};
+    memcpy(header, TRACE_MAGIC, 4);
+    const uint16_t version = TRACE_VERSION;
+    memcpy(&header[4], &version, sizeof(version));
+    const uint64_t start_ns = trace_now_ns();
+    memcpy(&header[8], &start_ns, sizeof(start_ns));
+    if (::write(fd, header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        fprintf(stderr, "Failed to write trace file %s: %m\n", path);
+        ::close(fd);
+        return false;
+    }
+    __atomic_store_n(&_fd, fd, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint16_t Trace::name_id(const char *name)
+{
+    pthread_mutex_lock(&trace_names_mutex);
+    uint16_t id;
+    for (id=0; id<_num_names; id++) {
+        if (strncmp(_names[id], name, LINUX_TRACE_NAME_LEN-1) == 0) {
+            break;
+        }
+    }
+    if (id == _num_names) {
+        if (_num_names == LINUX_TRACE_MAX_NAMES) {
+            // share the last id rather than fail
+            id = LINUX_TRACE_MAX_NAMES - 1;
+        } else {
+            strncpy(_names[id], name, LINUX_TRACE_NAME_LEN-1);
+            __atomic_store_n(&_num_names, _num_names+1, __ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&trace_names_mutex);
+    return id;
+}
+
+/*
+  the ring of the calling thread, allocated on its first event
+ */
+struct Trace::ring *Trace::_thread_ring(void)
+{
+    struct ring *r = (struct ring *)trace_thread_ring;
+    if (r != NULL) {
+        return r;
+    }
+    r = TRACE_NO_RING;
+    const uint32_t index = __atomic_fetch_add(&_num_rings, 1, __ATOMIC_RELAXED);
+    if (index < LINUX_TRACE_MAX_THREADS) {
+        struct ring *newring = (struct ring *)calloc(1, sizeof(struct ring));
+        if (newring != NULL) {
+            newring->index = index;
+            if (pthread_getname_np(pthread_self(), newring->name, sizeof(newring->name)) != 0) {
+                snprintf(newring->name, sizeof(newring->name), "thread%u", (unsigned)index);
+            }
+            __atomic_store_n(&_rings[index], newring, __ATOMIC_RELEASE);
+            r = newring;
+        }
+    }
+    trace_thread_ring = r;
+    return r;
+}
+
+void Trace::_record(uint8_t type, uint16_t id)
+{
+    struct ring *r = _thread_ring();
+    if (r == TRACE_NO_RING) {
+        return;
+    }
+    const uint32_t head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= LINUX_TRACE_RING_SIZE) {
+        __atomic_store_n(&r->dropped, r->dropped+1, __ATOMIC_RELAXED);
+        return;
+    }
+    struct event &e = r->events[head & (LINUX_TRACE_RING_SIZE-1)];
+    e.time_ns = trace_now_ns();
+    e.id = id;
+    e.type = type;
+    __atomic_store_n(&r->head, head+1, __ATOMIC_RELEASE);
+}
+
+void Trace::_out_flush(void)
+{
+    uint32_t ofs = 0;
+    while (ofs < trace_out_len) {
+        ssize_t ret = ::write(_fd, &trace_out[ofs], trace_out_len - ofs);
+        if (ret <= 0) {
+            // give up on this buffer rather than block the IO thread
+            break;
+        }
+        ofs += ret;
+    }
+    trace_out_len = 0;
+}
+
+void Trace::_out(const void *data, uint32_t len)
+{
+    if (trace_out_len + len > sizeof(trace_out)) {
+        _out_flush();
+    }
+    memcpy(&trace_out[trace_out_len], data, len);
+    trace_out_len += len;
+}
+
+void Trace::flush(void)
+{
+    if (__atomic_load_n(&_fd, __ATOMIC_ACQUIRE) == -1) {
+        return;
+    }
+
+    // names registered since the last flush
+    const uint16_t num_names = __atomic_load_n(&_num_names, __ATOMIC_ACQUIRE);
+    while (_names_written < num_names) {
+        const char *name = _names[_names_written];
+        const uint8_t len = strnlen(name, LINUX_TRACE_NAME_LEN);
+        const uint8_t hdr[4] = { TRACE_RECORD_NAME,
+                                 (uint8_t)(_names_written & 0xFF),
+                                 (uint8_t)(_names_written >> 8),
+                                 len };
+        _out(hdr, sizeof(hdr));
+        _out(name, len);
+        _names_written++;
+    }
+
+    uint32_t num_rings = __atomic_load_n(&_num_rings, __ATOMIC_RELAXED);
+    if (num_rings > LINUX_TRACE_MAX_THREADS) {
+        num_rings = LINUX_TRACE_MAX_THREADS;
+    }
+    for (uint8_t i=0; i<num_rings; i++) {
+        struct ring *r = __atomic_load_n(&_rings[i], __ATOMIC_ACQUIRE);
+        if (r == NULL) {
+            continue;
+        }
+        if (!r->name_written) {
+            const uint8_t len = strnlen(r->name, sizeof(r->name));
+            const uint8_t hdr[3] = { TRACE_RECORD_THREAD, r->index, len };
+            _out(hdr, sizeof(hdr));
+            _out(r->name, len);
+            r->name_written = true;
+        }
+
+        const uint32_t dropped = __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+        if (dropped != r->dropped_reported) {
+            uint8_t rec[6] = { TRACE_RECORD_DROPPED, r->index };
+            memcpy(&rec[2], &dropped, sizeof(dropped));
+            _out(rec, sizeof(rec));
+            r->dropped_reported = dropped;
+        }
+
+        const uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        uint32_t tail = r->tail;
+        while (tail != head) {
+            // events up to the end of the ring, at most a buffer full per record
+            uint32_t n = head - tail;
+            const uint32_t to_end = LINUX_TRACE_RING_SIZE - (tail & (LINUX_TRACE_RING_SIZE-1));
+            if (n > to_end) {
+                n = to_end;
+            }
+            if (n > (TRACE_OUT_SIZE - 4) / sizeof(struct event)) {
+                n = (TRACE_OUT_SIZE - 4) / sizeof(struct event);
+            }
+            const uint8_t hdr[4] = { TRACE_RECORD_EVENTS, r->index,
+                                     (uint8_t)(n & 0xFF), (uint8_t)(n >> 8) };
+            _out(hdr, sizeof(hdr));
+            _out(&r->events[tail & (LINUX_TRACE_RING_SIZE-1)], n * sizeof(struct event));
+            tail += n;
+        }
+        __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    _out_flush();
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_LINUX
@@ -0,0 +1,116 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "AP_HAL_Linux.h"
+
+#define LINUX_TRACE_RING_SIZE  8192     // events buffered per thread, power of 2
+#define LINUX_TRACE_MAX_THREADS  16
+#define LINUX_TRACE_MAX_NAMES   512
+#define LINUX_TRACE_NAME_LEN     32
+
+/*
+  binary trace of begin/end events from perf counters, scheduler
+  tasks and the HAL thread loops, enabled with --trace FILE.
+
+  Each thread records events into its own single-producer ring buffer
+  without locking. The IO thread drains the rings into the trace file,
+  which Tools/scripts/linux_trace.py converts to Chrome trace JSON or
+  folded stacks.
+
+  File layout, little endian:
+    header:  "APTR", uint16 version, uint16 reserved, uint64 start_ns
+    records: uint8 type, then
+      TRACE_RECORD_NAME:    uint16 id, uint8 len, name
+      TRACE_RECORD_THREAD:  uint8 thread, uint8 len, name
+      TRACE_RECORD_EVENTS:  uint8 thread, uint16 count, count * event
+      TRACE_RECORD_DROPPED: uint8 thread, uint32 events lost so far
+    event:   uint64 time_ns, uint16 id, uint8 event type
+
+  Times are CLOCK_MONOTONIC nanoseconds.
+ */
+class Linux::Trace {
+public:
+    enum event_type {
+        EVENT_BEGIN = 1,
+        EVENT_END   = 2,
+        EVENT_COUNT = 3
+    };
+
+    enum record_type {
+        TRACE_RECORD_NAME    = 1,
+        TRACE_RECORD_THREAD  = 2,
+        TRACE_RECORD_EVENTS  = 3,
+        TRACE_RECORD_DROPPED = 4
+    };
+
+    // start tracing to path. Call before the HAL threads are created
+    static bool start(const char *path);
+
+    static bool enabled(void) { return _fd != -1; }
+
+    // id for events with this name, registering it if needed
+    static uint16_t name_id(const char *name);
+
+    static void begin(uint16_t id) {
+        if (_fd != -1) {
+            _record(EVENT_BEGIN, id);
+        }
+    }
+    static void end(uint16_t id) {
+        if (_fd != -1) {
+            _record(EVENT_END, id);
+        }
+    }
+    static void count(uint16_t id) {
+        if (_fd != -1) {
+            _record(EVENT_COUNT, id);
+        }
+    }
+
+    // write buffered events to the file. Called from the IO thread
+    static void flush(void);
+
+private:
+    struct PACKED event {
+        uint64_t time_ns;
+        uint16_t id;
+        uint8_t type;
+    };
+
+    struct ring {
+        struct event events[LINUX_TRACE_RING_SIZE];
+        uint32_t head;          // written by the owning thread
+        uint32_t tail;          // written by flush()
+        uint32_t dropped;       // written by the owning thread
+        uint32_t dropped_reported;
+        uint8_t index;
+        bool name_written;
+        char name[16];
+    };
+
+    static void _record(uint8_t type, uint16_t id);
+    static struct ring *_thread_ring(void);
+    static void _out(const void *data, uint32_t len);
+    static void _out_flush(void);
+
+    static int _fd;
+    static struct ring *_rings[LINUX_TRACE_MAX_THREADS];
+    static uint32_t _num_rings;
+
+    static char _names[LINUX_TRACE_MAX_NAMES][LINUX_TRACE_NAME_LEN];
+    static uint16_t _num_names;
+    static uint16_t _names_written;
+};
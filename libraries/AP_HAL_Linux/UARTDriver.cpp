@@ -393,6 +393,32 @@ int16_t UARTDriver::read()
     return c;
 }
 
+/*
+  copy up to count bytes out of the read ring buffer, in at most two
+  memcpy calls
+ */
+uint16_t UARTDriver::read(uint8_t *buffer, uint16_t count)
+{
+    if (!_initialised || _readbuf == NULL) {
+        return 0;
+    }
+    uint16_t _tail;
+    uint16_t avail = BUF_AVAILABLE(_readbuf);
+    if (count > avail) {
+        count = avail;
+    }
+    uint16_t n = _readbuf_size - _readbuf_head;
+    if (n > count) {
+        n = count;
+    }
+    memcpy(buffer, &_readbuf[_readbuf_head], n);
+    if (count > n) {
+        memcpy(&buffer[n], &_readbuf[0], count - n);
+    }
+    BUF_ADVANCEHEAD(_readbuf, count);
+    return count;
+}
+
 /* Linux implementations of Print virtual methods */
 size_t UARTDriver::write(uint8_t c) 
 { 
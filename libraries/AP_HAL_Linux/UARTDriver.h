@@ -27,6 +27,7 @@ public:
     int16_t available();
     int16_t txspace();
     int16_t read();
+    uint16_t read(uint8_t *buffer, uint16_t count);
 
     /* Linux implementations of Print virtual methods */
     size_t write(uint8_t c);
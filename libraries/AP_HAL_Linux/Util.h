@@ -69,6 +69,7 @@ public:
     void perf_begin(perf_counter_t perf) override;
     void perf_end(perf_counter_t perf) override;
     void perf_count(perf_counter_t perf) override;
+    bool perf_trace_enabled(void) const override;
 
     // create a new semaphore
     AP_HAL::Semaphore *new_semaphore(void) override { return new Linux::Semaphore; }
@@ -320,6 +320,22 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] = {
     // @User: Advanced
     // @Values: 1:IMU 1,2:IMU 2,3:IMU 3
     AP_GROUPINFO("ACC_BODYFIX", 26, AP_InertialSensor, _acc_body_aligned, 2),
+
+    // @Param: NOTCH_FREQ
+    // @DisplayName: Gyro notch filter frequency
+    // @Description: Center frequency of a notch filter applied to the gyroscopes after the low pass filter, for example at the main vibration frequency of the motors or rotor. A value of zero disables the notch
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    AP_GROUPINFO("NOTCH_FREQ", 27, AP_InertialSensor, _gyro_notch_freq, 0),
+
+    // @Param: NOTCH_BW
+    // @DisplayName: Gyro notch filter bandwidth
+    // @Description: Width of the gyro notch filter between its -3dB points
+    // @Units: Hz
+    // @Range: 5 500
+    // @User: Advanced
+    AP_GROUPINFO("NOTCH_BW", 28, AP_InertialSensor, _gyro_notch_bw, 20),
     /*
       NOTE: parameter indexes have gaps above. When adding new
       parameters check for conflicts carefully
@@ -371,6 +387,11 @@ AP_InertialSensor::AP_InertialSensor() :
         _delta_angle_acc[i].zero();
         _delta_angle_acc_dt[i] = 0;
         _last_delta_angle[i].zero();
+
+        _gyro_last_sample_us[i] = 0;
+        _gyro_sample_us[i] = 0;
+        _accel_last_sample_us[i] = 0;
+        _accel_sample_us[i] = 0;
         _last_raw_gyro[i].zero();
     }
     for (uint8_t i=0; i<INS_VIBRATION_CHECK_INSTANCES; i++) {
@@ -23,6 +23,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 #include <Filter/LowPassFilter2p.h>
+#include <Filter/BiquadFilterBank.h>
 #include <Filter/LowPassFilter.h>
 
 class AP_InertialSensor_Backend;
@@ -107,6 +108,11 @@ public:
     float get_delta_velocity_dt(uint8_t i) const;
     float get_delta_velocity_dt() const { return get_delta_velocity_dt(_primary_accel); }
 
+    // time in microseconds the sensor measured the newest sample in
+    // the current gyro and accel data, 0 if the backend does not say
+    uint64_t get_gyro_sample_us(uint8_t i) const { return _gyro_sample_us[i]; }
+    uint64_t get_accel_sample_us(uint8_t i) const { return _accel_sample_us[i]; }
+
     /// Fetch the current accelerometer values
     ///
     /// @returns	vector of current accelerations in m/s/s
@@ -292,9 +298,10 @@ private:
     // time accumulator for delta velocity accumulator
     float _delta_velocity_acc_dt[INS_MAX_INSTANCES];
 
-    // Low Pass filters for gyro and accel
-    LowPassFilter2pVector3f _accel_filter[INS_MAX_INSTANCES];
-    LowPassFilter2pVector3f _gyro_filter[INS_MAX_INSTANCES];
+    // filters for gyro and accel, one group per instance. The gyro
+    // has a low pass section followed by an optional notch
+    BiquadFilterBank<INS_MAX_INSTANCES, 1> _accel_filter;
+    BiquadFilterBank<INS_MAX_INSTANCES, 2> _gyro_filter;
     Vector3f _accel_filtered[INS_MAX_INSTANCES];
     Vector3f _gyro_filtered[INS_MAX_INSTANCES];
     bool _new_accel_data[INS_MAX_INSTANCES];
@@ -311,6 +318,13 @@ private:
     Vector3f _last_delta_angle[INS_MAX_INSTANCES];
     Vector3f _last_raw_gyro[INS_MAX_INSTANCES];
 
+    // measurement time of the newest raw sample, and of the newest
+    // sample in the published data
+    uint64_t _gyro_last_sample_us[INS_MAX_INSTANCES];
+    uint64_t _gyro_sample_us[INS_MAX_INSTANCES];
+    uint64_t _accel_last_sample_us[INS_MAX_INSTANCES];
+    uint64_t _accel_sample_us[INS_MAX_INSTANCES];
+
     // product id
     AP_Int16 _product_id;
 
@@ -332,6 +346,8 @@ private:
     // filtering frequency (0 means default)
     AP_Int8     _accel_filter_cutoff;
     AP_Int8     _gyro_filter_cutoff;
+    AP_Int16    _gyro_notch_freq;
+    AP_Int16    _gyro_notch_bw;
     AP_Int8     _gyro_cal_timing;
 
     // use for attitude, velocity, position estimates
@@ -47,6 +47,7 @@ void AP_InertialSensor_Backend::_publish_gyro(uint8_t instance, const Vector3f &
 {
     _imu._gyro[instance] = gyro;
     _imu._gyro_healthy[instance] = true;
+    _imu._gyro_sample_us[instance] = _imu._gyro_last_sample_us[instance];
 
     if (_imu._gyro_raw_sample_rates[instance] <= 0) {
         return;
@@ -94,16 +95,18 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     _imu._last_delta_angle[instance] = delta_angle;
     _imu._last_raw_gyro[instance] = gyro;
 
-    _imu._gyro_filtered[instance] = _imu._gyro_filter[instance].apply(gyro);
+    _imu._gyro_filtered[instance] = _imu._gyro_filter.apply(instance, gyro);
     if (_imu._gyro_filtered[instance].is_nan() || _imu._gyro_filtered[instance].is_inf()) {
-        _imu._gyro_filter[instance].reset();
+        _imu._gyro_filter.reset(instance);
     }
 
     _imu._new_gyro_data[instance] = true;
 
+    uint64_t now = AP_HAL::micros64();
+    _imu._gyro_last_sample_us[instance] = sample_us?sample_us:now;
+
     DataFlash_Class *dataflash = get_dataflash();
     if (dataflash != NULL) {
-        uint64_t now = AP_HAL::micros64();
         struct log_GYRO pkt = {
             LOG_PACKET_HEADER_INIT((uint8_t)(LOG_GYR1_MSG+instance)),
             time_us   : now,
@@ -123,6 +126,7 @@ void AP_InertialSensor_Backend::_publish_accel(uint8_t instance, const Vector3f
 {
     _imu._accel[instance] = accel;
     _imu._accel_healthy[instance] = true;
+    _imu._accel_sample_us[instance] = _imu._accel_last_sample_us[instance];
 
     if (_imu._accel_raw_sample_rates[instance] <= 0) {
         return;
@@ -171,18 +175,20 @@ void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
     _imu._delta_velocity_acc[instance] += accel * dt;
     _imu._delta_velocity_acc_dt[instance] += dt;
 
-    _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(accel);
+    _imu._accel_filtered[instance] = _imu._accel_filter.apply(instance, accel);
     if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
-        _imu._accel_filter[instance].reset();
+        _imu._accel_filter.reset(instance);
     }
 
     _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
 
     _imu._new_accel_data[instance] = true;
 
+    uint64_t now = AP_HAL::micros64();
+    _imu._accel_last_sample_us[instance] = sample_us?sample_us:now;
+
     DataFlash_Class *dataflash = get_dataflash();
     if (dataflash != NULL) {
-        uint64_t now = AP_HAL::micros64();
         struct log_ACCEL pkt = {
             LOG_PACKET_HEADER_INIT((uint8_t)(LOG_ACC1_MSG+instance)),
             time_us   : now,
@@ -242,9 +248,16 @@ void AP_InertialSensor_Backend::update_gyro(uint8_t instance)
 
     // possibly update filter frequency
     if (_last_gyro_filter_hz[instance] != _gyro_filter_cutoff()) {
-        _imu._gyro_filter[instance].set_cutoff_frequency(_gyro_raw_sample_rate(instance), _gyro_filter_cutoff());
+        _imu._gyro_filter.set_lowpass(instance, 0, _gyro_raw_sample_rate(instance), _gyro_filter_cutoff());
         _last_gyro_filter_hz[instance] = _gyro_filter_cutoff();
     }
+    if (_last_gyro_notch_hz[instance] != _gyro_notch_freq() ||
+        _last_gyro_notch_bw[instance] != _gyro_notch_bw()) {
+        _imu._gyro_filter.set_notch(instance, 1, _gyro_raw_sample_rate(instance),
+                                    _gyro_notch_freq(), _gyro_notch_bw());
+        _last_gyro_notch_hz[instance] = _gyro_notch_freq();
+        _last_gyro_notch_bw[instance] = _gyro_notch_bw();
+    }
 
     hal.scheduler->resume_timer_procs();
 }
@@ -263,7 +276,7 @@ void AP_InertialSensor_Backend::update_accel(uint8_t instance)
     
     // possibly update filter frequency
     if (_last_accel_filter_hz[instance] != _accel_filter_cutoff()) {
-        _imu._accel_filter[instance].set_cutoff_frequency(_accel_raw_sample_rate(instance), _accel_filter_cutoff());
+        _imu._accel_filter.set_lowpass(instance, 0, _accel_raw_sample_rate(instance), _accel_filter_cutoff());
         _last_accel_filter_hz[instance] = _accel_filter_cutoff();
     }
 
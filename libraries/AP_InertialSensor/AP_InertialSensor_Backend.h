@@ -86,6 +86,7 @@ protected:
     // be it published or not
     // the sample is raw in the sense that it's not filtered yet, but it must
     // be rotated and corrected (_rotate_and_correct_gyro)
+    // sample_us is the time the sensor measured the sample, if known
     void _notify_new_gyro_raw_sample(uint8_t instance, const Vector3f &accel, uint64_t sample_us=0);
 
     // rotate accel vector, scale, offset and publish
@@ -95,6 +96,7 @@ protected:
     // be it published or not
     // the sample is raw in the sense that it's not filtered yet, but it must
     // be rotated and corrected (_rotate_and_correct_accel)
+    // sample_us is the time the sensor measured the sample, if known
     void _notify_new_accel_raw_sample(uint8_t instance, const Vector3f &accel, uint64_t sample_us=0);
 
     // set accelerometer max absolute offset for calibration
@@ -131,6 +133,10 @@ protected:
     // return the default filter frequency in Hz for the sample rate
     uint8_t _gyro_filter_cutoff(void) const { return _imu._gyro_filter_cutoff; }
 
+    // return the gyro notch frequency and bandwidth in Hz
+    int16_t _gyro_notch_freq(void) const { return _imu._gyro_notch_freq; }
+    int16_t _gyro_notch_bw(void) const { return _imu._gyro_notch_bw; }
+
     // return the requested sample rate in Hz
     uint16_t get_sample_rate_hz(void) const;
 
@@ -148,6 +154,8 @@ protected:
     // support for updating filter at runtime
     int8_t _last_accel_filter_hz[INS_MAX_INSTANCES];
     int8_t _last_gyro_filter_hz[INS_MAX_INSTANCES];
+    int16_t _last_gyro_notch_hz[INS_MAX_INSTANCES];
+    int16_t _last_gyro_notch_bw[INS_MAX_INSTANCES];
 
     // note that each backend is also expected to have a static detect()
     // function which instantiates an instance of the backend sensor
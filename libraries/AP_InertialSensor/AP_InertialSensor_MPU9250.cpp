@@ -72,11 +72,18 @@ extern const AP_HAL::HAL& hal;
 #       define BITS_GYRO_YGYRO_SELFTEST                 0x40
 #       define BITS_GYRO_XGYRO_SELFTEST                 0x80
 #define MPUREG_ACCEL_CONFIG                             0x1C
+#define MPUREG_ACCEL_CONFIG2                            0x1D
+#       define BIT_ACCEL_FCHOICE_B                              0x08    // bypass the accel DLPF: 4kHz rate, 1.13kHz bandwidth
 #define MPUREG_MOT_THR                                  0x1F    // detection threshold for Motion interrupt generation.  Motion is detected when the absolute value of any of the accelerometer measurements exceeds this
 #define MPUREG_MOT_DUR                                  0x20    // duration counter threshold for Motion interrupt generation. The duration counter ticks at 1 kHz, therefore MOT_DUR has a unit of 1 LSB = 1 ms
 #define MPUREG_ZRMOT_THR                                0x21    // detection threshold for Zero Motion interrupt generation.
 #define MPUREG_ZRMOT_DUR                                0x22    // duration counter threshold for Zero Motion interrupt generation. The duration counter ticks at 16 Hz, therefore ZRMOT_DUR has a unit of 1 LSB = 64 ms.
 #define MPUREG_FIFO_EN                                  0x23
+#       define BIT_TEMP_FIFO_EN                                 0x80
+#       define BIT_XG_FIFO_EN                                   0x40
+#       define BIT_YG_FIFO_EN                                   0x20
+#       define BIT_ZG_FIFO_EN                                   0x10
+#       define BIT_ACCEL_FIFO_EN                                0x08
 #define MPUREG_INT_PIN_CFG                              0x37
 #       define BIT_INT_RD_CLEAR                                 0x10    // clear the interrupt when any read occurs
 #       define BIT_LATCH_INT_EN                                 0x20    // latch data ready pin
@@ -195,12 +202,6 @@ extern const AP_HAL::HAL& hal;
  *  variants however
  */
 
-/*
- * 2 bytes for each in this order: ACC_X, ACC_Y, ACC_Z, TEMP, GYRO_X, GYRO_Y
- * and GYRO_Z
- */
-#define MPU9250_SAMPLE_SIZE 14
-
 /* SPI bus driver implementation */
 AP_MPU9250_BusDriver_SPI::AP_MPU9250_BusDriver_SPI(AP_HAL::SPIDeviceDriver *spi)
 {
@@ -213,6 +214,30 @@ void AP_MPU9250_BusDriver_SPI::init()
     write8(MPUREG_USER_CTRL, BIT_USER_CTRL_I2C_IF_DIS);
 }
 
+void AP_MPU9250_BusDriver_SPI::start(bool &fifo_mode)
+{
+    // gyro, temperature and accel go into the FIFO in the same order
+    // as the data registers, one 14 byte record per sample
+    fifo_mode = true;
+    write8(MPUREG_FIFO_EN, BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
+                           BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN);
+    _fifo_reset();
+}
+
+/*
+  clear the FIFO, keeping the other USER_CTRL bits (I2C_IF_DIS and the
+  auxiliary bus master) as they are
+ */
+void AP_MPU9250_BusDriver_SPI::_fifo_reset()
+{
+    uint8_t user_ctrl;
+    read8(MPUREG_USER_CTRL, &user_ctrl);
+    user_ctrl &= ~(BIT_USER_CTRL_FIFO_EN | BIT_USER_CTRL_FIFO_RESET);
+    write8(MPUREG_USER_CTRL, user_ctrl);
+    write8(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
+    write8(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
+}
+
 void AP_MPU9250_BusDriver_SPI::read8(uint8_t reg, uint8_t *val)
 {
     uint8_t addr = reg | 0x80; // Set most significant bit
@@ -254,28 +279,57 @@ void AP_MPU9250_BusDriver_SPI::set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed
     _spi->set_bus_speed(speed);
 }
 
-bool AP_MPU9250_BusDriver_SPI::read_data_transaction(uint8_t *samples, uint8_t &n_samples)
+/*
+  read everything the sensor has put in the FIFO since the last poll:
+  one transaction for the byte count, then a single burst of up to
+  MPU9250_MAX_FIFO_SAMPLES samples. Anything left over is picked up
+  by the next poll.
+
+  The newest sample in the FIFO was measured at most one sample period
+  before the count transaction completed, so the samples are timestamped
+  back from that time at the FIFO rate.
+ */
+bool AP_MPU9250_BusDriver_SPI::read_data_transaction(uint8_t *samples, uint8_t &n_samples,
+                                                     uint64_t &last_sample_us)
 {
-    /* one register address followed by seven 2-byte registers */
     struct PACKED {
         uint8_t cmd;
-        uint8_t int_status;
-        uint8_t v[MPU9250_SAMPLE_SIZE];
-    } rx, tx = { cmd : MPUREG_INT_STATUS | 0x80, };
+        uint8_t count_h;
+        uint8_t count_l;
+    } rx, tx = { cmd : MPUREG_FIFO_COUNTH | 0x80, };
+
+    n_samples = 0;
 
     _spi->transaction((const uint8_t *)&tx, (uint8_t *)&rx, sizeof(rx));
+    const uint64_t count_us = AP_HAL::micros64();
 
-    if (!(rx.int_status & BIT_RAW_RDY_INT)) {
-        n_samples = 0;
+    uint16_t bytes = ((uint16_t)(rx.count_h & 0x1F) << 8) | rx.count_l;
+    if (bytes % MPU9250_SAMPLE_SIZE != 0 ||
+        bytes > MPU9250_FIFO_SIZE - MPU9250_SAMPLE_SIZE) {
+        /* the FIFO overflowed and the records are no longer aligned */
 #if MPU9250_DEBUG
-        hal.console->printf("MPU9250: No sample available.\n");
+        hal.console->printf("MPU9250: FIFO overflow, %u bytes\n", (unsigned)bytes);
 #endif
+        _fifo_reset();
         return false;
     }
 
-    n_samples = 1;
-    memcpy(&samples[0], &rx.v[0], MPU9250_SAMPLE_SIZE);
+    const uint16_t available = bytes / MPU9250_SAMPLE_SIZE;
+    if (available == 0) {
+        return false;
+    }
+    uint16_t n = available;
+    if (n > MPU9250_MAX_FIFO_SAMPLES) {
+        n = MPU9250_MAX_FIFO_SAMPLES;
+    }
+    last_sample_us = count_us - (available - n) * (1000000ULL / MPU9250_FIFO_SAMPLE_RATE);
+
+    const uint16_t len = n * MPU9250_SAMPLE_SIZE;
+    _tx[0] = MPUREG_FIFO_R_W | 0x80;
+    _spi->transaction(_tx, _rx, len + 1);
+    memcpy(samples, &_rx[1], len);
 
+    n_samples = n;
     return true;
 }
 
@@ -306,6 +360,13 @@ void AP_MPU9250_BusDriver_I2C::init()
     write8(MPUREG_INT_PIN_CFG, value);
 }
 
+void AP_MPU9250_BusDriver_I2C::start(bool &fifo_mode)
+{
+    // the I2C bus is too slow to drain a full rate FIFO, so keep
+    // reading one sample per poll from the data registers
+    fifo_mode = false;
+}
+
 void AP_MPU9250_BusDriver_I2C::read8(uint8_t reg, uint8_t *val)
 {
     _i2c->readRegister(_addr, reg, val);
@@ -322,7 +383,8 @@ void AP_MPU9250_BusDriver_I2C::write8(uint8_t reg, uint8_t val)
 }
 
 bool AP_MPU9250_BusDriver_I2C::read_data_transaction(uint8_t *samples,
-                                                     uint8_t &n_samples)
+                                                     uint8_t &n_samples,
+                                                     uint64_t &last_sample_us)
 {
     uint8_t ret = 0;
     struct PACKED {
@@ -347,6 +409,7 @@ bool AP_MPU9250_BusDriver_I2C::read_data_transaction(uint8_t *samples,
 
     memcpy(samples, buffer.v, MPU9250_SAMPLE_SIZE);
     n_samples = 1;
+    last_sample_us = AP_HAL::micros64();
     return true;
 }
 
@@ -363,6 +426,8 @@ bool AP_MPU9250_BusDriver_I2C::has_auxiliary_bus()
 AP_InertialSensor_MPU9250::AP_InertialSensor_MPU9250(AP_InertialSensor &imu, AP_MPU9250_BusDriver *bus) :
 	AP_InertialSensor_Backend(imu),
     _bus(bus),
+    _fifo_mode(false),
+    _sample_rate(DEFAULT_SAMPLE_RATE),
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
     _default_rotation(ROTATION_ROLL_180_YAW_270)
 #elif CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO
@@ -434,8 +499,8 @@ bool AP_InertialSensor_MPU9250::_init_sensor()
     if (!_hardware_init())
         return false;
 
-    _gyro_instance = _imu.register_gyro(DEFAULT_SAMPLE_RATE);
-    _accel_instance = _imu.register_accel(DEFAULT_SAMPLE_RATE);
+    _gyro_instance = _imu.register_gyro(_sample_rate);
+    _accel_instance = _imu.register_accel(_sample_rate);
 
     _product_id = AP_PRODUCT_ID_MPU9250;
 
@@ -485,32 +550,50 @@ void AP_InertialSensor_MPU9250::_poll_data(void)
 void AP_InertialSensor_MPU9250::_read_data_transaction() 
 {
     uint8_t n_samples;
-    uint8_t rx[MPU9250_SAMPLE_SIZE];
-
-    Vector3f accel, gyro;
+    uint64_t last_sample_us;
 
-    if (!_bus->read_data_transaction(rx, n_samples)) {
+    if (!_bus->read_data_transaction(_samples, n_samples, last_sample_us)) {
         return;
     }
 
-#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
-
-    accel = Vector3f(int16_val(rx, 1),
-                     int16_val(rx, 0),
-                     -int16_val(rx, 2));
-    accel *= MPU9250_ACCEL_SCALE_1G;
-    accel.rotate(_default_rotation);
-    _rotate_and_correct_accel(_accel_instance, accel);
-    _notify_new_accel_raw_sample(_accel_instance, accel);
+    _accumulate(_samples, n_samples, last_sample_us);
+}
 
-    gyro = Vector3f(int16_val(rx, 5),
-                    int16_val(rx, 4),
-                    -int16_val(rx, 6));
-    gyro *= GYRO_SCALE;
-    gyro.rotate(_default_rotation);
+/*
+  feed each sample to the frontend at the sensor rate, so the delta
+  angle and delta velocity accumulators (with coning correction) and
+  the software filters all run at the native sample rate. Each sample
+  carries the time the sensor measured it
+ */
+void AP_InertialSensor_MPU9250::_accumulate(const uint8_t *samples, uint8_t n_samples,
+                                            uint64_t last_sample_us)
+{
+#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
 
-    _rotate_and_correct_gyro(_gyro_instance, gyro);
-    _notify_new_gyro_raw_sample(_gyro_instance, gyro);
+    const uint32_t period_us = 1000000UL / _sample_rate;
+
+    for (uint8_t i = 0; i < n_samples; i++) {
+        const uint8_t *data = samples + MPU9250_SAMPLE_SIZE * i;
+        const uint64_t sample_us = last_sample_us - (uint64_t)(n_samples - 1 - i) * period_us;
+        Vector3f accel, gyro;
+
+        accel = Vector3f(int16_val(data, 1),
+                         int16_val(data, 0),
+                         -int16_val(data, 2));
+        accel *= MPU9250_ACCEL_SCALE_1G;
+        accel.rotate(_default_rotation);
+        _rotate_and_correct_accel(_accel_instance, accel);
+        _notify_new_accel_raw_sample(_accel_instance, accel, sample_us);
+
+        gyro = Vector3f(int16_val(data, 5),
+                        int16_val(data, 4),
+                        -int16_val(data, 6));
+        gyro *= GYRO_SCALE;
+        gyro.rotate(_default_rotation);
+
+        _rotate_and_correct_gyro(_gyro_instance, gyro);
+        _notify_new_gyro_raw_sample(_gyro_instance, gyro, sample_us);
+    }
 }
 
 /*
@@ -601,6 +684,8 @@ bool AP_InertialSensor_MPU9250::_hardware_init(void)
 
     _register_write(MPUREG_PWR_MGMT_2, 0x00);            // only used for wake-up in accelerometer only low power mode
 
+    _bus->start(_fifo_mode);
+
     // used no filter of 256Hz on the sensor, then filter using
     // the 2-pole software filter
     _register_write(MPUREG_CONFIG, BITS_DLPF_CFG_256HZ_NOLPF2);
@@ -613,6 +698,15 @@ bool AP_InertialSensor_MPU9250::_hardware_init(void)
     // RM-MPU-9250A-00.pdf, pg. 15, select accel full scale 16g
     _register_write(MPUREG_ACCEL_CONFIG,3<<3);
 
+    if (_fifo_mode) {
+        // with the gyro DLPF at 250Hz the internal rate is 8kHz and
+        // SMPLRT_DIV is ignored, so every gyro sample goes into the
+        // FIFO. Bypass the accel DLPF to sample it at 4kHz; each FIFO
+        // record carries the latest accel sample
+        _register_write(MPUREG_ACCEL_CONFIG2, BIT_ACCEL_FCHOICE_B);
+        _sample_rate = MPU9250_FIFO_SAMPLE_RATE;
+    }
+
     // configure interrupt to fire when new data arrives
     _register_write(MPUREG_INT_ENABLE, BIT_RAW_RDY_EN);
 
@@ -696,9 +790,13 @@ void AP_MPU9250_AuxiliaryBus::_configure_slaves()
     /* stop condition between reads; clock at 400kHz */
     backend._register_write(MPUREG_I2C_MST_CTRL, I2C_MST_CLOCK_400KHZ | I2C_MST_P_NSR);
 
-    /* Hard-code divider for internal sample rate, 1 kHz, resulting in a
-     * sample rate of 100Hz */
-    backend._register_write(MPUREG_I2C_SLV4_CTRL, 9);
+    /* Divide the internal sample rate down to read the slaves at 100Hz,
+     * or as close as the 5 bit divider gets at the FIFO rate */
+    uint16_t slv_div = backend._sample_rate / 100 - 1;
+    if (slv_div > 31) {
+        slv_div = 31;
+    }
+    backend._register_write(MPUREG_I2C_SLV4_CTRL, slv_div);
 
     /* All slaves are subject to the sample rate */
     backend._register_write(MPUREG_I2C_MST_DELAY_CTRL, I2C_SLV0_DLY_EN
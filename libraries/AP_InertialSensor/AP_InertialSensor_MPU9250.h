@@ -18,17 +18,33 @@ class AP_MPU9250_AuxiliaryBusSlave;
 // enable debug to see a register dump on startup
 #define MPU9250_DEBUG 0
 
+/*
+ * 2 bytes for each in this order: ACC_X, ACC_Y, ACC_Z, TEMP, GYRO_X, GYRO_Y
+ * and GYRO_Z
+ */
+#define MPU9250_SAMPLE_SIZE 14
+
+// the FIFO runs at the full 8kHz gyro rate. A 1kHz poll drains about 8
+// samples; allow for a few late polls before the 512 byte FIFO overflows
+#define MPU9250_FIFO_SIZE 512
+#define MPU9250_FIFO_SAMPLE_RATE 8000
+#define MPU9250_MAX_FIFO_SAMPLES 24
+
 class AP_MPU9250_BusDriver
 {
 public:
     virtual ~AP_MPU9250_BusDriver() { };
     virtual void init() = 0;
+    virtual void start(bool &fifo_mode) = 0;
     virtual void read8(uint8_t reg, uint8_t *val) = 0;
     virtual void write8(uint8_t reg, uint8_t val) = 0;
     virtual void read_block(uint8_t reg, uint8_t *val, uint8_t count) = 0;
     virtual void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed) = 0;
+    // read the samples available, oldest first. last_sample_us is
+    // the time the sensor measured the last of them
     virtual bool read_data_transaction(uint8_t* samples,
-                                       uint8_t &n_samples) = 0;
+                                       uint8_t &n_samples,
+                                       uint64_t &last_sample_us) = 0;
     virtual AP_HAL::Semaphore* get_semaphore() = 0;
     virtual bool has_auxiliary_bus() = 0;
 };
@@ -69,6 +85,7 @@ private:
     uint8_t              _register_read( uint8_t reg );
     void                 _register_write( uint8_t reg, uint8_t val );
     bool                 _hardware_init(void);
+    void                 _accumulate(const uint8_t *samples, uint8_t n_samples, uint64_t last_sample_us);
 
     AP_MPU9250_BusDriver *_bus;
     AP_HAL::Semaphore *_bus_sem;
@@ -78,6 +95,11 @@ private:
     uint8_t _gyro_instance;
     uint8_t _accel_instance;
 
+    // samples are read from the FIFO in bursts when the bus supports it
+    bool _fifo_mode;
+    uint16_t _sample_rate;
+    uint8_t _samples[MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE];
+
     // The default rotation for the IMU, its value depends on how the IMU is
     // placed by default on the system
     enum Rotation _default_rotation;
@@ -92,16 +114,23 @@ class AP_MPU9250_BusDriver_SPI : public AP_MPU9250_BusDriver
 public:
     AP_MPU9250_BusDriver_SPI(AP_HAL::SPIDeviceDriver *spi);
     void init();
+    void start(bool &fifo_mode);
     void read8(uint8_t reg, uint8_t *val);
     void write8(uint8_t reg, uint8_t val);
     void read_block(uint8_t reg, uint8_t *val, uint8_t count);
     void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed);
-    bool read_data_transaction(uint8_t* samples, uint8_t &n_samples);
+    bool read_data_transaction(uint8_t* samples, uint8_t &n_samples, uint64_t &last_sample_us);
     AP_HAL::Semaphore* get_semaphore();
     bool has_auxiliary_bus();
 
 private:
+    void _fifo_reset();
+
     AP_HAL::SPIDeviceDriver *_spi;
+
+    // buffers for the FIFO burst, one byte for the register address
+    uint8_t _tx[MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE + 1];
+    uint8_t _rx[MPU9250_MAX_FIFO_SAMPLES * MPU9250_SAMPLE_SIZE + 1];
 };
 
 class AP_MPU9250_BusDriver_I2C : public AP_MPU9250_BusDriver
@@ -109,11 +138,12 @@ class AP_MPU9250_BusDriver_I2C : public AP_MPU9250_BusDriver
 public:
     AP_MPU9250_BusDriver_I2C(AP_HAL::I2CDriver *i2c, uint8_t addr);
     void init();
+    void start(bool &fifo_mode);
     void read8(uint8_t reg, uint8_t *val);
     void write8(uint8_t reg, uint8_t val);
     void read_block(uint8_t reg, uint8_t *val, uint8_t count);
     void set_bus_speed(AP_HAL::SPIDeviceDriver::bus_speed speed) {};
-    bool read_data_transaction(uint8_t* samples, uint8_t &n_samples);
+    bool read_data_transaction(uint8_t* samples, uint8_t &n_samples, uint64_t &last_sample_us);
     AP_HAL::Semaphore* get_semaphore();
     bool has_auxiliary_bus();
 
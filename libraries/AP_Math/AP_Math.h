@@ -146,6 +146,9 @@ void        location_offset(struct Location &loc, float ofs_north, float ofs_eas
  */
 Vector2f location_diff(const struct Location &loc1, const struct Location &loc2);
 
+// local tangent plane for converting many locations near a common origin
+#include "location_ltp.h"
+
 /*
   wrap an angle in centi-degrees
  */
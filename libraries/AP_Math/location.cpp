@@ -148,6 +148,67 @@ Vector2f location_diff(const struct Location &loc1, const struct Location &loc2)
                     (loc2.lng - loc1.lng) * LOCATION_SCALING_FACTOR * longitude_scale(loc1));
 }
 
+/*
+  set the reference location of a local tangent plane
+ */
+void LocationLTP::set_origin(const struct Location &origin)
+{
+    _origin = origin;
+    // calculate the longitude scale directly rather than through
+    // longitude_scale(), which may return a cached value for a nearby
+    // latitude on slow CPUs
+    float scale = constrain_float(cosf(origin.lat * 1.0e-7f * DEG_TO_RAD), 0.01f, 1.0f);
+    _scale_north = LOCATION_SCALING_FACTOR;
+    _scale_east = LOCATION_SCALING_FACTOR * scale;
+}
+
+/*
+  return the bearing in centi-degrees from the origin to loc
+ */
+int32_t LocationLTP::bearing_cd(const struct Location &loc) const
+{
+    const Vector2f ne = diff(loc);
+    int32_t bearing = 9000 + atan2f(-ne.x, ne.y) * 5729.57795f;
+    if (bearing < 0) bearing += 36000;
+    return bearing;
+}
+
+/*
+  move loc to ofs meters north/east of the origin
+ */
+void LocationLTP::offset(struct Location &loc, const Vector2f &ofs) const
+{
+    loc.lat = _origin.lat + (int32_t)(ofs.x / _scale_north);
+    loc.lng = _origin.lng + (int32_t)(ofs.y / _scale_east);
+}
+
+/*
+  convert count locations to north/east offsets from the origin. The
+  loop body is branch free so it can be unrolled by the compiler
+ */
+void LocationLTP::diff(const struct Location *locs, Vector2f *ne, uint16_t count) const
+{
+    const int32_t lat0 = _origin.lat;
+    const int32_t lng0 = _origin.lng;
+    for (uint16_t i=0; i<count; i++) {
+        ne[i].x = (locs[i].lat - lat0) * _scale_north;
+        ne[i].y = (locs[i].lng - lng0) * _scale_east;
+    }
+}
+
+/*
+  convert count lat/lng pairs to north/east offsets from the origin
+ */
+void LocationLTP::diff(const Vector2l *latlng, Vector2f *ne, uint16_t count) const
+{
+    const int32_t lat0 = _origin.lat;
+    const int32_t lng0 = _origin.lng;
+    for (uint16_t i=0; i<count; i++) {
+        ne[i].x = (latlng[i].x - lat0) * _scale_north;
+        ne[i].y = (latlng[i].y - lng0) * _scale_east;
+    }
+}
+
 /*
   wrap an angle in centi-degrees to 0..35999
  */
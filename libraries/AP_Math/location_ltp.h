@@ -0,0 +1,75 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * location_ltp.h
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LOCATION_LTP_H
+#define LOCATION_LTP_H
+
+/*
+  LocationLTP - a local tangent plane around a reference location.
+
+  The longitude scale of the origin is calculated once in set_origin(),
+  so converting many locations near the origin to north/east offsets
+  costs a few multiplies each instead of a cosf() per call. Results
+  match location_diff(origin, loc), which also scales by the latitude
+  of its first argument.
+ */
+class LocationLTP
+{
+public:
+    LocationLTP() :
+        _origin(),
+        _scale_north(0.0f),
+        _scale_east(0.0f)
+    {}
+
+    // set the reference location, calculating the scale factors for it
+    void set_origin(const struct Location &origin);
+
+    // return the reference location
+    const struct Location &origin() const { return _origin; }
+
+    // return true if set_origin() has been called
+    bool have_origin() const { return !is_zero(_scale_north); }
+
+    // return the distance in meters north/east from the origin to loc
+    Vector2f diff(const struct Location &loc) const {
+        return Vector2f((loc.lat - _origin.lat) * _scale_north,
+                        (loc.lng - _origin.lng) * _scale_east);
+    }
+
+    // return the distance in meters from the origin to loc
+    float distance(const struct Location &loc) const { return diff(loc).length(); }
+
+    // return the bearing in centi-degrees from the origin to loc
+    int32_t bearing_cd(const struct Location &loc) const;
+
+    // move loc to ofs meters north/east of the origin. Altitude and options are unchanged
+    void offset(struct Location &loc, const Vector2f &ofs) const;
+
+    // convert count locations to north/east offsets from the origin
+    void diff(const struct Location *locs, Vector2f *ne, uint16_t count) const;
+
+    // convert count lat/lng pairs (x=lat, y=lng in 1e-7 degrees) to north/east offsets from the origin
+    void diff(const Vector2l *latlng, Vector2f *ne, uint16_t count) const;
+
+private:
+    struct Location _origin;
+    float _scale_north;         // meters per 1e-7 degree of latitude
+    float _scale_east;          // meters per 1e-7 degree of longitude at the origin latitude
+};
+
+#endif // LOCATION_LTP_H
@@ -89,3 +89,53 @@ bool Polygon_complete(const Vector2l *V, unsigned n)
 {
     return (n >= 4 && V[n-1].x == V[0].x && V[n-1].y == V[0].y);
 }
+
+/*
+ *  Polygon_outside(): test for a point in a polygon of float vertices
+ *     Input:   P = a point,
+ *              V[] = vertex points of a polygon with n vertices. The
+ *                    polygon is implicitly closed from V[n-1] back to
+ *                    V[0], so the first point need not be repeated
+ *     Return:  true if P is outside the polygon
+ */
+bool Polygon_outside(const Vector2f &P, const Vector2f *V, unsigned n)
+{
+    unsigned i, j;
+    bool outside = true;
+    for (i = 0, j = n-1; i < n; j = i++) {
+        if ((V[i].y > P.y) == (V[j].y > P.y)) {
+            continue;
+        }
+        float x_cross = V[i].x + (P.y - V[i].y) * (V[j].x - V[i].x) / (V[j].y - V[i].y);
+        if (P.x < x_cross) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+/*
+ *  Polygon_distance(): return the distance from a point to the
+ *  nearest edge of a polygon of n float vertices. The polygon is
+ *  implicitly closed from V[n-1] back to V[0]
+ */
+float Polygon_distance(const Vector2f &P, const Vector2f *V, unsigned n)
+{
+    float min_dist_sq = -1.0f;
+    unsigned i, j;
+    for (i = 0, j = n-1; i < n; j = i++) {
+        const Vector2f edge = V[i] - V[j];
+        const Vector2f ofs = P - V[j];
+        const float edge_len_sq = edge * edge;
+        float t = 0.0f;
+        if (edge_len_sq > 0.0f) {
+            t = constrain_float((ofs * edge) / edge_len_sq, 0.0f, 1.0f);
+        }
+        const Vector2f closest = ofs - edge * t;
+        const float dist_sq = closest * closest;
+        if (min_dist_sq < 0.0f || dist_sq < min_dist_sq) {
+            min_dist_sq = dist_sq;
+        }
+    }
+    return sqrtf(MAX(min_dist_sq, 0.0f));
+}
@@ -19,4 +19,6 @@
 
 bool        Polygon_outside(const Vector2l &P, const Vector2l *V, unsigned n);
 bool        Polygon_complete(const Vector2l *V, unsigned n);
+bool        Polygon_outside(const Vector2f &P, const Vector2f *V, unsigned n);
+float       Polygon_distance(const Vector2f &P, const Vector2f *V, unsigned n);
 
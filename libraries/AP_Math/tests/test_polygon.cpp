@@ -0,0 +1,87 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+// 10m square with its corner at the origin, not closed
+static const Vector2f square[] = {
+    Vector2f(0, 0), Vector2f(10, 0), Vector2f(10, 10), Vector2f(0, 10)
+};
+
+// concave "L" shape, with the notch at x > 5, y > 5
+static const Vector2f ell[] = {
+    Vector2f(0, 0), Vector2f(10, 0), Vector2f(10, 5),
+    Vector2f(5, 5), Vector2f(5, 10), Vector2f(0, 10)
+};
+
+TEST(PolygonTest, OutsideFloat)
+{
+    EXPECT_FALSE(Polygon_outside(Vector2f(5, 5), square, ARRAY_SIZE(square)));
+    EXPECT_FALSE(Polygon_outside(Vector2f(0.1f, 9.9f), square, ARRAY_SIZE(square)));
+    EXPECT_TRUE(Polygon_outside(Vector2f(-1, 5), square, ARRAY_SIZE(square)));
+    EXPECT_TRUE(Polygon_outside(Vector2f(5, 11), square, ARRAY_SIZE(square)));
+    EXPECT_TRUE(Polygon_outside(Vector2f(20, 20), square, ARRAY_SIZE(square)));
+
+    EXPECT_FALSE(Polygon_outside(Vector2f(2, 8), ell, ARRAY_SIZE(ell)));
+    EXPECT_FALSE(Polygon_outside(Vector2f(8, 2), ell, ARRAY_SIZE(ell)));
+    EXPECT_TRUE(Polygon_outside(Vector2f(8, 8), ell, ARRAY_SIZE(ell)));
+}
+
+TEST(PolygonTest, OutsideFloatMatchesClosed)
+{
+    // the float version closes the polygon implicitly, so it must
+    // agree with the integer version given the closed vertex list
+    const Vector2l closed[] = {
+        Vector2l(0, 0), Vector2l(10, 0), Vector2l(10, 5), Vector2l(5, 5),
+        Vector2l(5, 10), Vector2l(0, 10), Vector2l(0, 0)
+    };
+    for (int32_t x = -2; x <= 12; x++) {
+        for (int32_t y = -2; y <= 12; y++) {
+            // keep clear of the edges, where the two may round differently
+            const Vector2f pf(x + 0.25f, y + 0.25f);
+            const Vector2l pl(x * 4 + 1, y * 4 + 1);
+            Vector2l scaled[ARRAY_SIZE(closed)];
+            for (uint8_t i = 0; i < ARRAY_SIZE(closed); i++) {
+                scaled[i] = Vector2l(closed[i].x * 4, closed[i].y * 4);
+            }
+            EXPECT_EQ(Polygon_outside(pl, scaled, ARRAY_SIZE(scaled)),
+                      Polygon_outside(pf, ell, ARRAY_SIZE(ell)))
+                << "at " << pf.x << "," << pf.y;
+        }
+    }
+}
+
+TEST(PolygonTest, Distance)
+{
+    const unsigned n = ARRAY_SIZE(square);
+
+    // inside, nearest an edge
+    EXPECT_FLOAT_EQ(2.0f, Polygon_distance(Vector2f(2, 5), square, n));
+    EXPECT_FLOAT_EQ(5.0f, Polygon_distance(Vector2f(5, 5), square, n));
+
+    // outside, nearest an edge
+    EXPECT_FLOAT_EQ(3.0f, Polygon_distance(Vector2f(5, -3), square, n));
+
+    // outside, nearest a vertex
+    EXPECT_FLOAT_EQ(5.0f, Polygon_distance(Vector2f(13, 14), square, n));
+
+    // on the closing edge from the last vertex back to the first
+    EXPECT_FLOAT_EQ(0.0f, Polygon_distance(Vector2f(0, 5), square, n));
+
+    // in the notch of the concave polygon, between the two inner edges
+    EXPECT_FLOAT_EQ(1.0f, Polygon_distance(Vector2f(6, 6), ell, ARRAY_SIZE(ell)));
+
+    // outside the concave polygon, nearest the corner of the notch
+    EXPECT_FLOAT_EQ(sqrtf(2.0f), Polygon_distance(Vector2f(11, 6), ell, ARRAY_SIZE(ell)));
+}
+
+TEST(PolygonTest, DistanceDegenerateEdge)
+{
+    // a repeated vertex gives a zero length edge, which must not
+    // divide by zero
+    const Vector2f v[] = {
+        Vector2f(0, 0), Vector2f(0, 0), Vector2f(10, 0), Vector2f(0, 10)
+    };
+    EXPECT_FLOAT_EQ(1.0f, Polygon_distance(Vector2f(-1, 0), v, ARRAY_SIZE(v)));
+}
+
+AP_GTEST_MAIN()
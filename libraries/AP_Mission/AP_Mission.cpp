@@ -22,6 +22,13 @@ const AP_Param::GroupInfo AP_Mission::var_info[] = {
     // @Values: 0:Resume Mission, 1:Restart Mission
     AP_GROUPINFO("RESTART",  1, AP_Mission, _restart, AP_MISSION_RESTART_DEFAULT),
 
+    // @Param: CACHE
+    // @DisplayName: Mission command cache
+    // @Description: Keeps a RAM copy of decoded mission commands so that looking ahead through the mission does not re-read storage. Uses 19 bytes of RAM per mission command. Takes effect after a reboot
+    // @Values: 0:Disabled, 1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("CACHE",  2, AP_Mission, _cache_enabled, AP_MISSION_CACHE_DEFAULT),
+
     AP_GROUPEND
 };
 
@@ -46,6 +53,9 @@ void AP_Mission::init()
         AP_HAL::panic("AP_Mission Content must be 12 bytes");
     }
 
+    // allocate the decoded command cache
+    cache_init();
+
     _last_change_time_ms = AP_HAL::millis();
 }
 
@@ -232,6 +242,19 @@ bool AP_Mission::add_cmd(Mission_Command& cmd)
     return ret;
 }
 
+/// set_num_commands - sets the number of commands in the mission, used after commands have been written
+///     directly to storage with write_cmd_to_storage so the total is only saved once
+///     returns false if count is more than can be stored
+bool AP_Mission::set_num_commands(uint16_t count)
+{
+    if (count > num_commands_max()) {
+        return false;
+    }
+    _cmd_total.set_and_save(count);
+    _last_change_time_ms = AP_HAL::millis();
+    return true;
+}
+
 /// replace_cmd - replaces the command at position 'index' in the command list with the provided cmd
 ///     replacing the current active command will have no effect until the command is restarted
 ///     returns true if successfully replaced, false on failure
@@ -269,6 +292,9 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
             // if found a "navigation" command then return it
             if (is_nav_cmd(cmd)) {
                 return true;
+            }else if (cmd.index == cmd_index) {
+                // no jump was followed so skip straight past the run of "do" commands
+                cmd_index = cache_next_nav_or_jump(cmd_index+1);
             }else{
                 // move on in list
                 cmd_index++;
@@ -418,7 +444,7 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         cmd.id = MAV_CMD_NAV_WAYPOINT;
         cmd.p1 = 0;
         cmd.content.location = _ahrs.get_home();
-    }else{
+    }else if (!cache_read(index, cmd)) {
         // Find out proper location in memory by using the start_byte position + the index
         // we can load a command, we don't process it yet
         // read WP position
@@ -430,6 +456,9 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
 
         // set command's index to it's position in eeprom
         cmd.index = index;
+
+        // keep the decoded command for next time
+        cache_store(index, cmd);
     }
 
     // return success
@@ -449,9 +478,20 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     // calculate where in storage the command should be placed
     uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
 
-    _storage.write_byte(pos_in_storage, cmd.id);
-    _storage.write_uint16(pos_in_storage+1, cmd.p1);
-    _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
+    // pack the command so it is written to storage in a single block
+    uint8_t packed[AP_MISSION_EEPROM_COMMAND_SIZE];
+    packed[0] = cmd.id;
+    memcpy(&packed[1], &cmd.p1, sizeof(cmd.p1));
+    memcpy(&packed[3], cmd.content.bytes, 12);
+    _storage.write_block(pos_in_storage, packed, sizeof(packed));
+
+    // write through to the cache.  Command #0 is home which is always read from ahrs
+    if (index != 0) {
+        Mission_Command cached = cmd;
+        cached.index = index;
+        cache_store(index, cached);
+    }
+    _cache_next_nav_total = AP_MISSION_CMD_INDEX_NONE;
 
     // remember when the mission last changed
     _last_change_time_ms = AP_HAL::millis();
@@ -1418,6 +1458,90 @@ void AP_Mission::check_eeprom_version()
     }
 }
 
+///
+/// decoded command cache methods
+///
+
+/// cache_init - allocates the decoded command cache if enabled with MIS_CACHE
+void AP_Mission::cache_init()
+{
+    if (_cache_enabled == 0 || _cache_cmds != NULL) {
+        return;
+    }
+
+    uint16_t size = num_commands_max();
+    _cache_cmds = (Mission_Command *)calloc(size, sizeof(Mission_Command));
+    _cache_valid = (uint8_t *)calloc((size+7)/8, 1);
+    _cache_next_nav = (uint16_t *)calloc(size+1, sizeof(uint16_t));
+    if (_cache_cmds == NULL || _cache_valid == NULL || _cache_next_nav == NULL) {
+        // not enough memory, run without the cache
+        free(_cache_cmds);
+        free(_cache_valid);
+        free(_cache_next_nav);
+        _cache_cmds = NULL;
+        _cache_valid = NULL;
+        _cache_next_nav = NULL;
+        return;
+    }
+    _cache_size = size;
+    _cache_next_nav_total = AP_MISSION_CMD_INDEX_NONE;
+}
+
+/// cache_read - fills in cmd from the cache, returns false if the command is not cached
+bool AP_Mission::cache_read(uint16_t index, Mission_Command& cmd) const
+{
+    if (index >= _cache_size || (_cache_valid[index/8] & (1U<<(index%8))) == 0) {
+        return false;
+    }
+    cmd = _cache_cmds[index];
+    return true;
+}
+
+/// cache_store - stores a decoded command in the cache
+void AP_Mission::cache_store(uint16_t index, const Mission_Command& cmd) const
+{
+    if (index >= _cache_size) {
+        return;
+    }
+    _cache_cmds[index] = cmd;
+    _cache_valid[index/8] |= (1U<<(index%8));
+}
+
+/// cache_next_nav_or_jump - returns the index of the first "navigation" or do-jump command at or after index
+///     returns _cmd_total if there is none, or index if the cache is not available
+uint16_t AP_Mission::cache_next_nav_or_jump(uint16_t index) const
+{
+    uint16_t total = _cmd_total;
+    if (_cache_size == 0 || total > _cache_size) {
+        return index;
+    }
+    if (index >= total) {
+        return total;
+    }
+
+    // rebuild the table if the mission has changed since it was last built
+    if (_cache_next_nav_total != total) {
+        _cache_next_nav[total] = total;
+        for (uint16_t i=total; i > AP_MISSION_FIRST_REAL_COMMAND; i--) {
+            Mission_Command cmd;
+            if (!read_cmd_from_storage(i-1, cmd)) {
+                return index;
+            }
+            if (is_nav_cmd(cmd) || cmd.id == MAV_CMD_DO_JUMP) {
+                _cache_next_nav[i-1] = i-1;
+            } else {
+                _cache_next_nav[i-1] = _cache_next_nav[i];
+            }
+        }
+        _cache_next_nav_total = total;
+    }
+
+    if (index < AP_MISSION_FIRST_REAL_COMMAND) {
+        return index;
+    }
+    return _cache_next_nav[index];
+}
+
 /*
   return total number of commands that can fit in storage space
  */
@@ -40,6 +40,15 @@
 
 #define AP_MISSION_RESTART_DEFAULT          0       // resume the mission from the last command run by default
 
+// decoded command cache is enabled by default on boards with plenty of RAM
+#ifndef AP_MISSION_CACHE_DEFAULT
+ #if HAL_CPU_CLASS >= HAL_CPU_CLASS_1000
+  #define AP_MISSION_CACHE_DEFAULT          1
+ #else
+  #define AP_MISSION_CACHE_DEFAULT          0
+ #endif
+#endif
+
 /// @class    AP_Mission
 /// @brief    Object managing Mission
 class AP_Mission {
@@ -240,7 +249,12 @@ public:
         _mission_complete_fn(mission_complete_fn),
         _prev_nav_cmd_index(AP_MISSION_CMD_INDEX_NONE),
         _prev_nav_cmd_wp_index(AP_MISSION_CMD_INDEX_NONE),
-        _last_change_time_ms(0)
+        _last_change_time_ms(0),
+        _cache_cmds(NULL),
+        _cache_valid(NULL),
+        _cache_next_nav(NULL),
+        _cache_next_nav_total(AP_MISSION_CMD_INDEX_NONE),
+        _cache_size(0)
     {
         // load parameter defaults
         AP_Param::setup_object_defaults(this, var_info);
@@ -308,6 +322,11 @@ public:
     ///     cmd.index is updated with it's new position in the mission
     bool add_cmd(Mission_Command& cmd);
 
+    /// set_num_commands - sets the number of commands in the mission, used after commands have been written
+    ///     directly to storage with write_cmd_to_storage so the total is only saved once
+    ///     returns false if count is more than can be stored
+    bool set_num_commands(uint16_t count);
+
     /// replace_cmd - replaces the command at position 'index' in the command list with the provided cmd
     ///     replacing the current active command will have no effect until the command is restarted
     ///     returns true if successfully replaced, false on failure
@@ -440,12 +459,29 @@ private:
     /// command list will be cleared if they do not match
     void check_eeprom_version();
 
+    ///
+    /// decoded command cache methods
+    ///
+    /// cache_init - allocates the decoded command cache if enabled with MIS_CACHE
+    void cache_init();
+
+    /// cache_read - fills in cmd from the cache, returns false if the command is not cached
+    bool cache_read(uint16_t index, Mission_Command& cmd) const;
+
+    /// cache_store - stores a decoded command in the cache
+    void cache_store(uint16_t index, const Mission_Command& cmd) const;
+
+    /// cache_next_nav_or_jump - returns the index of the first "navigation" or do-jump command at or after index
+    ///     returns _cmd_total if there is none, or index if the cache is not available
+    uint16_t cache_next_nav_or_jump(uint16_t index) const;
+
     // references to external libraries
     const AP_AHRS&   _ahrs;      // used only for home position
 
     // parameters
     AP_Int16                _cmd_total;  // total number of commands in the mission
     AP_Int8                 _restart;   // controls mission starting point when entering Auto mode (either restart from beginning of mission or resume from last command run)
+    AP_Int8                 _cache_enabled; // enables the RAM cache of decoded commands
 
     // pointer to main program functions
     mission_cmd_fn_t        _cmd_start_fn;  // pointer to function which will be called when a new command is started
@@ -466,6 +502,14 @@ private:
 
     // last time that mission changed
     uint32_t _last_change_time_ms;
+
+    // decoded command cache.  Entries are filled in as commands are read from storage and
+    // written through when commands are written, so the cache never holds stale commands
+    mutable Mission_Command *_cache_cmds;       // decoded commands indexed by their position in the command list
+    mutable uint8_t         *_cache_valid;      // bitmask of cache entries that hold a decoded command
+    mutable uint16_t        *_cache_next_nav;   // for each index, the first "navigation" or do-jump command at or after it
+    mutable uint16_t        _cache_next_nav_total; // _cmd_total when _cache_next_nav was built, AP_MISSION_CMD_INDEX_NONE if it needs rebuilding
+    uint16_t                _cache_size;        // number of entries in the cache, zero if the cache is disabled
 };
 
 #endif
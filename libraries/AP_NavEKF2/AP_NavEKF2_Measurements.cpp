@@ -221,6 +221,43 @@ void NavEKF2_core::readMagData()
 *                Inertial Measurements                  *
 ********************************************************/
 
+/*
+ * Time the gyro measured the newest sample in its delta angle, when the
+ * driver timestamps its samples, so the stored IMU data is not delayed by
+ * the time it spent in the driver. Only the IMU data is backdated;
+ * imuSampleTime_ms stays on the millis() clock that the sensor receive
+ * times are compared against. Falls back to imuSampleTime_ms if the
+ * timestamp is missing, stale or would move the IMU data time backwards.
+ */
+uint32_t NavEKF2_core::readIMUSampleTime(uint8_t ins_index) const
+{
+    const AP_InertialSensor &ins = _ahrs->get_ins();
+    const uint64_t sample_us = ins.get_gyro_sample_us(ins_index);
+    if (sample_us == 0) {
+        return imuSampleTime_ms;
+    }
+    const uint32_t sample_ms = sample_us / 1000;
+    if ((int32_t)(imuSampleTime_ms - sample_ms) < 0 ||
+        imuSampleTime_ms - sample_ms > 20 ||
+        (int32_t)(sample_ms - imuDataNew.time_ms) < 0) {
+        return imuSampleTime_ms;
+    }
+    return sample_ms;
+}
+
+/*
+ * Time since the last GPS message was received, on the imuSampleTime_ms
+ * clock. The GPS driver may stamp a message after the IMU time was taken
+ * for this frame, so this is clamped rather than allowed to wrap.
+ */
+uint32_t NavEKF2_core::gpsReceiveAge_ms() const
+{
+    if ((int32_t)(imuSampleTime_ms - lastTimeGpsReceived_ms) < 0) {
+        return 0;
+    }
+    return imuSampleTime_ms - lastTimeGpsReceived_ms;
+}
+
 /*
  *  Read IMU delta angle and delta velocity measurements and downsample to 100Hz
  *  for storage in the data buffers used by the EKF. If the IMU data arrives at
@@ -235,9 +272,6 @@ void NavEKF2_core::readIMUData()
     // average IMU sampling rate
     dtIMUavg = ins.get_loop_delta_t();
 
-    // the imu sample time is used as a common time reference throughout the filter
-    imuSampleTime_ms = AP_HAL::millis();
-
     // use the nominated imu or primary if not available
     if (ins.use_accel(imu_index)) {
         readDeltaVelocity(imu_index, imuDataNew.delVel, imuDataNew.delVelDT);
@@ -246,15 +280,15 @@ void NavEKF2_core::readIMUData()
     }
 
     // Get delta angle data from primary gyro or primary if not available
-    if (ins.use_gyro(imu_index)) {
-        readDeltaAngle(imu_index, imuDataNew.delAng);
-    } else {
-        readDeltaAngle(ins.get_primary_gyro(), imuDataNew.delAng);
-    }
+    uint8_t gyro_index = ins.use_gyro(imu_index) ? imu_index : ins.get_primary_gyro();
+    readDeltaAngle(gyro_index, imuDataNew.delAng);
+
+    // the imu sample time is used as a common time reference throughout the filter
+    imuSampleTime_ms = AP_HAL::millis();
     imuDataNew.delAngDT = MAX(ins.get_delta_angle_dt(imu_index),1.0e-4f);
 
-    // Get current time stamp
-    imuDataNew.time_ms = imuSampleTime_ms;
+    // Time stamp the data with when the gyro measured it
+    imuDataNew.time_ms = readIMUSampleTime(gyro_index);
 
     // remove gyro scale factor errors
     imuDataNew.delAng.x = imuDataNew.delAng.x * stateStruct.gyro_scale.x;
@@ -294,7 +328,7 @@ void NavEKF2_core::readIMUData()
         // convert the accumulated quaternion to an equivalent delta angle
         imuQuatDownSampleNew.to_axis_angle(imuDataDownSampledNew.delAng);
         // Time stamp the data
-        imuDataDownSampledNew.time_ms = imuSampleTime_ms;
+        imuDataDownSampledNew.time_ms = imuDataNew.time_ms;
         // Write data to the FIFO IMU buffer
         storedIMU.push_youngest_element(imuDataDownSampledNew);
         // zero the accumulated IMU data and quaternion
@@ -452,7 +486,7 @@ void NavEKF2_core::readGpsData()
     uint16_t gpsFailTimeout_ms = optFlowBackupAvailable ? frontend->gpsFailTimeWithFlow_ms : gpsRetryTimeout_ms;
 
     // If we haven't received GPS data for a while and we are using it for aiding, then declare the position and velocity data as being timed out
-    if (imuSampleTime_ms - lastTimeGpsReceived_ms > gpsFailTimeout_ms) {
+    if (gpsReceiveAge_ms() > gpsFailTimeout_ms) {
 
         // Let other processes know that GPS is not available and that a timeout has occurred
         posTimeout = true;
@@ -476,6 +476,10 @@ private:
     // helper functions for readIMUData
     bool readDeltaVelocity(uint8_t ins_index, Vector3f &dVel, float &dVel_dt);
     bool readDeltaAngle(uint8_t ins_index, Vector3f &dAng);
+    uint32_t readIMUSampleTime(uint8_t ins_index) const;
+
+    // time since the last GPS message was received, never negative
+    uint32_t gpsReceiveAge_ms() const;
 
     // update IMU delta angle and delta velocity measurements
     void readIMUData();
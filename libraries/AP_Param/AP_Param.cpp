@@ -69,6 +69,7 @@ uint16_t AP_Param::_num_vars;
 
 // cached parameter count
 uint16_t AP_Param::_parameter_count;
+uint16_t AP_Param::_tree_generation;
 
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
@@ -829,6 +830,7 @@ bool AP_Param::save(bool force_save)
     if (phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
         // clear cached parameter count
         _parameter_count = 0;
+        _tree_generation++;
     }
     
     char name[AP_MAX_NAME_SIZE+1];
@@ -1085,6 +1087,9 @@ bool AP_Param::load_all(void)
     load_defaults_file(hal.util->get_custom_defaults_file());
 #endif
 
+    // loaded values may enable or disable parameter groups
+    _tree_generation++;
+
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
         // note that this is an || not an && for robustness
@@ -315,6 +315,10 @@ public:
 
     // count of parameters in tree
     static uint16_t count_parameters(void);
+
+    // incremented whenever the set of parameters in the tree may
+    // have changed, for users which cache the tree
+    static uint16_t tree_generation(void) { return _tree_generation; }
     
 private:
     /// EEPROM header
@@ -443,6 +447,7 @@ private:
     static StorageAccess        _storage;
     static uint16_t             _num_vars;
     static uint16_t             _parameter_count;
+    static uint16_t             _tree_generation;
     static const struct Info *  _var_info;
 
     /*
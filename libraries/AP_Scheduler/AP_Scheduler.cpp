@@ -82,6 +82,15 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks)
     _last_run = new uint16_t[_num_tasks];
     memset(_last_run, 0, sizeof(_last_run[0]) * _num_tasks);
     _tick_counter = 0;
+#if AP_SCHEDULER_TASK_PERF
+    _task_perf = NULL;
+    if (hal.util->perf_trace_enabled()) {
+        _task_perf = new AP_HAL::Util::perf_counter_t[_num_tasks];
+        for (uint8_t i=0; i<_num_tasks; i++) {
+            _task_perf[i] = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, _tasks[i].name);
+        }
+    }
+#endif
 }
 
 // one tick has passed
@@ -125,7 +134,17 @@ void AP_Scheduler::run(uint16_t time_available)
                 // run it
                 _task_time_started = now;
                 current_task = i;
+#if AP_SCHEDULER_TASK_PERF
+                if (_task_perf != NULL) {
+                    hal.util->perf_begin(_task_perf[i]);
+                }
+#endif
                 _tasks[i].function();
+#if AP_SCHEDULER_TASK_PERF
+                if (_task_perf != NULL) {
+                    hal.util->perf_end(_task_perf[i]);
+                }
+#endif
                 current_task = -1;
 
                 // record the tick counter when we ran. This drives
@@ -27,6 +27,12 @@
 
 #define AP_SCHEDULER_NAME_INITIALIZER(_name) .name = #_name,
 
+// time each task with a HAL perf counter. The counters are only
+// allocated when the HAL reports that perf counters are being traced
+#ifndef AP_SCHEDULER_TASK_PERF
+#define AP_SCHEDULER_TASK_PERF (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 /*
   useful macro for creating scheduler task table
  */
@@ -117,6 +123,11 @@ private:
     // tick counter at the time we last ran each task
     uint16_t *_last_run;
 
+#if AP_SCHEDULER_TASK_PERF
+    // perf counter for each task, NULL when not tracing
+    AP_HAL::Util::perf_counter_t *_task_perf;
+#endif
+
     // number of microseconds allowed for the current task
     uint32_t _task_time_allowed;
 
@@ -0,0 +1,431 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+  DataFlash log compression, see DFCompress.h for the format
+ */
+
+#include "DFCompress.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DFCOMPRESS_NO_HISTORY 0xFFFF
+
+DFCompress_Model::DFCompress_Model() :
+    _history(NULL),
+    _history_used(0)
+{
+    reset();
+}
+
+DFCompress_Model::~DFCompress_Model()
+{
+    free(_history);
+}
+
+bool DFCompress_Model::init()
+{
+    if (_history == NULL) {
+        _history = (uint8_t *)malloc(DFCOMPRESS_HISTORY_SIZE);
+    }
+    return _history != NULL;
+}
+
+void DFCompress_Model::reset()
+{
+    memset(_length, 0, sizeof(_length));
+    _length[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+    reset_history();
+}
+
+void DFCompress_Model::reset_history()
+{
+    for (uint16_t i=0; i<256; i++) {
+        _history_ofs[i] = DFCOMPRESS_NO_HISTORY;
+    }
+    _history_used = 0;
+}
+
+/*
+  XOR a payload with the previous payload of the same type.  The
+  history for a type is allocated the first time the type is seen
+  after a reset.  Types that do not fit in the history are passed
+  through unchanged.  The encoder and decoder see the same sequence of
+  messages so they allocate identically
+ */
+void DFCompress_Model::delta(uint8_t msgid, uint8_t *payload, uint8_t len, bool raw_out)
+{
+    if (_history == NULL) {
+        return;
+    }
+    if (_history_ofs[msgid] == DFCOMPRESS_NO_HISTORY) {
+        if (_history_used + len > DFCOMPRESS_HISTORY_SIZE) {
+            return;
+        }
+        _history_ofs[msgid] = _history_used;
+        memset(&_history[_history_used], 0, len);
+        _history_used += len;
+    }
+    uint8_t *h = &_history[_history_ofs[msgid]];
+    for (uint8_t i=0; i<len; i++) {
+        const uint8_t x = payload[i] ^ h[i];
+        h[i] = raw_out ? x : payload[i];
+        payload[i] = x;
+    }
+}
+
+void DFCompress_Model::learn_format(const uint8_t *msg)
+{
+    const struct log_Format *f = (const struct log_Format *)msg;
+    if (f->type != LOG_FORMAT_MSG && f->length >= 3) {
+        _length[f->type] = f->length;
+    }
+}
+
+/*
+  the length table at the start of a key block lets a decoder pick up
+  the stream there without having seen the FMT messages before it
+ */
+uint16_t DFCompress_Model::store_lengths(uint8_t *buf) const
+{
+    uint16_t n = 1;
+    for (uint16_t i=0; i<256; i++) {
+        if (i != LOG_FORMAT_MSG && _length[i] != 0) {
+            buf[n++] = i;
+            buf[n++] = _length[i];
+        }
+    }
+    buf[0] = (n - 1) / 2;
+    return n;
+}
+
+uint16_t DFCompress_Model::load_lengths(const uint8_t *buf, uint16_t len)
+{
+    if (len < 1 || 1 + 2*(uint16_t)buf[0] > len) {
+        return 0;
+    }
+    const uint16_t n = 1 + 2*(uint16_t)buf[0];
+    for (uint16_t i=1; i<n; i+=2) {
+        if (buf[i] == LOG_FORMAT_MSG || buf[i+1] < 3) {
+            return 0;
+        }
+    }
+    reset();
+    for (uint16_t i=1; i<n; i+=2) {
+        _length[buf[i]] = buf[i+1];
+    }
+    return n;
+}
+
+uint16_t DFCompress_Model::fletcher16(const uint8_t *data, uint16_t len)
+{
+    uint16_t sum1 = 0xFF, sum2 = 0xFF;
+    while (len) {
+        // 20 bytes is the most that can be summed before the 16 bit sums overflow
+        uint16_t n = len > 20 ? 20 : len;
+        len -= n;
+        do {
+            sum2 += sum1 += *data++;
+        } while (--n);
+        sum1 = (sum1 & 0xFF) + (sum1 >> 8);
+        sum2 = (sum2 & 0xFF) + (sum2 >> 8);
+    }
+    sum1 = (sum1 & 0xFF) + (sum1 >> 8);
+    sum2 = (sum2 & 0xFF) + (sum2 >> 8);
+    return (sum2 << 8) | sum1;
+}
+
+void DFCompress_Model::set_header_check(DFCompress_BlockHeader &hdr)
+{
+    const uint16_t sum = fletcher16((const uint8_t *)&hdr, offsetof(DFCompress_BlockHeader, header_check));
+    hdr.header_check = (sum & 0xFF) ^ (sum >> 8);
+}
+
+bool DFCompress_Model::header_ok(const DFCompress_BlockHeader &hdr)
+{
+    if (hdr.magic != DFCOMPRESS_BLOCK_MAGIC ||
+        hdr.raw_len > DFCOMPRESS_BLOCK_SIZE ||
+        hdr.encoded_len > DFCOMPRESS_BLOCK_MAX_ENCODED) {
+        return false;
+    }
+    const uint16_t sum = fletcher16((const uint8_t *)&hdr, offsetof(DFCompress_BlockHeader, header_check));
+    return hdr.header_check == ((sum & 0xFF) ^ (sum >> 8));
+}
+
+
+DFCompress_Encoder::DFCompress_Encoder() :
+    _msg_have(0),
+    _raw(NULL),
+    _raw_len(0),
+    _raw_decoded_len(0),
+    _out(NULL),
+    _out_len(0),
+    _out_ofs(0),
+    _blocks_since_key(0),
+    _errors(0)
+{
+}
+
+DFCompress_Encoder::~DFCompress_Encoder()
+{
+    free(_raw);
+    free(_out);
+}
+
+bool DFCompress_Encoder::init()
+{
+    if (!_model.init()) {
+        return false;
+    }
+    if (_raw == NULL) {
+        _raw = (uint8_t *)malloc(DFCOMPRESS_BLOCK_SIZE);
+    }
+    if (_out == NULL) {
+        _out = (uint8_t *)malloc(sizeof(DFCompress_BlockHeader) + DFCOMPRESS_BLOCK_MAX_ENCODED);
+    }
+    return _raw != NULL && _out != NULL;
+}
+
+void DFCompress_Encoder::reset()
+{
+    _model.reset();
+    _msg_have = 0;
+    _raw_len = 0;
+    _raw_decoded_len = 0;
+    _out_len = 0;
+    _out_ofs = 0;
+    _blocks_since_key = 0;
+}
+
+/*
+  add the assembled message in _msg to the current block. Returns
+  false if the block is full and the previous block has not been taken
+ */
+bool DFCompress_Encoder::store_message()
+{
+    const uint8_t msgid = _msg[2];
+    const uint8_t len = _model.msg_length(msgid);
+
+    if (_raw_len + len - 2 > DFCOMPRESS_BLOCK_SIZE ||
+        _raw_decoded_len + len > DFCOMPRESS_BLOCK_MAX_DECODED) {
+        if (!finish_block()) {
+            return false;
+        }
+    }
+    if (_raw_len == 0 && _blocks_since_key == 0) {
+        _model.reset_history();
+        _raw_len = _model.store_lengths(_raw);
+    }
+
+    uint8_t *p = &_raw[_raw_len];
+    p[0] = msgid;
+    memcpy(&p[1], &_msg[3], len-3);
+    _model.delta(msgid, &p[1], len-3, false);
+    if (msgid == LOG_FORMAT_MSG) {
+        _model.learn_format(_msg);
+    }
+    _raw_len += len - 2;
+    _raw_decoded_len += len;
+    _msg_have = 0;
+    return true;
+}
+
+uint16_t DFCompress_Encoder::encode(const uint8_t *data, uint16_t len)
+{
+    if (_raw == NULL) {
+        return 0;
+    }
+
+    // a message completed by an earlier call may still be waiting for room
+    if (_msg_have >= 3 && _msg_have == _model.msg_length(_msg[2])) {
+        if (!store_message()) {
+            return 0;
+        }
+    }
+
+    uint16_t n = 0;
+    while (n < len) {
+        if (_msg_have < 3) {
+            // assemble and check the message header a byte at a time
+            const uint8_t b = data[n++];
+            if ((_msg_have == 0 && b != HEAD_BYTE1) ||
+                (_msg_have == 1 && b != HEAD_BYTE2)) {
+                _errors += _msg_have + 1;
+                _msg_have = 0;
+                continue;
+            }
+            _msg[_msg_have++] = b;
+            if (_msg_have == 3 && _model.msg_length(b) < 3) {
+                // no FMT seen for this type so its length is unknown
+                _errors += 3;
+                _msg_have = 0;
+            }
+            continue;
+        }
+
+        const uint8_t msg_len = _model.msg_length(_msg[2]);
+        uint16_t take = msg_len - _msg_have;
+        if (take > len - n) {
+            take = len - n;
+        }
+        memcpy(&_msg[_msg_have], &data[n], take);
+        _msg_have += take;
+        n += take;
+        if (_msg_have == msg_len && !store_message()) {
+            break;
+        }
+    }
+    return n;
+}
+
+/*
+  zero-byte pack the current block into the output buffer
+ */
+bool DFCompress_Encoder::finish_block()
+{
+    if (_out_len != 0) {
+        // previous block not yet written
+        return false;
+    }
+    if (_raw_len == 0) {
+        return true;
+    }
+
+    uint8_t *encoded = &_out[sizeof(DFCompress_BlockHeader)];
+    uint16_t elen = 0;
+    for (uint16_t i=0; i<_raw_len; i+=8) {
+        const uint16_t n = (_raw_len - i) < 8 ? (_raw_len - i) : 8;
+        uint8_t &mask = encoded[elen++];
+        mask = 0;
+        for (uint8_t j=0; j<n; j++) {
+            const uint8_t b = _raw[i+j];
+            if (b != 0) {
+                mask |= (1U<<j);
+                encoded[elen++] = b;
+            }
+        }
+    }
+
+    DFCompress_BlockHeader hdr;
+    hdr.magic = DFCOMPRESS_BLOCK_MAGIC;
+    hdr.raw_len = _raw_len;
+    hdr.encoded_len = elen;
+    hdr.flags = (_blocks_since_key == 0) ? DFCOMPRESS_FLAG_KEY : 0;
+    hdr.checksum = DFCompress_Model::fletcher16(encoded, elen);
+    DFCompress_Model::set_header_check(hdr);
+    memcpy(_out, &hdr, sizeof(hdr));
+
+    _out_len = sizeof(hdr) + elen;
+    _out_ofs = 0;
+    _raw_len = 0;
+    _raw_decoded_len = 0;
+    _blocks_since_key = (_blocks_since_key + 1) % DFCOMPRESS_KEY_INTERVAL;
+    return true;
+}
+
+bool DFCompress_Encoder::flush()
+{
+    // a message completed by encode() may still be waiting for room
+    if (_msg_have >= 3 && _msg_have == _model.msg_length(_msg[2])) {
+        if (!store_message()) {
+            return false;
+        }
+    }
+    return finish_block();
+}
+
+const uint8_t *DFCompress_Encoder::pending(uint16_t &len) const
+{
+    if (_out_len == 0) {
+        len = 0;
+        return NULL;
+    }
+    len = _out_len - _out_ofs;
+    return &_out[_out_ofs];
+}
+
+void DFCompress_Encoder::consumed(uint16_t len)
+{
+    _out_ofs += len;
+    if (_out_ofs >= _out_len) {
+        _out_len = 0;
+        _out_ofs = 0;
+    }
+}
+
+
+bool DFCompress_Decoder::decode_block(const DFCompress_BlockHeader &hdr, const uint8_t *encoded,
+                                      uint8_t *out, uint16_t &out_len)
+{
+    out_len = 0;
+
+    if (!DFCompress_Model::header_ok(hdr) ||
+        DFCompress_Model::fletcher16(encoded, hdr.encoded_len) != hdr.checksum) {
+        _in_sync = false;
+        return false;
+    }
+    const bool key = (hdr.flags & DFCOMPRESS_FLAG_KEY) != 0;
+    if (!key && !_in_sync) {
+        // delta history is unknown until the next key block
+        return false;
+    }
+
+    // undo the zero-byte packing
+    uint16_t epos = 0;
+    for (uint16_t i=0; i<hdr.raw_len; i+=8) {
+        if (epos >= hdr.encoded_len) {
+            _in_sync = false;
+            return false;
+        }
+        const uint8_t mask = encoded[epos++];
+        const uint16_t n = (hdr.raw_len - i) < 8 ? (hdr.raw_len - i) : 8;
+        for (uint8_t j=0; j<n; j++) {
+            if (mask & (1U<<j)) {
+                if (epos >= hdr.encoded_len) {
+                    _in_sync = false;
+                    return false;
+                }
+                _raw[i+j] = encoded[epos++];
+            } else {
+                _raw[i+j] = 0;
+            }
+        }
+    }
+
+    // a key block starts with the message lengths and an empty history
+    uint16_t pos = 0;
+    if (key) {
+        pos = _model.load_lengths(_raw, hdr.raw_len);
+        if (pos == 0) {
+            _in_sync = false;
+            return false;
+        }
+        _model.reset_history();
+        _in_sync = true;
+    }
+
+    // undo the delta stage
+    while (pos < hdr.raw_len) {
+        const uint8_t msgid = _raw[pos];
+        const uint8_t len = _model.msg_length(msgid);
+        if (len < 3 ||
+            pos + len - 2 > hdr.raw_len ||
+            out_len + len > DFCOMPRESS_BLOCK_MAX_DECODED) {
+            _in_sync = false;
+            return false;
+        }
+        uint8_t *msg = &out[out_len];
+        msg[0] = HEAD_BYTE1;
+        msg[1] = HEAD_BYTE2;
+        msg[2] = msgid;
+        memcpy(&msg[3], &_raw[pos+1], len-3);
+        _model.delta(msgid, &msg[3], len-3, true);
+        if (msgid == LOG_FORMAT_MSG) {
+            _model.learn_format(msg);
+        }
+        pos += len - 2;
+        out_len += len;
+    }
+    return true;
+}
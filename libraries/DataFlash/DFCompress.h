@@ -0,0 +1,204 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+  DataFlash log compression
+
+  A compressed log starts with DFCOMPRESS_FILE_MAGIC followed by a
+  sequence of blocks, each a DFCompress_BlockHeader and its encoded
+  data.  Compression is done in two stages:
+
+  - delta stage: each message is reduced to its msgid followed by its
+    payload XORed with the payload of the previous message of the same
+    type.  The HEAD_BYTE1/HEAD_BYTE2 marker is dropped.  Timestamps and
+    slowly changing values leave mostly zero bytes.  Message lengths
+    are learnt from the FMT messages in the log itself, so the encoder
+    and decoder need no knowledge of the vehicle's log structures.
+
+  - block stage: up to DFCOMPRESS_BLOCK_SIZE bytes of delta stage output
+    are zero-byte packed: every group of 8 bytes becomes a mask byte
+    with a bit set for each non-zero byte, followed by those bytes.
+
+  Key blocks, every DFCOMPRESS_KEY_INTERVAL blocks, reset the delta
+  history and start with a table of the message lengths learnt so far:
+  a count byte followed by a (msgid, length) pair per known type.  A
+  decoder can start at any key block, so a damaged block only loses
+  data up to the next key block.  Each block header carries its own
+  check byte so a reader can find the next block after damage by
+  scanning for a header that passes
+  DFCompress_Model::header_ok().
+
+  This file has no HAL dependencies so it can be used by host tools.
+ */
+
+#ifndef DFCOMPRESS_H
+#define DFCOMPRESS_H
+
+#include <AP_Common/AP_Common.h>
+#include <stdint.h>
+#include "LogStructure.h"
+
+#define DFCOMPRESS_FILE_MAGIC       "DFZ2"  // first four bytes of a compressed log
+#define DFCOMPRESS_FILE_MAGIC_LEN   4
+#define DFCOMPRESS_BLOCK_MAGIC      0x5A44  // "DZ"
+#define DFCOMPRESS_BLOCK_SIZE       4096    // maximum delta stage bytes per block
+#define DFCOMPRESS_BLOCK_MAX_ENCODED (DFCOMPRESS_BLOCK_SIZE + (DFCOMPRESS_BLOCK_SIZE+7)/8)
+#define DFCOMPRESS_BLOCK_MAX_DECODED (2*DFCOMPRESS_BLOCK_SIZE) // a delta coded message is at least half its raw size
+#define DFCOMPRESS_HISTORY_SIZE     6144    // bytes of previous messages kept for delta coding
+#define DFCOMPRESS_KEY_INTERVAL     16      // delta history is reset every this many blocks
+#define DFCOMPRESS_FLAG_KEY         0x01    // block starts with a length table and an empty delta history
+#define DFCOMPRESS_LENGTHS_MAX      (1+2*255) // largest length table in a key block
+
+struct PACKED DFCompress_BlockHeader {
+    uint16_t magic;
+    uint16_t raw_len;       // length of the delta stage data
+    uint16_t encoded_len;   // length of the encoded data following this header
+    uint8_t  flags;
+    uint8_t  header_check;  // folded fletcher16 of the preceding header bytes
+    uint16_t checksum;      // fletcher16 of the encoded data
+};
+
+/*
+  state shared by the encoder and decoder: message lengths learnt from
+  FMT messages and the previous payload of each message type
+ */
+class DFCompress_Model
+{
+public:
+    DFCompress_Model();
+    ~DFCompress_Model();
+
+    // allocate the delta history. Returns false if out of memory
+    bool init();
+
+    // forget message lengths and delta history, for a new log
+    void reset();
+
+    // forget delta history, at the start of a key block
+    void reset_history();
+
+    // length of messages of type msgid including the header, 0 if unknown
+    uint8_t msg_length(uint8_t msgid) const { return _length[msgid]; }
+
+    // XOR payload with the history for msgid, then update the history
+    // with the raw payload.  raw_out selects which buffer holds the raw
+    // payload afterwards: false when encoding, true when decoding
+    void delta(uint8_t msgid, uint8_t *payload, uint8_t len, bool raw_out);
+
+    // learn the message length from a decoded FMT message
+    void learn_format(const uint8_t *msg);
+
+    // write the known message lengths for a key block, returning the
+    // number of bytes used, at most DFCOMPRESS_LENGTHS_MAX
+    uint16_t store_lengths(uint8_t *buf) const;
+
+    // replace the known message lengths with a table written by
+    // store_lengths, returning the number of bytes used or 0 if damaged
+    uint16_t load_lengths(const uint8_t *buf, uint16_t len);
+
+    static uint16_t fletcher16(const uint8_t *data, uint16_t len);
+
+    // fill in the header_check field of a block header
+    static void set_header_check(DFCompress_BlockHeader &hdr);
+
+    // true if hdr has the block magic, a valid header_check and sane lengths
+    static bool header_ok(const DFCompress_BlockHeader &hdr);
+
+private:
+    uint8_t _length[256];
+    uint16_t _history_ofs[256];
+    uint8_t *_history;
+    uint16_t _history_used;
+};
+
+/*
+  streaming encoder.  Raw log bytes are pushed in with encode() and
+  complete blocks are taken out with pending()/consumed()
+ */
+class DFCompress_Encoder
+{
+public:
+    DFCompress_Encoder();
+    ~DFCompress_Encoder();
+
+    // allocate buffers. Returns false if out of memory
+    bool init();
+
+    // start a new log
+    void reset();
+
+    // consume raw log bytes, returning how many were consumed.  Stops
+    // early if a block is complete and the previous block has not yet
+    // been taken with consumed()
+    uint16_t encode(const uint8_t *data, uint16_t len);
+
+    // finish the current partial block, if any, including a message
+    // still waiting for room.  Returns false if the previous block has
+    // not yet been taken
+    bool flush();
+
+    // true if there is delta stage data not yet in a block
+    bool have_partial() const { return _raw_len != 0; }
+
+    // encoded output waiting to be written, NULL if none
+    const uint8_t *pending(uint16_t &len) const;
+
+    // mark len bytes of the pending output as written
+    void consumed(uint16_t len);
+
+    // number of bytes skipped because they were not part of a known message
+    uint32_t errors() const { return _errors; }
+
+private:
+    bool store_message();
+    bool finish_block();
+
+    DFCompress_Model _model;
+
+    // message being assembled from the raw stream
+    uint8_t _msg[256];
+    uint16_t _msg_have;
+
+    // delta stage data for the current block
+    uint8_t *_raw;
+    uint16_t _raw_len;
+    uint16_t _raw_decoded_len;  // raw log bytes represented by _raw
+
+    // finished block: header and encoded data
+    uint8_t *_out;
+    uint16_t _out_len;
+    uint16_t _out_ofs;
+
+    uint8_t _blocks_since_key;
+    uint32_t _errors;
+};
+
+/*
+  block decoder
+ */
+class DFCompress_Decoder
+{
+public:
+    DFCompress_Decoder() : _in_sync(true) {}
+
+    // allocate buffers. Returns false if out of memory
+    bool init() { return _model.init(); }
+
+    // start a new log
+    void reset() {
+        _model.reset();
+        _in_sync = true;
+    }
+
+    // decode one block into raw log bytes.  out must have room for
+    // DFCOMPRESS_BLOCK_MAX_DECODED bytes.  Returns false if the block is
+    // damaged, in which case messages up to the next key block are lost
+    bool decode_block(const DFCompress_BlockHeader &hdr, const uint8_t *encoded,
+                      uint8_t *out, uint16_t &out_len);
+
+private:
+    DFCompress_Model _model;
+    uint8_t _raw[DFCOMPRESS_BLOCK_SIZE];
+    bool _in_sync;
+};
+
+#endif // DFCOMPRESS_H
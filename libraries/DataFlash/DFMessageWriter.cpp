@@ -24,31 +24,166 @@ void DFMessageWriter_DFLogStart::reset()
     ap = AP_Param::first(&token, &type);
 }
 
+DFMessageWriter_DFLogStart::~DFMessageWriter_DFLogStart()
+{
+#if DATAFLASH_LOGSTART_CACHE
+    free(_cache);
+    free(_cache_params);
+#endif
+}
+
+#if DATAFLASH_LOGSTART_CACHE
+/*
+  serialise the formats and parameters into the cache. Returns false
+  if there is not enough memory, in which case they are written one
+  message at a time
+ */
+bool DFMessageWriter_DFLogStart::cache_build(void)
+{
+    free(_cache);
+    free(_cache_params);
+    _cache = nullptr;
+    _cache_params = nullptr;
+
+    AP_Param::ParamToken t;
+    enum ap_var_type ptype;
+    uint16_t num_params = 0;
+    for (AP_Param *vp = AP_Param::first(&t, &ptype); vp; vp = AP_Param::next_scalar(&t, &ptype)) {
+        num_params++;
+    }
+
+    const uint8_t num_formats = _dataflash_backend->num_types();
+    _cache_fmt_len = num_formats * sizeof(struct log_Format);
+    _cache_len = _cache_fmt_len + num_params * sizeof(struct log_Parameter);
+    _cache = (uint8_t *)malloc(_cache_len);
+    _cache_params = (struct cached_param *)calloc(num_params ? num_params : 1, sizeof(struct cached_param));
+    if (_cache == nullptr || _cache_params == nullptr) {
+        free(_cache);
+        free(_cache_params);
+        _cache = nullptr;
+        _cache_params = nullptr;
+        return false;
+    }
+
+    uint8_t *p = _cache;
+    for (uint8_t i=0; i<num_formats; i++) {
+        struct log_Format pkt;
+        _dataflash_backend->Log_Fill_Format(_dataflash_backend->structure(i), pkt);
+        memcpy(p, &pkt, sizeof(pkt));
+        p += sizeof(pkt);
+    }
+
+    uint16_t i = 0;
+    for (AP_Param *ap2 = AP_Param::first(&t, &ptype);
+         ap2 && i < num_params;
+         ap2 = AP_Param::next_scalar(&t, &ptype), i++) {
+        struct log_Parameter pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_PARAMETER_MSG),
+            time_us : 0,
+            name  : {},
+            value : 0
+        };
+        char name[16];
+        ap2->copy_name_token(t, &name[0], sizeof(name), true);
+        strncpy(pkt.name, name, sizeof(pkt.name));
+        memcpy(p, &pkt, sizeof(pkt));
+        p += sizeof(pkt);
+        _cache_params[i].ap = ap2;
+        _cache_params[i].type = ptype;
+    }
+    // in case the tree changed between the two passes
+    _cache_len = p - _cache;
+
+    _cache_generation = AP_Param::tree_generation();
+    return true;
+}
+
+/*
+  write whole records from the cache up to end, in blocks as large as
+  the backend will take. Returns false if we need to be called again
+ */
+bool DFMessageWriter_DFLogStart::cache_write(uint32_t end, uint16_t record_size)
+{
+    while (_cache_ofs < end) {
+        uint32_t n = MIN(end - _cache_ofs, (uint32_t)DATAFLASH_LOGSTART_MAX_BLOCK);
+        uint16_t space = _dataflash_backend->bufferspace_available();
+        if (_fmt_done) {
+            // other messages are flowing now, leave them some room
+            space /= 2;
+        }
+        n = MIN(n, space);
+        n -= n % record_size;
+        if (n == 0) {
+            return false;
+        }
+        if (_cache_ofs >= _cache_fmt_len) {
+            // parameter values may have changed since the cache was built
+            const uint64_t now = AP_HAL::micros64();
+            for (uint32_t ofs=_cache_ofs; ofs<_cache_ofs+n; ofs += sizeof(struct log_Parameter)) {
+                struct log_Parameter *pkt = (struct log_Parameter *)&_cache[ofs];
+                const struct cached_param &cp = _cache_params[(ofs - _cache_fmt_len) / sizeof(struct log_Parameter)];
+                pkt->time_us = now;
+                pkt->value = cp.ap->cast_to_float(cp.type);
+            }
+        }
+        if (!_dataflash_backend->WriteCriticalBlock(&_cache[_cache_ofs], n)) {
+            return false;
+        }
+        _cache_ofs += n;
+    }
+    return true;
+}
+#endif // DATAFLASH_LOGSTART_CACHE
+
 void DFMessageWriter_DFLogStart::process()
 {
     switch(stage) {
     case ls_blockwriter_stage_init:
+#if DATAFLASH_LOGSTART_CACHE
+        if (!_cache_valid || _cache_generation != AP_Param::tree_generation()) {
+            _cache_valid = cache_build();
+        }
+        _cache_ofs = 0;
+#endif
         stage = ls_blockwriter_stage_formats;
         // fall through
 
     case ls_blockwriter_stage_formats:
         // write log formats so the log is self-describing
-        while (next_format_to_send < _dataflash_backend->num_types()) {
-            if (!_dataflash_backend->Log_Write_Format(_dataflash_backend->structure(next_format_to_send))) {
+#if DATAFLASH_LOGSTART_CACHE
+        if (_cache_valid) {
+            if (!cache_write(_cache_fmt_len, sizeof(struct log_Format))) {
                 return; // call me again!
             }
-            next_format_to_send++;
+        } else
+#endif
+        {
+            while (next_format_to_send < _dataflash_backend->num_types()) {
+                if (!_dataflash_backend->Log_Write_Format(_dataflash_backend->structure(next_format_to_send))) {
+                    return; // call me again!
+                }
+                next_format_to_send++;
+            }
         }
         _fmt_done = true;
         stage = ls_blockwriter_stage_parms;
         // fall through
 
     case ls_blockwriter_stage_parms:
-        while (ap) {
-            if (!_dataflash_backend->Log_Write_Parameter(ap, token, type)) {
+#if DATAFLASH_LOGSTART_CACHE
+        if (_cache_valid) {
+            if (!cache_write(_cache_len, sizeof(struct log_Parameter))) {
                 return;
             }
-            ap = AP_Param::next_scalar(&token, &type);
+        } else
+#endif
+        {
+            while (ap) {
+                if (!_dataflash_backend->Log_Write_Parameter(ap, token, type)) {
+                    return;
+                }
+                ap = AP_Param::next_scalar(&token, &type);
+            }
         }
 
         stage = ls_blockwriter_stage_sysinfo;
@@ -5,6 +5,22 @@
 
 #include <AP_Mission/AP_Mission.h>
 
+/*
+  on boards with enough memory the formats and parameters written at
+  the start of each log are serialised once into a cache and written
+  in large blocks. The cache is rebuilt when the parameter tree
+  changes; parameter values are refreshed from the cached pointers as
+  each block is written
+ */
+#ifndef DATAFLASH_LOGSTART_CACHE
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_1000
+#define DATAFLASH_LOGSTART_CACHE 1
+#else
+#define DATAFLASH_LOGSTART_CACHE 0
+#endif
+#endif
+#define DATAFLASH_LOGSTART_MAX_BLOCK 4096
+
 class DFMessageWriter {
 public:
 
@@ -72,6 +88,7 @@ public:
         _writeentiremission()
         {
         }
+    ~DFMessageWriter_DFLogStart();
 
     virtual void set_dataflash_backend(class DataFlash_Backend *backend) {
         DFMessageWriter::set_dataflash_backend(backend);
@@ -108,6 +125,25 @@ private:
     uint16_t num_format_types;
     const struct LogStructure *_structures;
 
+#if DATAFLASH_LOGSTART_CACHE
+    struct cached_param {
+        const AP_Param *ap;
+        enum ap_var_type type;
+    };
+
+    // formats followed by parameters, as written to the log
+    uint8_t *_cache = nullptr;
+    uint32_t _cache_fmt_len = 0;
+    uint32_t _cache_len = 0;
+    uint32_t _cache_ofs = 0;
+    struct cached_param *_cache_params = nullptr;
+    uint16_t _cache_generation = 0;
+    bool _cache_valid = false;
+
+    bool cache_build(void);
+    bool cache_write(uint32_t end, uint16_t record_size);
+#endif
+
 
     DFMessageWriter_WriteSysInfo _writesysinfo;
     DFMessageWriter_WriteEntireMission _writeentiremission;
@@ -16,6 +16,55 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
     // @User: Standard
     AP_GROUPINFO("_FILE_BUFSIZE",  1, DataFlash_Class, _params.file_bufsize,       16),
 
+    // @Param: _FILE_COMPRESS
+    // @DisplayName: Compress DataFlash File Backend logs
+    // @Description: When enabled the DataFlash_File backend delta encodes and packs log data before writing it to the SD card.  Compressed logs must be expanded with Tools/LogCompress before they can be read by tools other than Replay, including logs downloaded over MAVLink.  Takes effect after a reboot.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_COMPRESS", 2, DataFlash_Class, _params.file_compress,      0),
+
+    // @Param: _FILE_RATEMAX
+    // @DisplayName: Maximum logging rate per message type for the File backend
+    // @Description: Each type of log message in the classes selected by LOG_FILE_RATECLS sent to the DataFlash_File backend is decimated to at most this rate.  Messages of the same type written in the same millisecond (e.g. one per sensor instance) count once.  Critical messages such as mode changes and parameters are never dropped.  0 logs at the rate the vehicle writes.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("_FILE_RATEMAX",  3, DataFlash_Class, _params.file_rate_max,      0),
+
+    // @Param: _MAV_RATEMAX
+    // @DisplayName: Maximum logging rate per message type for the MAVLink backend
+    // @Description: Each type of log message in the classes selected by LOG_MAV_RATECLS sent to the DataFlash_MAVLink backend is decimated to at most this rate, so a companion link can carry a lower rate log than the SD card.  Messages of the same type written in the same millisecond (e.g. one per sensor instance) count once.  Critical messages such as mode changes and parameters are never dropped.  0 logs at the rate the vehicle writes.
+    // @Units: Hz
+    // @Range: 0 1000
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("_MAV_RATEMAX",   4, DataFlash_Class, _params.mav_rate_max,       0),
+
+    // @Param: _MAV_BUFSIZE
+    // @DisplayName: Maximum DataFlash MAVLink Backend buffer size
+    // @Description: The DataFlash_MAVLink backend keeps log blocks in this buffer until the client acknowledges them, and never has more blocks unacknowledged than fit in it.  Raising this value lets remote logging ride out longer link delays without dropping messages.  This buffer size may be reduced depending on available memory.
+    // @Units: kilobytes
+    // @Range: 2 127
+    // @User: Advanced
+    AP_GROUPINFO("_MAV_BUFSIZE",   5, DataFlash_Class, _params.mav_bufsize,        8),
+
+    // @Param: _FILE_RATECLS
+    // @DisplayName: Rate limited message classes for the File backend
+    // @Description: Classes of log message that LOG_FILE_RATEMAX applies to.  Sensors are the raw IMU, barometer and compass messages, Estimator the EKF and AHRS messages and Control the attitude, PID and RC messages.  Messages in classes not selected are logged at the rate the vehicle writes them.
+    // @Bitmask: 0:Sensors,1:Estimator,2:Control,3:Other
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("_FILE_RATECLS",  6, DataFlash_Class, _params.file_rate_classes,  7),
+
+    // @Param: _MAV_RATECLS
+    // @DisplayName: Rate limited message classes for the MAVLink backend
+    // @Description: Classes of log message that LOG_MAV_RATEMAX applies to.  Sensors are the raw IMU, barometer and compass messages, Estimator the EKF and AHRS messages and Control the attitude, PID and RC messages.  Messages in classes not selected are logged at the rate the vehicle writes them.
+    // @Bitmask: 0:Sensors,1:Estimator,2:Control,3:Other
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("_MAV_RATECLS",   7, DataFlash_Class, _params.mav_rate_classes,   7),
+
     AP_GROUPEND
 };
 
@@ -41,17 +90,22 @@ void DataFlash_Class::set_mission(const AP_Mission *mission) {
     FOR_EACH_BACKEND(set_mission(mission));
 }
 
-// start functions pass straight through to backend:
+// start functions pass through to each backend that accepts the
+// message at its configured rate:
 void DataFlash_Class::WriteBlock(const void *pBuffer, uint16_t size) {
-    FOR_EACH_BACKEND(WriteBlock(pBuffer, size));
+    WritePrioritisedBlock(pBuffer, size, false);
 }
 
 void DataFlash_Class::WriteCriticalBlock(const void *pBuffer, uint16_t size) {
-    FOR_EACH_BACKEND(WriteCriticalBlock(pBuffer, size));
+    WritePrioritisedBlock(pBuffer, size, true);
 }
 
 void DataFlash_Class::WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) {
-    FOR_EACH_BACKEND(WritePrioritisedBlock(pBuffer, size, is_critical));
+    for (uint8_t i=0; i<_next_backend; i++) {
+        if (backends[i]->rate_limit_accept(pBuffer, size, is_critical)) {
+            backends[i]->WritePrioritisedBlock(pBuffer, size, is_critical);
+        }
+    }
 }
 
 // change me to "DoTimeConsumingPreparations"?
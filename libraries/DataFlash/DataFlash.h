@@ -38,6 +38,10 @@ enum DataFlash_Backend_Type {
     DATAFLASH_BACKEND_BOTH = 3,
 };
 
+// returned by get_log_data() when the data has been requested from
+// storage but is not available yet.  The caller should try again later
+#define DATAFLASH_LOG_DATA_PENDING -2
+
 class DataFlash_Class
 {
     friend class DataFlash_Backend; // for _num_types
@@ -158,6 +162,12 @@ public:
     struct {
         AP_Int8 backend_types;
         AP_Int8 file_bufsize; // in kilobytes
+        AP_Int8 file_compress;
+        AP_Int16 file_rate_max; // Hz per message type, 0 for no limit
+        AP_Int16 mav_rate_max;  // Hz per message type, 0 for no limit
+        AP_Int8 file_rate_classes; // DataFlash_Backend::rate_class bits file_rate_max applies to
+        AP_Int8 mav_rate_classes;  // DataFlash_Backend::rate_class bits mav_rate_max applies to
+        AP_Int8 mav_bufsize;    // in kilobytes
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
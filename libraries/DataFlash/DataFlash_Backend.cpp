@@ -7,7 +7,10 @@ extern const AP_HAL::HAL& hal;
 DataFlash_Backend::DataFlash_Backend(DataFlash_Class &front,
                                      class DFMessageWriter_DFLogStart *writer) :
     _front(front),
-    _startup_messagewriter(writer)
+    _startup_messagewriter(writer),
+    _rate_last_ms(NULL),
+    _rate_period_ms(0),
+    _rate_classes(0)
 {
     writer->set_dataflash_backend(this);
 }
@@ -51,6 +54,103 @@ void DataFlash_Backend::periodic_tasks()
 }
 
 
+uint8_t DataFlash_Backend::rate_class(uint8_t msgid)
+{
+    switch (msgid) {
+    case LOG_IMU_MSG:
+    case LOG_IMU2_MSG:
+    case LOG_IMU3_MSG:
+    case LOG_IMUDT_MSG:
+    case LOG_IMUDT2_MSG:
+    case LOG_IMUDT3_MSG:
+    case LOG_ACC1_MSG:
+    case LOG_ACC2_MSG:
+    case LOG_ACC3_MSG:
+    case LOG_GYR1_MSG:
+    case LOG_GYR2_MSG:
+    case LOG_GYR3_MSG:
+    case LOG_VIBE_MSG:
+    case LOG_BARO_MSG:
+    case LOG_BAR2_MSG:
+    case LOG_BAR3_MSG:
+    case LOG_COMPASS_MSG:
+    case LOG_COMPASS2_MSG:
+    case LOG_COMPASS3_MSG:
+        return RATE_CLASS_SENSOR;
+    case LOG_AHR2_MSG:
+    case LOG_POS_MSG:
+    case LOG_EKF1_MSG:
+    case LOG_EKF2_MSG:
+    case LOG_EKF3_MSG:
+    case LOG_EKF4_MSG:
+    case LOG_EKF5_MSG:
+    case LOG_NKF1_MSG:
+    case LOG_NKF2_MSG:
+    case LOG_NKF3_MSG:
+    case LOG_NKF4_MSG:
+    case LOG_NKF5_MSG:
+    case LOG_NKF6_MSG:
+    case LOG_NKF7_MSG:
+    case LOG_NKF8_MSG:
+    case LOG_NKF9_MSG:
+        return RATE_CLASS_ESTIMATOR;
+    case LOG_ATTITUDE_MSG:
+    case LOG_PIDR_MSG:
+    case LOG_PIDP_MSG:
+    case LOG_PIDY_MSG:
+    case LOG_PIDA_MSG:
+    case LOG_PIDS_MSG:
+    case LOG_RCIN_MSG:
+    case LOG_RCOUT_MSG:
+        return RATE_CLASS_CONTROL;
+    default:
+        return RATE_CLASS_OTHER;
+    }
+}
+
+void DataFlash_Backend::set_rate_limit(int16_t hz, uint8_t classes)
+{
+    _rate_classes = classes;
+    if (hz <= 0 || classes == 0) {
+        _rate_period_ms = 0;
+        return;
+    }
+    if (_rate_last_ms == NULL) {
+        _rate_last_ms = (uint16_t *)calloc(256, sizeof(uint16_t));
+        if (_rate_last_ms == NULL) {
+            return;
+        }
+    }
+    _rate_period_ms = MAX(1000 / hz, 1);
+}
+
+/*
+  decide if a message should go to this backend.  Each message type in
+  _rate_classes is accepted at most once per _rate_period_ms, so one
+  backend can take full rate IMU data while another takes a decimated
+  subset.  Further
+  messages of the same type in the same millisecond as an accepted
+  one are also accepted so all instances of multi-instance messages
+  (e.g. IMU, BAT) are kept together
+ */
+bool DataFlash_Backend::rate_limit_accept(const void *pBuffer, uint16_t size, bool is_critical)
+{
+    if (_rate_period_ms == 0 || is_critical || size < 3) {
+        return true;
+    }
+    const uint8_t msgid = ((const uint8_t *)pBuffer)[2];
+    if (msgid == LOG_FORMAT_MSG || (rate_class(msgid) & _rate_classes) == 0) {
+        return true;
+    }
+    const uint16_t now = AP_HAL::millis() & 0xFFFF;
+    const uint16_t elapsed = now - _rate_last_ms[msgid];
+    if (elapsed != 0 && elapsed < _rate_period_ms) {
+        return false;
+    }
+    _rate_last_ms[msgid] = now;
+    return true;
+}
+
 void DataFlash_Backend::internal_error() {
     _internal_errors++;
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
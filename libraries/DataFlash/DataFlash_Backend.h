@@ -53,6 +53,24 @@ public:
     virtual void ListAvailableLogs(AP_HAL::BetterStream *port) = 0;
 
     void EnableWrites(bool enable) { _writes_enabled = enable; }
+
+    // classes of message that a backend rate limit can apply to
+    enum rate_class {
+        RATE_CLASS_SENSOR    = (1<<0), // raw IMU, barometer and compass
+        RATE_CLASS_ESTIMATOR = (1<<1), // EKF and AHRS
+        RATE_CLASS_CONTROL   = (1<<2), // attitude, PID and RC
+        RATE_CLASS_OTHER     = (1<<3), // everything else
+    };
+
+    // class of messages of type msgid
+    static uint8_t rate_class(uint8_t msgid);
+
+    // limit each non-critical message type in the rate_class bits of
+    // classes to hz messages per second, 0 for no limit
+    void set_rate_limit(int16_t hz, uint8_t classes);
+
+    // returns true if the message should be written to this backend
+    bool rate_limit_accept(const void *pBuffer, uint16_t size, bool is_critical);
     bool logging_started(void) const { return log_write_started; }
 
     virtual void Init() {
@@ -133,6 +151,11 @@ private:
 
     uint32_t _last_periodic_1Hz;
     uint32_t _last_periodic_10Hz;
+
+    // rate limiting: time in milliseconds each message type was last accepted
+    uint16_t *_rate_last_ms;
+    uint16_t _rate_period_ms;
+    uint8_t _rate_classes;
 };
 
 #endif
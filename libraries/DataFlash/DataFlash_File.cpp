@@ -44,6 +44,13 @@ extern const AP_HAL::HAL& hal;
 #define MAX_LOG_FILES 500U
 #define DATAFLASH_PAGE_SIZE 1024UL
 
+// size of each log download read-ahead chunk
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_1000
+#define DATAFLASH_READAHEAD_CHUNK 32768UL
+#else
+#define DATAFLASH_READAHEAD_CHUNK 4096UL
+#endif
+
 /*
   constructor
  */
@@ -82,11 +89,14 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
     _writebuf_head(0),
     _writebuf_tail(0),
     _last_write_time(0),
+    _compressor(NULL),
     _perf_write(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_write")),
     _perf_fsync(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_fsync")),
     _perf_errors(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_errors")),
     _perf_overruns(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_overruns"))
-{}
+{
+    memset(_readahead, 0, sizeof(_readahead));
+}
 
 
 // initialisation
@@ -102,6 +112,16 @@ void DataFlash_File::Init()
         AP_HAL::panic("Failed to create DataFlash_File semaphore");
         return;
     }
+    _readahead_sem = hal.util->new_semaphore();
+    if (_readahead_sem == nullptr) {
+        AP_HAL::panic("Failed to create DataFlash_File read-ahead semaphore");
+        return;
+    }
+    _compress_sem = hal.util->new_semaphore();
+    if (_compress_sem == nullptr) {
+        AP_HAL::panic("Failed to create DataFlash_File compression semaphore");
+        return;
+    }
     
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
     // try to cope with an existing lowercase log directory
@@ -164,6 +184,16 @@ void DataFlash_File::Init()
         return;        
     }
     _writebuf_head = _writebuf_tail = 0;
+
+    if (_front._params.file_compress != 0 && _compressor == NULL) {
+        _compressor = new DFCompress_Encoder();
+        if (_compressor == NULL || !_compressor->init()) {
+            hal.console->printf("Out of memory for log compression\n");
+            delete _compressor;
+            _compressor = NULL;
+        }
+    }
+
     _initialised = true;
     hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
 }
@@ -671,7 +701,25 @@ int16_t DataFlash_File::get_log_data(const uint16_t list_entry, const uint16_t p
         return -1;
     }
 
+    if (!_readahead_sem->take_nonblocking()) {
+        // the IO thread is reading a chunk
+        return DATAFLASH_LOG_DATA_PENDING;
+    }
+    const int16_t ret = _get_log_data_locked(log_num, page * (uint32_t)DATAFLASH_PAGE_SIZE + offset, len, data);
+    _readahead_sem->give();
+    return ret;
+}
+
+/*
+  get_log_data() with _readahead_sem held
+ */
+int16_t DataFlash_File::_get_log_data_locked(uint16_t log_num, uint32_t ofs, uint16_t len, uint8_t *data)
+{
     if (_read_fd != -1 && log_num != _read_fd_log_num) {
+        // drop chunks of the previous log, including any not yet read
+        for (uint8_t i=0; i<ARRAY_SIZE(_readahead); i++) {
+            _readahead[i].state = READAHEAD_EMPTY;
+        }
         ::close(_read_fd);
         _read_fd = -1;
     }
@@ -696,7 +744,23 @@ int16_t DataFlash_File::get_log_data(const uint16_t list_entry, const uint16_t p
         _read_offset = 0;
         _read_fd_log_num = log_num;
     }
-    uint32_t ofs = page * (uint32_t)DATAFLASH_PAGE_SIZE + offset;
+
+    if (_readahead_init()) {
+        return _readahead_get(log_num, ofs, len, data);
+    }
+
+    // no memory for read-ahead, read directly
+    return (int16_t)_read_at(ofs, data, len);
+}
+
+/*
+  read from the open log file
+ */
+int32_t DataFlash_File::_read_at(uint32_t ofs, uint8_t *data, uint32_t len)
+{
+    if (_read_fd == -1) {
+        return -1;
+    }
 
     /*
       this rather strange bit of code is here to work around a bug
@@ -731,13 +795,189 @@ int16_t DataFlash_File::get_log_data(const uint16_t list_entry, const uint16_t p
         }
         _read_offset = ofs;
     }
-    int16_t ret = (int16_t)::read(_read_fd, data, len);
+    int32_t ret = ::read(_read_fd, data, len);
     if (ret > 0) {
         _read_offset += ret;
     }
     return ret;
 }
 
+/*
+  allocate the read-ahead buffers on the first download
+ */
+bool DataFlash_File::_readahead_init(void)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(_readahead); i++) {
+        if (_readahead[i].data == NULL) {
+            _readahead[i].data = (uint8_t *)malloc(DATAFLASH_READAHEAD_CHUNK);
+            if (_readahead[i].data == NULL) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+struct DataFlash_File::readahead_chunk *DataFlash_File::_readahead_find(uint16_t log_num, uint32_t offset)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(_readahead); i++) {
+        struct readahead_chunk &c = _readahead[i];
+        if (c.state != READAHEAD_EMPTY &&
+            c.log_num == log_num &&
+            offset >= c.offset && offset < c.offset + DATAFLASH_READAHEAD_CHUNK) {
+            return &c;
+        }
+    }
+    return NULL;
+}
+
+/*
+  ask the IO thread to read the chunk starting at offset into a chunk
+  other than keep
+ */
+void DataFlash_File::_readahead_request(uint16_t log_num, uint32_t offset, const struct readahead_chunk *keep)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(_readahead); i++) {
+        struct readahead_chunk &c = _readahead[i];
+        if (&c == keep || c.state == READAHEAD_REQUESTED) {
+            continue;
+        }
+        c.log_num = log_num;
+        c.offset = offset;
+        c.len = 0;
+        c.eof_reread = false;
+        c.state = READAHEAD_REQUESTED;
+        return;
+    }
+}
+
+/*
+  a chunk shorter than DATAFLASH_READAHEAD_CHUNK ended at the end of
+  the file when it was read, but the log may have grown since.  A
+  request that runs off the end of it is only answered once the chunk
+  has been read again.  Returns true if the re-read is still to come
+ */
+bool DataFlash_File::_readahead_reread_eof(struct readahead_chunk &c)
+{
+    if (c.eof_reread) {
+        c.eof_reread = false;
+        return false;
+    }
+    c.eof_reread = true;
+    c.len = 0;
+    c.state = READAHEAD_REQUESTED;
+    return true;
+}
+
+/*
+  copy log data out of the read-ahead chunks, requesting chunks as
+  needed.  A request may span the end of one chunk and the start of
+  the next
+ */
+int16_t DataFlash_File::_readahead_get(uint16_t log_num, uint32_t ofs, uint16_t len, uint8_t *data)
+{
+    struct readahead_chunk *c = _readahead_find(log_num, ofs);
+    if (c == NULL) {
+        _readahead_request(log_num, ofs - (ofs % DATAFLASH_READAHEAD_CHUNK), NULL);
+        return DATAFLASH_LOG_DATA_PENDING;
+    }
+    if (c->state != READAHEAD_READY) {
+        return DATAFLASH_LOG_DATA_PENDING;
+    }
+    if (c->len < 0) {
+        c->state = READAHEAD_EMPTY;
+        return -1;
+    }
+
+    const uint32_t chunk_end = c->offset + c->len;
+    const bool eof = (c->len < (int32_t)DATAFLASH_READAHEAD_CHUNK);
+    if (eof && ofs + len > chunk_end && _readahead_reread_eof(*c)) {
+        return DATAFLASH_LOG_DATA_PENDING;
+    }
+    if (ofs >= chunk_end) {
+        return 0;
+    }
+    uint16_t n = MIN(len, chunk_end - ofs);
+    const uint32_t next_offset = c->offset + DATAFLASH_READAHEAD_CHUNK;
+    struct readahead_chunk *next = eof ? NULL : _readahead_find(log_num, next_offset);
+
+    if (n < len && !eof) {
+        // the rest of the request is in the next chunk
+        if (next == NULL) {
+            _readahead_request(log_num, next_offset, c);
+            return DATAFLASH_LOG_DATA_PENDING;
+        }
+        if (next->state != READAHEAD_READY) {
+            return DATAFLASH_LOG_DATA_PENDING;
+        }
+        if (next->len < 0) {
+            next->state = READAHEAD_EMPTY;
+            return -1;
+        }
+        if (next->len < (int32_t)(len - n) && _readahead_reread_eof(*next)) {
+            return DATAFLASH_LOG_DATA_PENDING;
+        }
+        memcpy(data, &c->data[ofs - c->offset], n);
+        const uint16_t m = MIN(len - n, (uint32_t)next->len);
+        memcpy(&data[n], next->data, m);
+        // this chunk is finished with, so use it for the one after next
+        if (next->len == (int32_t)DATAFLASH_READAHEAD_CHUNK) {
+            _readahead_request(log_num, next_offset + DATAFLASH_READAHEAD_CHUNK, next);
+        }
+        return n + m;
+    }
+
+    memcpy(data, &c->data[ofs - c->offset], n);
+
+    // read the next chunk while this one is sent
+    if (!eof && next == NULL) {
+        _readahead_request(log_num, next_offset, c);
+    }
+    return n;
+}
+
+/*
+  forget all read-ahead data and close the download file, waiting for
+  any read in progress
+ */
+void DataFlash_File::_readahead_invalidate(void)
+{
+    if (_readahead_sem == nullptr || !_readahead_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+    for (uint8_t i=0; i<ARRAY_SIZE(_readahead); i++) {
+        _readahead[i].state = READAHEAD_EMPTY;
+    }
+    if (_read_fd != -1) {
+        ::close(_read_fd);
+        _read_fd = -1;
+    }
+    _readahead_sem->give();
+}
+
+/*
+  read requested chunks.  Called from the IO thread
+ */
+void DataFlash_File::_io_timer_readahead(void)
+{
+    if (_readahead_sem == nullptr || !_readahead_sem->take_nonblocking()) {
+        return;
+    }
+    for (uint8_t i=0; i<ARRAY_SIZE(_readahead); i++) {
+        struct readahead_chunk &c = _readahead[i];
+        if (c.state != READAHEAD_REQUESTED) {
+            continue;
+        }
+        if (_read_fd != -1 && _read_fd_log_num == c.log_num) {
+            c.len = _read_at(c.offset, c.data, DATAFLASH_READAHEAD_CHUNK);
+        } else {
+            c.len = -1;
+        }
+        c.state = READAHEAD_READY;
+    }
+    _readahead_sem->give();
+}
+
 /*
   find size and date of a log
  */
@@ -787,12 +1027,24 @@ uint16_t DataFlash_File::get_num_logs()
  */
 void DataFlash_File::stop_logging(void)
 {
+    if (_compressor != NULL) {
+        if (!_compress_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+            return;
+        }
+        // the end of the log is still in the write buffer and encoder
+        if (_write_fd != -1 && _initialised && !_open_error) {
+            _compressed_drain();
+        }
+    }
     if (_write_fd != -1) {
         int fd = _write_fd;
         _write_fd = -1;
         log_write_started = false;
         ::close(fd);
     }
+    if (_compressor != NULL) {
+        _compress_sem->give();
+    }
 }
 
 
@@ -811,10 +1063,7 @@ uint16_t DataFlash_File::start_new_log(void)
         return 0xFFFF;
     }
 
-    if (_read_fd != -1) {
-        ::close(_read_fd);
-        _read_fd = -1;
-    }
+    _readahead_invalidate();
 
     uint16_t log_num = find_last_log();
     // re-use empty logs if possible
@@ -828,10 +1077,10 @@ uint16_t DataFlash_File::start_new_log(void)
     if (fname == NULL) {
         return 0xFFFF;
     }
-    _write_fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    int write_fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
     _cached_oldest_log = 0;
 
-    if (_write_fd == -1) {
+    if (write_fd == -1) {
         _initialised = false;
         _open_error = true;
         int saved_errno = errno;
@@ -844,8 +1093,25 @@ uint16_t DataFlash_File::start_new_log(void)
     }
     free(fname);
     _write_offset = 0;
+    if (_compressor != NULL) {
+        if (::write(write_fd, DFCOMPRESS_FILE_MAGIC, DFCOMPRESS_FILE_MAGIC_LEN) != DFCOMPRESS_FILE_MAGIC_LEN) {
+            ::close(write_fd);
+            return 0xFFFF;
+        }
+        _write_offset = DFCOMPRESS_FILE_MAGIC_LEN;
+        // the IO thread may be in the encoder until we hold the semaphore
+        if (!_compress_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+            ::close(write_fd);
+            return 0xFFFF;
+        }
+        _compressor->reset();
+    }
     _writebuf_head = 0;
     _writebuf_tail = 0;
+    _write_fd = write_fd;
+    if (_compressor != NULL) {
+        _compress_sem->give();
+    }
     log_write_started = true;
 
     // now update lastlog.txt with the new log number
@@ -885,10 +1151,7 @@ void DataFlash_File::LogReadProcess(const uint16_t list_entry,
         return;
     }
 
-    if (_read_fd != -1) {
-        ::close(_read_fd);
-        _read_fd = -1;
-    }
+    _readahead_invalidate();
     char *fname = _log_file_name(log_num);
     if (fname == NULL) {
         return;
@@ -1021,12 +1284,21 @@ void DataFlash_File::flush(void)
     uint16_t _tail;
     uint32_t tnow = AP_HAL::micros();
     hal.scheduler->suspend_timer_procs();
-    while (_write_fd != -1 && _initialised && !_open_error &&
-           BUF_AVAILABLE(_writebuf)) {
-        // convince the IO timer that it really is OK to write out
-        // less than _writebuf_chunk bytes:
-        _last_write_time = tnow - 2000000;
-        _io_timer();
+    if (_compressor != NULL) {
+        if (_compress_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+            if (_write_fd != -1 && _initialised && !_open_error) {
+                _compressed_drain();
+            }
+            _compress_sem->give();
+        }
+    } else {
+        while (_write_fd != -1 && _initialised && !_open_error &&
+               BUF_AVAILABLE(_writebuf)) {
+            // convince the IO timer that it really is OK to write out
+            // less than _writebuf_chunk bytes:
+            _last_write_time = tnow - 2000000;
+            _io_timer();
+        }
     }
     hal.scheduler->resume_timer_procs();
     if (_write_fd != -1) {
@@ -1038,10 +1310,26 @@ void DataFlash_File::flush(void)
 void DataFlash_File::_io_timer(void)
 {
     uint16_t _tail;
+
+    // get_log_data() stops the current log, but a vehicle may start a
+    // new one while the download continues, so both can be active.
+    // Serve read-ahead first so a download is not held up behind writes
+    _io_timer_readahead();
+
     if (_write_fd == -1 || !_initialised || _open_error) {
         return;
     }
 
+    if (_compressor != NULL) {
+        // stop_logging() and start_new_log() hold the semaphore while
+        // they flush or reset the encoder
+        if (_compress_sem->take_nonblocking()) {
+            _io_timer_compressed();
+            _compress_sem->give();
+        }
+        return;
+    }
+
     uint16_t nbytes = BUF_AVAILABLE(_writebuf);
     if (nbytes == 0) {
         return;
@@ -1098,5 +1386,103 @@ void DataFlash_File::_io_timer(void)
     hal.util->perf_end(_perf_write);
 }
 
+/*
+  write out the compressed block waiting in the encoder, if any.
+  Returns true if a block was (at least partly) written
+ */
+bool DataFlash_File::_write_compressed_pending(void)
+{
+    uint16_t len;
+    const uint8_t *data = _compressor->pending(len);
+    if (data == NULL) {
+        return false;
+    }
+
+    hal.util->perf_begin(_perf_write);
+    ssize_t nwritten = ::write(_write_fd, data, len);
+    if (nwritten <= 0) {
+        hal.util->perf_count(_perf_errors);
+        close(_write_fd);
+        _write_fd = -1;
+        _initialised = false;
+        hal.util->perf_end(_perf_write);
+        return false;
+    }
+    _last_write_time = AP_HAL::micros();
+    _write_offset += nwritten;
+    _compressor->consumed(nwritten);
+#if CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
+    ::fsync(_write_fd);
+#endif
+    hal.util->perf_end(_perf_write);
+    return true;
+}
+
+/*
+  encode everything left in the write buffer and write out all
+  compressed blocks, including the partial one.  Called with
+  _compress_sem held
+ */
+void DataFlash_File::_compressed_drain(void)
+{
+    uint16_t _tail;
+
+    while (_write_fd != -1 && BUF_AVAILABLE(_writebuf)) {
+        _io_timer_compressed();
+    }
+    if (_write_fd == -1) {
+        return;
+    }
+    while (!_compressor->flush() && _write_compressed_pending()) {
+    }
+    while (_write_compressed_pending()) {
+    }
+}
+
+/*
+  IO timer for compressed logging.  Data is moved from the write
+  buffer into the encoder on this thread, so compression costs nothing
+  on the main loop.  Each call either encodes up to _writebuf_chunk bytes
+  or writes one compressed block
+ */
+void DataFlash_File::_io_timer_compressed(void)
+{
+    uint16_t _tail;
+
+    if (_write_fd == -1) {
+        return;
+    }
+    // finish writing the previous block before encoding any more
+    if (_write_compressed_pending()) {
+        return;
+    }
+    if (_write_fd == -1) {
+        return;
+    }
+
+    uint32_t tnow = AP_HAL::micros();
+    uint16_t nbytes = BUF_AVAILABLE(_writebuf);
+    if (nbytes == 0) {
+        // always write at least once per 2 seconds if data is available
+        if (_compressor->have_partial() &&
+            tnow - _last_write_time >= 2000000UL) {
+            _compressor->flush();
+            _write_compressed_pending();
+        }
+        return;
+    }
+
+    if (nbytes > _writebuf_chunk) {
+        nbytes = _writebuf_chunk;
+    }
+    if (_writebuf_head > _tail) {
+        // only read to the end of the buffer
+        nbytes = MIN(nbytes, _writebuf_size - _writebuf_head);
+    }
+
+    uint16_t consumed = _compressor->encode(&_writebuf[_writebuf_head], nbytes);
+    BUF_ADVANCEHEAD(_writebuf, consumed);
+}
+
 #endif // HAL_OS_POSIX_IO
 
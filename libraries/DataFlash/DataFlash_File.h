@@ -13,6 +13,7 @@
 #if HAL_OS_POSIX_IO
 
 #include "DataFlash_Backend.h"
+#include "DFCompress.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_QURT
 /*
@@ -122,6 +123,46 @@ private:
 
     void _io_timer(void);
 
+    // read len bytes at ofs from _read_fd
+    int32_t _read_at(uint32_t ofs, uint8_t *data, uint32_t len);
+
+    /*
+      log download read-ahead.  get_log_data() serves requests from
+      large chunks read on the IO thread, and requests the following
+      chunk while the current one is being sent.  The chunks and
+      _read_fd are only touched with _readahead_sem held
+     */
+    enum readahead_state {
+        READAHEAD_EMPTY = 0,
+        READAHEAD_REQUESTED,
+        READAHEAD_READY
+    };
+    struct readahead_chunk {
+        uint8_t state;
+        bool eof_reread;        // read again to check for growth of the log
+        uint16_t log_num;
+        uint32_t offset;
+        int32_t len;            // bytes read, -1 on error
+        uint8_t *data;
+    } _readahead[2];
+    AP_HAL::Semaphore *_readahead_sem = nullptr;
+    bool _readahead_init(void);
+    struct readahead_chunk *_readahead_find(uint16_t log_num, uint32_t offset);
+    void _readahead_request(uint16_t log_num, uint32_t offset, const struct readahead_chunk *keep);
+    bool _readahead_reread_eof(struct readahead_chunk &c);
+    int16_t _readahead_get(uint16_t log_num, uint32_t ofs, uint16_t len, uint8_t *data);
+    void _readahead_invalidate(void);
+    void _io_timer_readahead(void);
+    int16_t _get_log_data_locked(uint16_t log_num, uint32_t ofs, uint16_t len, uint8_t *data);
+
+    // compressed logging, NULL if disabled.  The encoder is only
+    // touched with _compress_sem held
+    DFCompress_Encoder *_compressor;
+    AP_HAL::Semaphore *_compress_sem = nullptr;
+    void _io_timer_compressed(void);
+    bool _write_compressed_pending(void);
+    void _compressed_drain(void);
+
     uint16_t critical_message_reserved_space() const {
         // possibly make this a proportional to buffer size?
         uint16_t ret = 1024;
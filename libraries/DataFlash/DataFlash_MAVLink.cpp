@@ -27,12 +27,22 @@ void DataFlash_MAVLink::Init()
 {
     DataFlash_Backend::Init();
 
+    // size the window from the configured buffer size
+    uint32_t blockcount = ((uint32_t)_front._params.mav_bufsize * 1024) / sizeof(_blocks[0]);
+    _blockcount = constrain_int32(blockcount, 8, 0xFFFF);
+
     _blocks = NULL;
+    _retry_queue = NULL;
     while (_blockcount >= 8) { // 8 is a *magic* number
         _blocks = (struct dm_block *) malloc(_blockcount * sizeof(_blocks[0]));
-        if (_blocks != NULL) {
+        _retry_queue = (uint32_t *) malloc(_blockcount * sizeof(_retry_queue[0]));
+        if (_blocks != NULL && _retry_queue != NULL) {
             break;
         }
+        free(_blocks);
+        free(_retry_queue);
+        _blocks = NULL;
+        _retry_queue = NULL;
         _blockcount /= 2;
     }
 
@@ -51,7 +61,11 @@ void DataFlash_MAVLink::Init()
 }
 
 uint16_t DataFlash_MAVLink::bufferspace_available() {
-    return (_blockcount_free * 200 + remaining_space_in_current_block());
+    uint32_t space = (uint32_t)blocks_free() * MAVLINK_MSG_REMOTE_LOG_DATA_BLOCK_FIELD_DATA_LEN;
+    if (_current_block != NULL) {
+        space += remaining_space_in_current_block();
+    }
+    return MIN(space, 0xFFFF);
 }
 
 uint8_t DataFlash_MAVLink::remaining_space_in_current_block() {
@@ -59,54 +73,31 @@ uint8_t DataFlash_MAVLink::remaining_space_in_current_block() {
     return (MAVLINK_MSG_REMOTE_LOG_DATA_BLOCK_FIELD_DATA_LEN - _latest_block_len);
 }
 
-void DataFlash_MAVLink::enqueue_block(dm_block_queue_t &queue, struct dm_block *block)
+struct DataFlash_MAVLink::dm_block *DataFlash_MAVLink::block_for_seqno(uint32_t seqno)
 {
-    if (queue.youngest != NULL) {
-        queue.youngest->next = block;
-    } else {
-        queue.oldest = block;
+    // only blocks in the window are in use
+    if (seqno - _seq_base >= _next_seq_num - _seq_base) {
+        return NULL;
+    }
+    struct dm_block *block = &_blocks[seqno % _blockcount];
+    if (block->seqno != seqno) {
+        internal_error();
+        return NULL;
     }
-    queue.youngest = block;
+    return block;
 }
 
-struct DataFlash_MAVLink::dm_block *DataFlash_MAVLink::dequeue_seqno(DataFlash_MAVLink::dm_block_queue_t &queue, uint32_t seqno)
+void DataFlash_MAVLink::retry_push(uint32_t seqno)
 {
-    struct dm_block *prev = NULL;
-    for (struct dm_block *block=queue.oldest; block != NULL; block=block->next) {
-        if (block->seqno == seqno) {
-            if (prev == NULL) {
-                if (queue.youngest == queue.oldest) {
-                    queue.oldest = NULL;
-                    queue.youngest = NULL;
-                } else {
-                    queue.oldest = block->next;
-                }
-            } else {
-                if (queue.youngest == block) {
-                    queue.youngest = prev;
-                }
-                prev->next = block->next;
-            }
-            block->next = NULL;
-            return block;
-        }
-        prev = block;
+    if (_retry_len == _blockcount) {
+        // can't happen - each block is queued at most once
+        internal_error();
+        return;
     }
-    return NULL;
+    _retry_queue[(_retry_head + _retry_len) % _blockcount] = seqno;
+    _retry_len++;
 }
 
-bool DataFlash_MAVLink::free_seqno_from_queue(uint32_t seqno, dm_block_queue_t &queue)
-{
-    struct dm_block *block = dequeue_seqno(queue, seqno);
-    if (block != NULL) {
-        block->next = _blocks_free;
-        _blocks_free = block;
-        _blockcount_free++; // comment me out to expose a bug!
-        return true;
-    }
-    return false;
-}
-    
 /* Write a block of data at current offset */
 
 // DM_write: 70734 events, 0 overruns, 167806us elapsed, 2us avg, min 1us max 34us 0.620us rms
@@ -147,7 +138,8 @@ bool DataFlash_MAVLink::WritePrioritisedBlock(const void *pBuffer, uint16_t size
         _latest_block_len += to_copy;
         if (_latest_block_len == MAVLINK_MSG_REMOTE_LOG_DATA_BLOCK_FIELD_DATA_LEN) {
             //block full, mark it to be sent:
-            enqueue_block(_blocks_pending, _current_block);
+            _current_block->state = BLOCK_STATE_SEND_PENDING;
+            _count_pending++;
             _current_block = next_block();
         }
     }
@@ -162,45 +154,86 @@ bool DataFlash_MAVLink::WritePrioritisedBlock(const void *pBuffer, uint16_t size
 //Get a free block
 struct DataFlash_MAVLink::dm_block *DataFlash_MAVLink::next_block()
 {
-    DataFlash_MAVLink::dm_block *ret = _blocks_free;
-    if (ret != NULL) {
-        _blocks_free = ret->next;
-        _blockcount_free--;
-        ret->seqno = _next_seq_num++;
-        ret->last_sent = 0;
-        ret->next = NULL;
-        _latest_block_len = 0;
-    }
+    if (blocks_free() == 0) {
+        // the window is full of blocks waiting to be sent or acked
+        return NULL;
+    }
+    struct dm_block *ret = &_blocks[_next_seq_num % _blockcount];
+    ret->seqno = _next_seq_num++;
+    ret->state = BLOCK_STATE_FILLING;
+    ret->last_sent = 0;
+    ret->send_count = 0;
+    _latest_block_len = 0;
     return ret;
 }
 
 void DataFlash_MAVLink::free_all_blocks()
 {
-    _blocks_free = NULL;
     _current_block = NULL;
 
-    _blocks_pending.sent_count = 0;
-    _blocks_pending.oldest = _blocks_pending.youngest = NULL;
-    _blocks_retry.sent_count = 0;
-    _blocks_retry.oldest = _blocks_retry.youngest = NULL;
-    _blocks_sent.sent_count = 0;
-    _blocks_sent.oldest = _blocks_sent.youngest = NULL;
-
-    // add blocks to the free stack:
-    for(uint8_t i=0; i < _blockcount; i++) {
-        _blocks[i].next = _blocks_free;
-        _blocks_free = &_blocks[i];
+    for(uint16_t i=0; i < _blockcount; i++) {
+        _blocks[i].state = BLOCK_STATE_FREE;
         // this value doesn't really matter, but it stops valgrind
-        // complaining when acking blocks (we check seqno before
-        // state).  Also, when we receive ACKs we check seqno, and we
-        // want to ack the *real* block zero!
+        // complaining when acking blocks
         _blocks[i].seqno = 9876543;
     }
-    _blockcount_free = _blockcount;
+    _seq_base = 0;
+    _next_seq_to_send = 0;
+    _next_seq_num = 0;
+    _count_pending = 0;
+    _count_sent = 0;
+    _count_retry = 0;
+    _retry_head = 0;
+    _retry_len = 0;
+
+    _cwnd = 8;
+    _ssthresh = _blockcount;
+    _srtt_ms = 0;
+    _rttvar_ms = 0;
+    _rto_ms = 100;
+    _last_loss_ms = 0;
 
     _latest_block_len = 0;
 }
 
+/*
+  update the resend timeout from a round trip time sample (RFC 6298)
+ */
+void DataFlash_MAVLink::rtt_update(uint32_t sample_ms)
+{
+    if (is_zero(_srtt_ms)) {
+        _srtt_ms = sample_ms;
+        _rttvar_ms = sample_ms * 0.5f;
+    } else {
+        _rttvar_ms = 0.75f * _rttvar_ms + 0.25f * fabsf(_srtt_ms - sample_ms);
+        _srtt_ms = 0.875f * _srtt_ms + 0.125f * sample_ms;
+    }
+    _rto_ms = constrain_float(_srtt_ms + 4 * _rttvar_ms, 20, 2000);
+}
+
+void DataFlash_MAVLink::congestion_ack()
+{
+    if (_cwnd < _ssthresh) {
+        _cwnd += 1;
+    } else {
+        _cwnd += 1.0f / _cwnd;
+    }
+    if (_cwnd > _blockcount) {
+        _cwnd = _blockcount;
+    }
+}
+
+void DataFlash_MAVLink::congestion_loss(uint32_t now)
+{
+    // several blocks lost in one round trip are one congestion event
+    if (now - _last_loss_ms < MAX(_srtt_ms, 20)) {
+        return;
+    }
+    _last_loss_ms = now;
+    _ssthresh = MAX(_cwnd * 0.5f, 2);
+    _cwnd = _ssthresh;
+}
+
 void DataFlash_MAVLink::handle_ack(mavlink_channel_t chan,
                                    mavlink_message_t* msg,
                                    uint32_t seqno)
@@ -220,17 +253,11 @@ void DataFlash_MAVLink::handle_ack(mavlink_channel_t chan,
         if (!_sending_to_client) {
             Debug("Starting New Log");
             free_all_blocks();
-            // _current_block = next_block();
-            // if (_current_block == NULL) {
-            //     Debug("No free blocks?!!!\n");
-            //     return;
-            // }
             stats_init();
             _sending_to_client = true;
             _target_system_id = msg->sysid;
             _target_component_id = msg->compid;
             _chan = chan;
-            _next_seq_num = 0;
             _startup_messagewriter->reset();
             _last_response_time = AP_HAL::millis();
             Debug("Target: (%u/%u)", _target_system_id, _target_component_id);
@@ -238,15 +265,36 @@ void DataFlash_MAVLink::handle_ack(mavlink_channel_t chan,
         return;
     }
 
-    // check SENT blocks (VERY likely to be first on the list):
-    if (free_seqno_from_queue(seqno, _blocks_sent)) {
-        // celebrate
-        _last_response_time = AP_HAL::millis();
-    } else if(free_seqno_from_queue(seqno, _blocks_retry)) {
-        // party
-        _last_response_time = AP_HAL::millis();
-    } else {
-        // probably acked already and put on the free list.
+    struct dm_block *block = block_for_seqno(seqno);
+    if (block == NULL) {
+        // probably acked already
+        return;
+    }
+    const uint32_t now = AP_HAL::millis();
+    switch (block->state) {
+    case BLOCK_STATE_SENT:
+        _count_sent--;
+        // Karn's algorithm: only time blocks which were sent once
+        if (block->send_count == 1) {
+            rtt_update(now - block->last_sent);
+        }
+        congestion_ack();
+        break;
+    case BLOCK_STATE_SEND_RETRY:
+        // acked while waiting to be resent; its retry queue entry is skipped
+        _count_retry--;
+        break;
+    default:
+        // not sent yet, so this can't be for this block
+        return;
+    }
+    block->state = BLOCK_STATE_FREE;
+    _last_response_time = now;
+
+    // slide the window past acked blocks
+    while (_seq_base != _next_seq_num &&
+           _blocks[_seq_base % _blockcount].state == BLOCK_STATE_FREE) {
+        _seq_base++;
     }
 }
 
@@ -268,10 +316,15 @@ void DataFlash_MAVLink::handle_retry(uint32_t seqno)
         return;
     }
 
-    struct dm_block *victim = dequeue_seqno(_blocks_sent, seqno);
-    if (victim != NULL) {
-        _last_response_time = AP_HAL::millis();
-        enqueue_block(_blocks_retry, victim);
+    struct dm_block *block = block_for_seqno(seqno);
+    if (block != NULL && block->state == BLOCK_STATE_SENT) {
+        const uint32_t now = AP_HAL::millis();
+        _last_response_time = now;
+        block->state = BLOCK_STATE_SEND_RETRY;
+        _count_sent--;
+        _count_retry++;
+        retry_push(seqno);
+        congestion_loss(now);
     }
 }
 
@@ -288,24 +341,31 @@ void DataFlash_MAVLink::stats_init() {
     dropped = 0;
     internal_errors = 0;
     stats.resends = 0;
+    stats.retries = 0;
     stats_reset();
 }
 void DataFlash_MAVLink::stats_reset() {
     stats.state_free = 0;
-    stats.state_free_min = -1; // unsigned wrap
+    stats.state_free_min = UINT16_MAX;
     stats.state_free_max = 0;
     stats.state_pending = 0;
-    stats.state_pending_min = -1; // unsigned wrap
+    stats.state_pending_min = UINT16_MAX;
     stats.state_pending_max = 0;
     stats.state_retry = 0;
-    stats.state_retry_min = -1; // unsigned wrap
+    stats.state_retry_min = UINT16_MAX;
     stats.state_retry_max = 0;
     stats.state_sent = 0;
-    stats.state_sent_min = -1; // unsigned wrap
+    stats.state_sent_min = UINT16_MAX;
     stats.state_sent_max = 0;
     stats.collection_count = 0;
 }
 
+// block counts may exceed the range of the DMS message on large buffers
+static uint8_t dms_count(uint32_t count)
+{
+    return MIN(count, UINT8_MAX);
+}
+
 void DataFlash_MAVLink::Log_Write_DF_MAV(DataFlash_MAVLink &df)
 {
     if (df.stats.collection_count == 0) {
@@ -316,18 +376,18 @@ void DataFlash_MAVLink::Log_Write_DF_MAV(DataFlash_MAVLink &df)
         timestamp         : AP_HAL::millis(),
         seqno             : df._next_seq_num-1,
         dropped           : df.dropped,
-        retries           : df._blocks_retry.sent_count,
+        retries           : df.stats.retries,
         resends           : df.stats.resends,
         internal_errors   : df.internal_errors,
-        state_free_avg    : (uint8_t)(df.stats.state_free/df.stats.collection_count),
-        state_free_min    : df.stats.state_free_min,
-        state_free_max    : df.stats.state_free_max,
-        state_pending_avg : (uint8_t)(df.stats.state_pending/df.stats.collection_count),
-        state_pending_min : df.stats.state_pending_min,
-        state_pending_max : df.stats.state_pending_max,
-        state_sent_avg    : (uint8_t)(df.stats.state_sent/df.stats.collection_count),
-        state_sent_min    : df.stats.state_sent_min,
-        state_sent_max    : df.stats.state_sent_max,
+        state_free_avg    : dms_count(df.stats.state_free/df.stats.collection_count),
+        state_free_min    : dms_count(df.stats.state_free_min),
+        state_free_max    : dms_count(df.stats.state_free_max),
+        state_pending_avg : dms_count(df.stats.state_pending/df.stats.collection_count),
+        state_pending_min : dms_count(df.stats.state_pending_min),
+        state_pending_max : dms_count(df.stats.state_pending_max),
+        state_sent_avg    : dms_count(df.stats.state_sent/df.stats.collection_count),
+        state_sent_min    : dms_count(df.stats.state_sent_min),
+        state_sent_max    : dms_count(df.stats.state_sent_max),
         // state_retry_avg   : (uint8_t)(df.stats.state_retry/df.stats.collection_count),
         // state_retry_min    : df.stats.state_retry_min,
         // state_retry_max    : df.stats.state_retry_max
@@ -345,9 +405,9 @@ void DataFlash_MAVLink::stats_log()
     }
     Log_Write_DF_MAV(*this);
 #if REMOTE_LOG_DEBUGGING
-    printf("D:%d Retry:%d Resent:%d E:%d SF:%d/%d/%d SP:%d/%d/%d SS:%d/%d/%d SR:%d/%d/%d\n",
+    printf("D:%d Retry:%d Resent:%d E:%d SF:%d/%d/%d SP:%d/%d/%d SS:%d/%d/%d SR:%d/%d/%d cwnd:%.1f rto:%u\n",
            dropped,
-           _blocks_retry.sent_count,
+           stats.retries,
            stats.resends,
            internal_errors,
            stats.state_free_min,
@@ -361,38 +421,23 @@ void DataFlash_MAVLink::stats_log()
            stats.state_sent/stats.collection_count,
            stats.state_retry_min,
            stats.state_retry_max,
-           stats.state_retry/stats.collection_count
+           stats.state_retry/stats.collection_count,
+           _cwnd,
+           _rto_ms
         );
 #endif
     stats_reset();
 }
 
-uint8_t DataFlash_MAVLink::stack_size(struct dm_block *stack)
-{
-    uint8_t ret = 0;
-    for (struct dm_block *block=stack; block != NULL; block=block->next) {
-        ret++;
-    }
-    return ret;
-}
-uint8_t DataFlash_MAVLink::queue_size(dm_block_queue_t queue)
-{
-    return stack_size(queue.oldest);
-}
-
 void DataFlash_MAVLink::stats_collect()
 {
     if (!_initialised || !_logging_started) {
         return;
     }
-    uint8_t pending = queue_size(_blocks_pending);
-    uint8_t sent = queue_size(_blocks_sent);
-    uint8_t retry = queue_size(_blocks_retry);
-    uint8_t sfree = stack_size(_blocks_free);
-
-    if (sfree != _blockcount_free) {
-        internal_error();
-    }
+    uint16_t pending = _count_pending;
+    uint16_t sent = _count_sent;
+    uint16_t retry = _count_retry;
+    uint16_t sfree = blocks_free();
     stats.state_pending += pending;
     stats.state_sent += sent;
     stats.state_free += sfree;
@@ -426,30 +471,12 @@ void DataFlash_MAVLink::stats_collect()
     stats.collection_count++;
 }
 
-/* while we "successfully" send log blocks from a queue, move them to
- * the sent list. DO NOT call this for blocks already sent!
-*/
-bool DataFlash_MAVLink::send_log_blocks_from_queue(dm_block_queue_t &queue)
-{
-    uint8_t sent_count = 0;
-    while (queue.oldest != NULL) {
-        if (sent_count++ > _max_blocks_per_send_blocks) {
-            return false;
-        }
-        if (! send_log_block(*queue.oldest)) {
-            return false;
-        }
-        queue.sent_count++;
-        struct DataFlash_MAVLink::dm_block *tmp = dequeue_seqno(queue,queue.oldest->seqno);
-        if (tmp != NULL) { // should never be NULL
-            enqueue_block(_blocks_sent, tmp);
-        } else {
-            internal_error();
-        }
-    }
-    return true;
-}
-
+/*
+  send NACKed blocks, then blocks never sent, while the congestion
+  window and the link's txspace allow.  send_log_block() refuses to
+  send when txspace is short, which also bounds the time spent
+  packing messages in any one call
+ */
 void DataFlash_MAVLink::push_log_blocks()
 {
     if (!_initialised || !_logging_started ||!_sending_to_client) {
@@ -458,37 +485,67 @@ void DataFlash_MAVLink::push_log_blocks()
 
     DataFlash_Backend::WriteMoreStartupMessages();
 
-    if (! send_log_blocks_from_queue(_blocks_retry)) {
-        return;
+    while (_retry_len > 0 && window_open()) {
+        const uint32_t seqno = _retry_queue[_retry_head];
+        struct dm_block *block = block_for_seqno(seqno);
+        if (block != NULL && block->state == BLOCK_STATE_SEND_RETRY) {
+            if (!send_log_block(*block)) {
+                return;
+            }
+            block->state = BLOCK_STATE_SENT;
+            _count_retry--;
+            _count_sent++;
+            stats.retries++;
+        }
+        // acked while waiting, or sent: drop from the queue
+        _retry_head = (_retry_head + 1) % _blockcount;
+        _retry_len--;
     }
 
-    if (! send_log_blocks_from_queue(_blocks_pending)) {
-        return;
+    while (_next_seq_to_send != _next_seq_num && window_open()) {
+        struct dm_block *block = &_blocks[_next_seq_to_send % _blockcount];
+        if (block->state != BLOCK_STATE_SEND_PENDING) {
+            // the block being filled
+            break;
+        }
+        if (!send_log_block(*block)) {
+            return;
+        }
+        block->state = BLOCK_STATE_SENT;
+        _count_pending--;
+        _count_sent++;
+        _next_seq_to_send++;
     }
 }
 
+/*
+  resend blocks which have been neither acked nor nacked within the
+  resend timeout.  Each timeout counts as a loss and backs the timeout
+  off until an ack gives a fresh round trip time
+ */
 void DataFlash_MAVLink::do_resends(uint32_t now)
 {
     if (!_initialised || !_logging_started ||!_sending_to_client) {
         return;
     }
 
-    uint8_t count_to_send = 5;
-    if (_blockcount < count_to_send) {
-        count_to_send = _blockcount;
-    }
-    uint32_t oldest = now - 100; // 100 milliseconds before resend.  Hmm.
-    while (count_to_send-- > 0) {
-        for (struct dm_block *block=_blocks_sent.oldest; block != NULL; block=block->next) {
-            // only want to send blocks every now-and-then:
-            if (block->last_sent < oldest) {
-                if (! send_log_block(*block)) {
-                    // failed to send the block; try again later....
-                    return;
-                }
-                stats.resends++;
-            }
+    bool lost = false;
+    for (uint32_t seqno=_seq_base; seqno != _next_seq_to_send; seqno++) {
+        struct dm_block &block = _blocks[seqno % _blockcount];
+        if (block.state != BLOCK_STATE_SENT ||
+            now - block.last_sent < _rto_ms) {
+            continue;
         }
+        if (! send_log_block(block)) {
+            // failed to send the block; try again later....
+            break;
+        }
+        stats.resends++;
+        lost = true;
+    }
+    if (lost) {
+        congestion_loss(now);
+        _rto_ms = MIN(_rto_ms * 2, 2000);
     }
 }
 
@@ -560,6 +617,9 @@ bool DataFlash_MAVLink::send_log_block(struct dm_block &block)
 #endif
 
     block.last_sent = AP_HAL::millis();
+    if (block.send_count < UINT8_MAX) {
+        block.send_count++;
+    }
     chan_status->current_tx_seq = saved_seq;
 
     // _last_send_time is set even if we fail to send the packet; if
@@ -28,8 +28,7 @@ public:
     // constructor
     DataFlash_MAVLink(DataFlash_Class &front, DFMessageWriter_DFLogStart *writer) :
         DataFlash_Backend(front, writer),
-        _max_blocks_per_send_blocks(8),
-        _blockcount(32) // this may get reduced in Init if allocation fails
+        _blockcount(32) // this is set from LOG_MAV_BUFSIZE in Init, and may get reduced if allocation fails
         ,_perf_packing(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DM_packing"))
         { }
 
@@ -66,18 +65,19 @@ public:
     void ShowDeviceInfo(AP_HAL::BetterStream *port) override {}
     void ListAvailableLogs(AP_HAL::BetterStream *port) override {}
 
-    // enum dm_block_state {
-    //     BLOCK_STATE_FREE = 17,
-    //     BLOCK_STATE_FILLING,
-    //     BLOCK_STATE_SEND_PENDING,
-    //     BLOCK_STATE_SEND_RETRY,
-    //     BLOCK_STATE_SENT
-    // };
+    enum dm_block_state {
+        BLOCK_STATE_FREE = 0,
+        BLOCK_STATE_FILLING,
+        BLOCK_STATE_SEND_PENDING,
+        BLOCK_STATE_SEND_RETRY,
+        BLOCK_STATE_SENT
+    };
     struct dm_block {
         uint32_t seqno;
-        uint8_t buf[MAVLINK_MSG_REMOTE_LOG_DATA_BLOCK_FIELD_DATA_LEN];
         uint32_t last_sent;
-        struct dm_block *next;
+        uint8_t state;
+        uint8_t send_count;
+        uint8_t buf[MAVLINK_MSG_REMOTE_LOG_DATA_BLOCK_FIELD_DATA_LEN];
     };
     void push_log_blocks();
     virtual bool send_log_block(struct dm_block &block);
@@ -88,43 +88,34 @@ public:
     virtual void remote_log_block_status_msg(mavlink_channel_t chan, mavlink_message_t* msg) override;
     void free_all_blocks();
 
-    // a stack for free blocks, queues for pending, sent, retries and sent
-    struct dm_block_queue {
-        uint32_t sent_count;
-        struct dm_block *oldest;
-        struct dm_block *youngest;
-    };
-    typedef struct dm_block_queue dm_block_queue_t ;
-    void enqueue_block(dm_block_queue_t &queue, struct dm_block *block);
-    bool queue_has_block(dm_block_queue_t &queue, struct dm_block *block);
-    struct dm_block *dequeue_seqno(dm_block_queue_t &queue, uint32_t seqno);
-    bool free_seqno_from_queue(uint32_t seqno, dm_block_queue_t &queue);
-    bool send_log_blocks_from_queue(dm_block_queue_t &queue);
-    uint8_t stack_size(struct dm_block *stack);
-    uint8_t queue_size(dm_block_queue_t queue);
-    
-    struct dm_block *_blocks_free;
-    dm_block_queue_t _blocks_sent;
-    dm_block_queue_t _blocks_pending;
-    dm_block_queue_t _blocks_retry;
+    /*
+      blocks form a selective-repeat window indexed by sequence
+      number: block seqno lives in slot seqno % _blockcount, so ACKs
+      and NACKs find their block directly.  All blocks before
+      _seq_base have been acked; blocks from _seq_base up to
+      _next_seq_num are in use
+     */
+    struct dm_block *block_for_seqno(uint32_t seqno);
+    uint16_t blocks_free() const { return _blockcount - (_next_seq_num - _seq_base); }
 
 protected:
     struct _stats {
         // the following are reset any time we log stats (see "reset_stats")
         uint32_t resends;
+        uint32_t retries;
         uint8_t collection_count;
-        uint16_t state_free; // cumulative across collection period
-        uint8_t state_free_min;
-        uint8_t state_free_max;
-        uint16_t state_pending; // cumulative across collection period
-        uint8_t state_pending_min;
-        uint8_t state_pending_max;
-        uint16_t state_retry; // cumulative across collection period
-        uint8_t state_retry_min;
-        uint8_t state_retry_max;
-        uint16_t state_sent; // cumulative across collection period
-        uint8_t state_sent_min;
-        uint8_t state_sent_max;
+        uint32_t state_free; // cumulative across collection period
+        uint16_t state_free_min;
+        uint16_t state_free_max;
+        uint32_t state_pending; // cumulative across collection period
+        uint16_t state_pending_min;
+        uint16_t state_pending_max;
+        uint32_t state_retry; // cumulative across collection period
+        uint16_t state_retry_min;
+        uint16_t state_retry_max;
+        uint32_t state_sent; // cumulative across collection period
+        uint16_t state_sent_min;
+        uint16_t state_sent_max;
     } stats;
 
 private:
@@ -134,22 +125,14 @@ private:
 
     bool _initialised;
 
-    // this controls the maximum number of blocks we will push from
-    // the pending and send queues in any call to push_log_blocks.
-    // push_log_blocks is called by periodic_tasks.  Each block is 200
-    // bytes.  In Plane, at 50Hz, a _max_blocks_per_send_blocks of 2
-    // means we will push at most 2*50*200 == 20KB of logs per second
-    // _max_blocks_per_send_blocks has to be high enough to push all
-    // of the logs, but low enough that we don't spend way too much
-    // time packing messages in any one loop
-    const uint8_t _max_blocks_per_send_blocks;
-    
+    // sequence numbers of the selective-repeat window
+    uint32_t _seq_base;         // oldest block not yet acked
+    uint32_t _next_seq_to_send; // oldest block never sent
     uint32_t _next_seq_num;
     uint16_t _latest_block_len;
     bool _logging_started;
     uint32_t _last_response_time;
     uint32_t _last_send_time;
-    uint8_t _next_block_number_to_resend;
     bool _sending_to_client;
 
     void Log_Write_DF_MAV(DataFlash_MAVLink &df);
@@ -158,12 +141,40 @@ private:
     uint16_t bufferspace_available() override; // in bytes
     uint8_t remaining_space_in_current_block();
     // write buffer
-    uint8_t _blockcount_free;
-    uint8_t _blockcount;
+    uint16_t _blockcount;
     struct dm_block *_blocks;
     struct dm_block *_current_block;
     struct dm_block *next_block();
 
+    // number of blocks in each state other than free and filling
+    uint16_t _count_pending;
+    uint16_t _count_sent;
+    uint16_t _count_retry;
+
+    // NACKed blocks in the order they are to be resent
+    uint32_t *_retry_queue;
+    uint16_t _retry_head;
+    uint16_t _retry_len;
+    void retry_push(uint32_t seqno);
+
+    /*
+      congestion control. _cwnd limits the number of blocks in flight;
+      it grows by one block per acked block until _ssthresh and by one
+      block per window after that, and halves when a block is lost.
+      The resend timeout follows the smoothed round trip time of acked
+      blocks
+     */
+    float _cwnd;
+    float _ssthresh;
+    float _srtt_ms;
+    float _rttvar_ms;
+    uint16_t _rto_ms;
+    uint32_t _last_loss_ms;
+    void rtt_update(uint32_t sample_ms);
+    void congestion_ack();
+    void congestion_loss(uint32_t now);
+    bool window_open() const { return _count_sent < (uint16_t)_cwnd; }
+
     void periodic_10Hz(uint32_t now);
     void periodic_1Hz(uint32_t now);
     void periodic_fullrate(uint32_t now);
@@ -44,6 +44,7 @@ void DataFlash_Class::Init(const struct LogStructure *structures, uint8_t num_ty
         if (backends[_next_backend] == NULL) {
             hal.console->printf("Unable to open DataFlash_File");
         } else {
+            backends[_next_backend]->set_rate_limit(_params.file_rate_max, _params.file_rate_classes);
             _next_backend++;
         }
     }
@@ -65,6 +66,7 @@ void DataFlash_Class::Init(const struct LogStructure *structures, uint8_t num_ty
         if (backends[_next_backend] == NULL) {
             hal.console->printf("Unable to open DataFlash_MAVLink");
         } else {
+            backends[_next_backend]->set_rate_limit(_params.mav_rate_max, _params.mav_rate_classes);
             _next_backend++;
         }
     }
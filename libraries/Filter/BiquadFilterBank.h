@@ -0,0 +1,171 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BIQUADFILTERBANK_H
+#define BIQUADFILTERBANK_H
+
+#include <AP_Math/AP_Math.h>
+#include <math.h>
+#include <string.h>
+#include <inttypes.h>
+
+/// @file   BiquadFilterBank.h
+/// @brief  A bank of cascaded biquad filters stored as structure of arrays
+///
+/// The bank holds GROUPS groups of BIQUAD_BANK_LANES channels, each
+/// filtered by SECTIONS biquad sections in series. A group is typically
+/// the three axes of one sensor instance, padded to four lanes, so one
+/// pass of the kernel filters all axes with the same vector operations
+/// and apply_all() filters every group at once. Every section of every
+/// lane has its own coefficients, and unused sections pass samples
+/// through, so the cost per sample does not depend on the filter setup.
+///
+/// The sections use the same direct form II as DigitalBiquadFilter, so
+/// a single low pass section gives the same output as LowPassFilter2p.
+
+#define BIQUAD_BANK_LANES 4
+
+template <uint8_t GROUPS, uint8_t SECTIONS>
+class BiquadFilterBank {
+public:
+    static const uint16_t CHANNELS = GROUPS * BIQUAD_BANK_LANES;
+
+    BiquadFilterBank() {
+        for (uint8_t s = 0; s < SECTIONS; s++) {
+            for (uint8_t g = 0; g < GROUPS; g++) {
+                set_passthrough(g, s);
+            }
+        }
+        memset(_z1, 0, sizeof(_z1));
+        memset(_z2, 0, sizeof(_z2));
+    }
+
+    // a section which leaves the samples unchanged
+    void set_passthrough(uint8_t group, uint8_t section) {
+        _set_coefficients(group, section, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    // second order Butterworth low pass, as LowPassFilter2p. A zero
+    // cutoff or sample rate gives a passthrough section
+    void set_lowpass(uint8_t group, uint8_t section, float sample_freq, float cutoff_freq) {
+        if (is_zero(cutoff_freq) || is_zero(sample_freq)) {
+            set_passthrough(group, section);
+            return;
+        }
+        float fr = sample_freq/cutoff_freq;
+        float ohm = tanf(PI/fr);
+        float c = 1.0f+2.0f*cosf(PI/4.0f)*ohm + ohm*ohm;
+        float b0 = ohm*ohm/c;
+        _set_coefficients(group, section,
+                          b0, 2.0f*b0, b0,
+                          2.0f*(ohm*ohm-1.0f)/c,
+                          (1.0f-2.0f*cosf(PI/4.0f)*ohm+ohm*ohm)/c);
+    }
+
+    // notch at center_freq, bandwidth_hz wide at -3dB. A zero center
+    // frequency, or one at or above Nyquist, gives a passthrough section
+    void set_notch(uint8_t group, uint8_t section, float sample_freq, float center_freq, float bandwidth_hz) {
+        if (is_zero(center_freq) || is_zero(sample_freq) ||
+            center_freq >= 0.5f * sample_freq || bandwidth_hz <= 0) {
+            set_passthrough(group, section);
+            return;
+        }
+        float omega = 2.0f * PI * center_freq / sample_freq;
+        // Q = center / bandwidth
+        float alpha = sinf(omega) * bandwidth_hz / (2.0f * center_freq);
+        float a0 = 1.0f + alpha;
+        float cosw = cosf(omega);
+        _set_coefficients(group, section,
+                          1.0f / a0, -2.0f * cosw / a0, 1.0f / a0,
+                          -2.0f * cosw / a0, (1.0f - alpha) / a0);
+    }
+
+    // clear the state of a group
+    void reset(uint8_t group) {
+        const uint16_t ofs = group * BIQUAD_BANK_LANES;
+        for (uint8_t s = 0; s < SECTIONS; s++) {
+            for (uint8_t i = 0; i < BIQUAD_BANK_LANES; i++) {
+                _z1[s][ofs+i] = 0;
+                _z2[s][ofs+i] = 0;
+            }
+        }
+    }
+
+    // filter one sample for each lane of a group, in place
+    void apply(uint8_t group, float v[BIQUAD_BANK_LANES]) {
+        _kernel(group * BIQUAD_BANK_LANES, BIQUAD_BANK_LANES, v);
+    }
+
+    // filter one sample for every channel of the bank, in place
+    void apply_all(float v[CHANNELS]) {
+        _kernel(0, CHANNELS, v);
+    }
+
+    // filter the three axes of a vector through lanes 0 to 2 of a group
+    Vector3f apply(uint8_t group, const Vector3f &sample) {
+        float v[BIQUAD_BANK_LANES] = { sample.x, sample.y, sample.z, 0 };
+        apply(group, v);
+        return Vector3f(v[0], v[1], v[2]);
+    }
+
+private:
+    void _set_coefficients(uint8_t group, uint8_t section,
+                           float b0, float b1, float b2, float a1, float a2) {
+        const uint16_t ofs = group * BIQUAD_BANK_LANES;
+        for (uint8_t i = 0; i < BIQUAD_BANK_LANES; i++) {
+            _b0[section][ofs+i] = b0;
+            _b1[section][ofs+i] = b1;
+            _b2[section][ofs+i] = b2;
+            _a1[section][ofs+i] = a1;
+            _a2[section][ofs+i] = a2;
+        }
+    }
+
+    /*
+      run count channels from ofs through every section. The lanes
+      are independent and contiguous, so the compiler turns the inner
+      loop into vector operations
+     */
+    void _kernel(uint16_t ofs, uint16_t count, float *__restrict v) {
+        for (uint8_t s = 0; s < SECTIONS; s++) {
+            const float *__restrict b0 = &_b0[s][ofs];
+            const float *__restrict b1 = &_b1[s][ofs];
+            const float *__restrict b2 = &_b2[s][ofs];
+            const float *__restrict a1 = &_a1[s][ofs];
+            const float *__restrict a2 = &_a2[s][ofs];
+            float *__restrict z1 = &_z1[s][ofs];
+            float *__restrict z2 = &_z2[s][ofs];
+            for (uint16_t i = 0; i < count; i++) {
+                float w0 = v[i] - z1[i] * a1[i] - z2[i] * a2[i];
+                v[i] = w0 * b0[i] + z1[i] * b1[i] + z2[i] * b2[i];
+                z2[i] = z1[i];
+                z1[i] = w0;
+            }
+        }
+    }
+
+    // coefficients and state, [section][group * BIQUAD_BANK_LANES + lane]
+    float _b0[SECTIONS][CHANNELS] __attribute__((aligned(16)));
+    float _b1[SECTIONS][CHANNELS] __attribute__((aligned(16)));
+    float _b2[SECTIONS][CHANNELS] __attribute__((aligned(16)));
+    float _a1[SECTIONS][CHANNELS] __attribute__((aligned(16)));
+    float _a2[SECTIONS][CHANNELS] __attribute__((aligned(16)));
+    float _z1[SECTIONS][CHANNELS] __attribute__((aligned(16)));
+    float _z2[SECTIONS][CHANNELS] __attribute__((aligned(16)));
+};
+
+#endif // BIQUADFILTERBANK_H
@@ -23,6 +23,10 @@
 #define CHECK_PAYLOAD_SIZE(id) if (comm_get_txspace(chan) < MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_ ## id ## _LEN) return false
 #define CHECK_PAYLOAD_SIZE2(id) if (!HAVE_PAYLOAD_SPACE(chan, id)) return false
 
+// maximum number of mission items requested ahead of the lowest missing item during an upload.
+// Limited to 32 by waypoint_received_mask
+#define MISSION_UPLOAD_WINDOW_MAX 32
+
 //  GCS Message ID's
 /// NOTE: to ensure we never block on sending MAVLink messages
 /// please keep each MSG_ to a single MAVLink message. If need be
@@ -219,8 +223,12 @@ private:
     uint8_t        crlf_count;
 
     // waypoints
-    uint16_t        waypoint_request_i; // request index
+    uint16_t        waypoint_request_i; // request index, lowest item not yet received
     uint16_t        waypoint_request_last; // last request index
+    uint16_t        waypoint_request_next; // next item that has not yet been requested
+    uint32_t        waypoint_received_mask; // items received ahead of waypoint_request_i, bit 0 is waypoint_request_i
+    uint8_t         waypoint_window; // number of items that may be requested ahead of waypoint_request_i
+    bool            waypoint_window_disabled; // a request timed out during this upload, so ask for one item at a time
     uint16_t        waypoint_dest_sysid; // where to send requests
     uint16_t        waypoint_dest_compid; // "
     bool            waypoint_receiving; // currently receiving
@@ -306,6 +314,7 @@ private:
     void handle_mission_clear_all(AP_Mission &mission, mavlink_message_t *msg);
     void handle_mission_write_partial_list(AP_Mission &mission, mavlink_message_t *msg);
     bool handle_mission_item(mavlink_message_t *msg, AP_Mission &mission);
+    void mission_upload_start(uint16_t start_index, uint16_t last_index);
 
     void handle_request_data_stream(mavlink_message_t *msg, bool save);
     void handle_param_request_list(mavlink_message_t *msg);
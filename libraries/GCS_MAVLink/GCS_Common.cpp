@@ -158,20 +158,38 @@ GCS_MAVLINK::queued_param_send()
 }
 
 /**
- * @brief Send the next pending waypoint, called from deferred message
+ * @brief Send the pending waypoint requests, called from deferred message
  * handling code
+ *
+ * Up to waypoint_window items beyond the lowest missing item are requested
+ * at once, so a ground station that answers each MISSION_REQUEST as it
+ * arrives streams items back without waiting a round trip per item. A
+ * ground station that ignores all but the lowest request gets one
+ * request at a time once it has left a windowed request unanswered
  */
 void
 GCS_MAVLINK::queued_waypoint_send()
 {
-    if (initialised &&
-        waypoint_receiving &&
-        waypoint_request_i <= waypoint_request_last) {
+    if (!initialised || !waypoint_receiving) {
+        return;
+    }
+
+    uint16_t window_end = MIN(waypoint_request_i + waypoint_window, waypoint_request_last);
+    if (waypoint_request_next < waypoint_request_i) {
+        waypoint_request_next = waypoint_request_i;
+    }
+    while (waypoint_request_next < window_end &&
+           HAVE_PAYLOAD_SPACE(chan, MISSION_REQUEST)) {
+        uint16_t seq = waypoint_request_next++;
+        // don't ask again for items that arrived ahead of the lowest missing item
+        if (waypoint_received_mask & (1UL << (seq - waypoint_request_i))) {
+            continue;
+        }
         mavlink_msg_mission_request_send(
             chan,
             waypoint_dest_sysid,
             waypoint_dest_compid,
-            waypoint_request_i);
+            seq);
     }
 }
 
@@ -337,12 +355,31 @@ void GCS_MAVLINK::handle_mission_count(AP_Mission &mission, mavlink_message_t *m
     // new mission arriving, truncate mission to be the same length
     mission.truncate(packet.count);
 
-    // set variables to help handle the expected receiving of commands from the GCS
+    // record system id of GCS who is sending the commands
+    waypoint_dest_sysid = msg->sysid;
+    waypoint_dest_compid = msg->compid;
+
+    // expect commands 0 to count-1
+    mission_upload_start(0, packet.count);
+}
+
+/*
+  setup the waypoint receiving state machine for an upload of items start_index to last_index-1
+ */
+void GCS_MAVLINK::mission_upload_start(uint16_t start_index, uint16_t last_index)
+{
     waypoint_timelast_receive = AP_HAL::millis();    // set time we last received commands to now
     waypoint_receiving = true;              // record that we expect to receive commands
-    waypoint_request_i = 0;                 // reset the next expected command number to zero
-    waypoint_request_last = packet.count;   // record how many commands we expect to receive
+    waypoint_request_i = start_index;       // reset the next expected command number
+    waypoint_request_last = last_index;     // record how many commands we expect to receive
     waypoint_timelast_request = 0;          // set time we last requested commands to zero
+    waypoint_request_next = start_index;    // nothing has been requested yet
+    waypoint_received_mask = 0;
+    // start by asking for two items at once. The window only grows if the
+    // GCS answers both, and a GCS that only answers the lowest request
+    // costs one retry before this upload drops to one item per round trip
+    waypoint_window = 2;
+    waypoint_window_disabled = false;
 }
 
 /*
@@ -381,11 +418,11 @@ void GCS_MAVLINK::handle_mission_write_partial_list(AP_Mission &mission, mavlink
         return;
     }
 
-    waypoint_timelast_receive = AP_HAL::millis();
-    waypoint_timelast_request = 0;
-    waypoint_receiving   = true;
-    waypoint_request_i   = packet.start_index;
-    waypoint_request_last= packet.end_index;
+    waypoint_dest_sysid = msg->sysid;
+    waypoint_dest_compid = msg->compid;
+    // items start_index to end_index-1 are sent, or just start_index
+    // when the two are equal
+    mission_upload_start(packet.start_index, MAX(packet.end_index, packet.start_index+1));
 }
 
 
@@ -680,39 +717,54 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
         goto mission_ack;
     }
 
-    // check if this is the requested waypoint
-    if (packet.seq != waypoint_request_i) {
+    // a repeat of an item we already have is answered by the next request, not a NAK,
+    // as it is expected when a request is retried while the item was in flight
+    if (packet.seq < waypoint_request_i ||
+        (packet.seq < waypoint_request_i + MISSION_UPLOAD_WINDOW_MAX &&
+         (waypoint_received_mask & (1UL << (packet.seq - waypoint_request_i))))) {
+        waypoint_timelast_receive = AP_HAL::millis();
+        return false;
+    }
+
+    // accept any item that fits in the window, not just those requested
+    // since the last retry, as the GCS may still have earlier requests in flight
+    if (packet.seq >= waypoint_request_i + MISSION_UPLOAD_WINDOW_MAX ||
+        packet.seq >= waypoint_request_last) {
         result = MAV_MISSION_INVALID_SEQUENCE;
         goto mission_ack;
     }
-    
-    // if command index is within the existing list, replace the command
-    if (packet.seq < mission.num_commands()) {
-        if (mission.replace_cmd(packet.seq,cmd)) {
-            result = MAV_MISSION_ACCEPTED;
-        }else{
-            result = MAV_MISSION_ERROR;
-            goto mission_ack;
-        }
-        // if command is at the end of command list, add the command
-    } else if (packet.seq == mission.num_commands()) {
-        if (mission.add_cmd(cmd)) {
-            result = MAV_MISSION_ACCEPTED;
-        }else{
-            result = MAV_MISSION_ERROR;
-            goto mission_ack;
-        }
-        // if beyond the end of the command list, return an error
-    } else {
+
+    // write the command straight to its place in storage.  Items may arrive
+    // out of order, so the mission length is only updated once all items
+    // have been received
+    if (!mission.write_cmd_to_storage(packet.seq, cmd)) {
         result = MAV_MISSION_ERROR;
         goto mission_ack;
     }
     
     // update waypoint receiving state machine
     waypoint_timelast_receive = AP_HAL::millis();
-    waypoint_request_i++;
+    waypoint_received_mask |= (1UL << (packet.seq - waypoint_request_i));
+    while (waypoint_received_mask & 1) {
+        waypoint_received_mask >>= 1;
+        waypoint_request_i++;
+        // the GCS answered everything we asked for so ask for more at once next time
+        if (waypoint_request_i >= waypoint_request_next &&
+            !waypoint_window_disabled &&
+            waypoint_window < MISSION_UPLOAD_WINDOW_MAX) {
+            waypoint_window *= 2;
+        }
+    }
     
     if (waypoint_request_i >= waypoint_request_last) {
+        // extend the mission to include the new commands
+        if (waypoint_request_last > mission.num_commands() &&
+            !mission.set_num_commands(waypoint_request_last)) {
+            waypoint_receiving = false;
+            result = MAV_MISSION_ERROR;
+            goto mission_ack;
+        }
+
         mavlink_msg_mission_ack_send_buf(
             msg,
             chan,
@@ -727,9 +779,8 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
         // only set WP_RADIUS parameter
     } else {
         waypoint_timelast_request = AP_HAL::millis();
-        // if we have enough space, then send the next WP immediately
-        if (comm_get_txspace(chan) >= 
-            MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_MISSION_ITEM_LEN) {
+        // if we have enough space, then send the next WP requests immediately
+        if (HAVE_PAYLOAD_SPACE(chan, MISSION_REQUEST)) {
             queued_waypoint_send();
         } else {
             send_message(MSG_NEXT_WAYPOINT);
@@ -866,7 +917,16 @@ GCS_MAVLINK::update(run_cli_fn run_cli)
     if (waypoint_receiving &&
         waypoint_request_i <= waypoint_request_last &&
         tnow - waypoint_timelast_request > wp_recv_time) {
+        if (waypoint_timelast_request != 0 && waypoint_window > 1) {
+            // requests ahead of the lowest went unanswered. Rather than
+            // growing the window again and retrying every other item,
+            // ask for one item at a time for the rest of this upload
+            waypoint_window = 1;
+            waypoint_window_disabled = true;
+        }
         waypoint_timelast_request = tnow;
+        // ask again for all missing items in the window
+        waypoint_request_next = waypoint_request_i;
         send_message(MSG_NEXT_WAYPOINT);
     }
 
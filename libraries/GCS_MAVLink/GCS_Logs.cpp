@@ -151,21 +151,27 @@ void GCS_MAVLINK::handle_log_send(DataFlash_Class &dataflash)
     if (!_log_sending) {
         return;
     }
+    /*
+      on fast links the number of packets per call is limited only by
+      the space in the transmit buffer, which handle_log_send_data()
+      checks. The log data is read ahead on the IO thread, so a call
+      that finds no data ready stops early and the next call resumes
+     */
     uint8_t num_sends = 1;
     if (chan == MAVLINK_COMM_0 && hal.gpio->usb_connected()) {
         // when on USB we can send a lot more data
-        num_sends = 40;
+        num_sends = 255;
     } else if (have_flow_control()) {
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
-        num_sends = 80;
+        num_sends = 255;
 #else
-        num_sends = 10;
+        num_sends = 20;
 #endif
     }
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     // assume USB speeds in SITL for the purposes of log download
-    num_sends = 40;
+    num_sends = 255;
 #endif
 
     for (uint8_t i=0; i<num_sends; i++) {
@@ -228,6 +234,10 @@ bool GCS_MAVLINK::handle_log_send_data(DataFlash_Class &dataflash)
         len = 90;
     }
     ret = dataflash.get_log_data(_log_num_data, _log_data_page, _log_data_offset, len, packet.data);
+    if (ret == DATAFLASH_LOG_DATA_PENDING) {
+        // still being read from storage, try again on the next call
+        return false;
+    }
     if (ret < 0) {
         // report as EOF on error
         ret = 0;
@@ -34,6 +34,7 @@ extern const AP_HAL::HAL& hal;
   layout for fixed wing and rovers
   On PX4v1 this gives 309 waypoints, 30 rally points and 52 fence points
   On Pixhawk this gives 724 waypoints, 50 rally points and 84 fence points
+  With 32k of storage this gives 1634 waypoints, 70 rally points and 212 fence points
  */
 const StorageManager::StorageArea StorageManager::layout_default[STORAGE_NUM_AREAS] = {
     { StorageParam,   0,     1280}, // 0x500 parameter bytes
@@ -53,6 +54,12 @@ const StorageManager::StorageArea StorageManager::layout_default[STORAGE_NUM_ARE
     { StorageFence,    9772,   256},
     { StorageMission, 10028,  6228}, // leave 128 byte gap for expansion
 #endif
+#if STORAGE_NUM_AREAS >= 16
+    { StorageParam,   16384,  1280},
+    { StorageRally,   17664,   300},
+    { StorageFence,   17964,  1024},
+    { StorageMission, 18988, 13652}, // leave 128 byte gap for expansion
+#endif
 };
 
 
@@ -60,6 +67,7 @@ const StorageManager::StorageArea StorageManager::layout_default[STORAGE_NUM_ARE
   layout for copter.
   On PX4v1 this gives 303 waypoints, 26 rally points and 38 fence points
   On Pixhawk this gives 718 waypoints, 46 rally points and 70 fence points
+  With 32k of storage this gives 1628 waypoints, 66 rally points and 198 fence points
  */
 const StorageManager::StorageArea StorageManager::layout_copter[STORAGE_NUM_AREAS] = {
     { StorageParam,   0,     1536}, // 0x600 param bytes
@@ -79,6 +87,12 @@ const StorageManager::StorageArea StorageManager::layout_copter[STORAGE_NUM_AREA
     { StorageFence,    9772,   256},
     { StorageMission, 10028,  6228}, // leave 128 byte gap for expansion
 #endif
+#if STORAGE_NUM_AREAS >= 16
+    { StorageParam,   16384,  1280},
+    { StorageRally,   17664,   300},
+    { StorageFence,   17964,  1024},
+    { StorageMission, 18988, 13652}, // leave 128 byte gap for expansion
+#endif
 };
 
 // setup default layout